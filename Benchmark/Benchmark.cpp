@@ -0,0 +1,462 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ModelLoader.h"
+#include "JobSystem.h"
+#include "Culling.h"
+#include "FrameArena.h"
+#include "NullGL.h"
+#include "SyntheticScene.h"
+#include "StaticBatch.h"
+#include "AssetIO.h"
+#include "VirtualTexture.h"
+#include "LodScene.h"
+#include "MeshRegistry.h"
+
+// mikrobenchmarki CPU: import, budowa drzewa, przejscie drawNode (NullGL), macierze, culling, tekstury;
+// kazdy wynik to repetitions powtorzen po tyle iteracji, zeby powtorzenie trwalo >= minRepetitionMs
+struct BenchConfig {
+    SyntheticSceneConfig scene;
+    size_t sphereCount = 100000;
+    unsigned int repetitions = 20;
+    double minRepetitionMs = 10.0;
+    unsigned int threads = 0;
+    std::string filter;
+    std::string format = "json";
+    std::string outPath;
+    std::string objPath = "bench_scene.obj";
+    std::string glbPath = "bench_scene.glb";
+    std::string packPath = "bench_assets.pak";
+    std::string virtualTexturePath = "bench_ground.vt";
+    std::string lodScenePath = "bench_city.lod";
+};
+
+struct BenchResult {
+    std::string name;
+    std::string params;
+    uint64_t iterations;
+    uint64_t items;
+    std::vector<double> samples;  // ns na iteracje, po jednej probce na powtorzenie
+    double mean, median, stddev, minimum, maximum, mad, ci95;
+};
+
+static volatile uint64_t benchSink;
+
+// wartosc krytyczna t-Studenta (dwustronnie, 95%) dla df = 1..30, dalej ~ rozklad normalny
+static double studentT95(size_t df) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (df == 0)
+        return 0.0;
+    return df <= 30 ? table[df - 1] : 1.96;
+}
+
+static double medianOf(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+static void computeStats(BenchResult& result) {
+    const std::vector<double>& s = result.samples;
+    double sum = 0.0;
+    for (double v : s)
+        sum += v;
+    result.mean = sum / s.size();
+    double squares = 0.0;
+    for (double v : s)
+        squares += (v - result.mean) * (v - result.mean);
+    result.stddev = s.size() > 1 ? std::sqrt(squares / (s.size() - 1)) : 0.0;
+    result.median = medianOf(s);
+    result.minimum = *std::min_element(s.begin(), s.end());
+    result.maximum = *std::max_element(s.begin(), s.end());
+    std::vector<double> deviations;
+    for (double v : s)
+        deviations.push_back(std::fabs(v - result.median));
+    result.mad = medianOf(deviations);
+    result.ci95 = studentT95(s.size() - 1) * result.stddev / std::sqrt((double)s.size());
+}
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchResult runBenchmark(const BenchConfig& config, const std::string& name, const std::string& params,
+    uint64_t items, const std::function<void()>& body) {
+    BenchResult result;
+    result.name = name;
+    result.params = params;
+    result.items = items;
+
+    // rozgrzewka + kalibracja liczby iteracji
+    body();
+    uint64_t iterations = 1;
+    for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            body();
+        double ns = elapsedNs(start);
+        if (ns >= config.minRepetitionMs * 1e6 || iterations >= (1ULL << 30))
+            break;
+        iterations *= ns > 0.0 ? std::max<uint64_t>(2, std::min<uint64_t>(100, (uint64_t)(config.minRepetitionMs * 1e6 / ns) + 1)) : 100;
+    }
+    result.iterations = iterations;
+
+    for (unsigned int r = 0; r < config.repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            body();
+        result.samples.push_back(elapsedNs(start) / iterations);
+    }
+    computeStats(result);
+    return result;
+}
+
+static std::string sceneParams(const BenchConfig& config) {
+    std::ostringstream text;
+    text << "drones=" << config.scene.drones << ";depth=" << config.scene.depth << ";branching=" << config.scene.branching
+        << ";meshes_per_node=" << config.scene.meshesPerNode << ";nodes=" << stressNodeCount(stressConfigFor(config.scene));
+    return text.str();
+}
+
+static void writeResult(std::ostream& out, const BenchConfig& config, const BenchResult& r, bool first) {
+    double perItem = r.items ? r.median / r.items : 0.0;
+    if (config.format == "csv") {
+        if (first)
+            out << "benchmark,params,iterations,repetitions,items,mean_ns,median_ns,stddev_ns,min_ns,max_ns,mad_ns,ci95_ns,median_ns_per_item\n";
+        out << r.name << ',' << r.params << ',' << r.iterations << ',' << r.samples.size() << ',' << r.items << ','
+            << r.mean << ',' << r.median << ',' << r.stddev << ',' << r.minimum << ',' << r.maximum << ','
+            << r.mad << ',' << r.ci95 << ',' << perItem << '\n';
+        return;
+    }
+    // JSON Lines - jeden obiekt na wynik, latwe do doklejania w historii
+    out << "{\"benchmark\":\"" << r.name << "\",\"params\":\"" << r.params << "\",\"timestamp\":" << (long long)std::time(nullptr)
+        << ",\"threads\":" << jobThreadCount() << ",\"iterations\":" << r.iterations << ",\"repetitions\":" << r.samples.size()
+        << ",\"items\":" << r.items << ",\"unit\":\"ns\",\"mean\":" << r.mean << ",\"median\":" << r.median
+        << ",\"stddev\":" << r.stddev << ",\"min\":" << r.minimum << ",\"max\":" << r.maximum << ",\"mad\":" << r.mad
+        << ",\"ci95\":" << r.ci95 << ",\"median_per_item\":" << perItem << "}\n";
+}
+
+static bool parseArguments(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "ERROR::BENCHMARK::MISSING_VALUE " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--drones") == 0) config.scene.drones = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--depth") == 0) config.scene.depth = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--branching") == 0) config.scene.branching = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--meshes-per-node") == 0) config.scene.meshesPerNode = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--meshes") == 0) config.scene.meshCount = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--triangles") == 0) config.scene.trianglesPerMesh = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--seed") == 0) config.scene.seed = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(arg, "--spheres") == 0) config.sphereCount = (size_t)std::atoll(value);
+        else if (std::strcmp(arg, "--reps") == 0) config.repetitions = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--min-time-ms") == 0) config.minRepetitionMs = std::atof(value);
+        else if (std::strcmp(arg, "--threads") == 0) config.threads = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--filter") == 0) config.filter = value;
+        else if (std::strcmp(arg, "--format") == 0) config.format = value;
+        else if (std::strcmp(arg, "--out") == 0) config.outPath = value;
+        else if (std::strcmp(arg, "--obj") == 0) config.objPath = value;
+        else if (std::strcmp(arg, "--glb") == 0) config.glbPath = value;
+        else if (std::strcmp(arg, "--pack") == 0) config.packPath = value;
+        else if (std::strcmp(arg, "--vt") == 0) config.virtualTexturePath = value;
+        else if (std::strcmp(arg, "--lod") == 0) config.lodScenePath = value;
+        else {
+            std::cerr << "ERROR::BENCHMARK::UNKNOWN_OPTION " << arg << std::endl;
+            return false;
+        }
+    }
+    if (config.scene.depth == 0 || config.scene.branching == 0 || config.scene.meshCount == 0 || config.repetitions == 0) {
+        std::cerr << "ERROR::BENCHMARK::INVALID_SCENE" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parseArguments(argc, argv, config))
+        return 1;
+
+    initJobSystem(config.threads);
+    loadNullGL();
+
+    std::ofstream file;
+    if (!config.outPath.empty()) {
+        file.open(config.outPath, std::ios::app);
+        if (!file) {
+            std::cerr << "ERROR::BENCHMARK::CANNOT_OPEN " << config.outPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = config.outPath.empty() ? std::cout : file;
+    bool first = true;
+    auto run = [&](const std::string& name, const std::string& params, uint64_t items, const std::function<void()>& body) {
+        if (!config.filter.empty() && name.find(config.filter) == std::string::npos)
+            return;
+        BenchResult result = runBenchmark(config, name, params, items, body);
+        writeResult(out, config, result, first);
+        out.flush();
+        first = false;
+    };
+
+    size_t nodeCount = syntheticNodeCount(config.scene);
+    std::string params = sceneParams(config);
+
+    // loadModel: import Assimp + konwersja + upload (NullGL) z wygenerowanego pliku OBJ
+    if (config.filter.empty() || std::string("loadModel").find(config.filter) != std::string::npos) {
+        meshes.clear();
+        if (!writeSyntheticObj(config.scene, config.objPath)) {
+            std::cerr << "ERROR::BENCHMARK::CANNOT_WRITE " << config.objPath << std::endl;
+        } else if (!loadModel(config.objPath)) {
+            std::cerr << "ERROR::BENCHMARK::IMPORT_FAILED " << config.objPath << std::endl;
+        } else {
+            std::ostringstream objParams;
+            objParams << "meshes=" << config.scene.meshCount << ";triangles=" << config.scene.trianglesPerMesh;
+            run("loadModel", objParams.str(), (uint64_t)config.scene.meshCount * config.scene.trianglesPerMesh, [&]() {
+                meshes.clear();
+                benchSink = loadModel(config.objPath);
+            });
+            // ten sam plik jako wpis zamontowanej paczki (oryginal usuniety - czytany musi byc wpis)
+            if (writeAssetPack(config.packPath, "", std::vector<std::string>(1, config.objPath))
+                && std::remove(config.objPath.c_str()) == 0 && mountAssetPack(config.packPath)) {
+                run("loadModelPacked", objParams.str(), (uint64_t)config.scene.meshCount * config.scene.trianglesPerMesh, [&]() {
+                    meshes.clear();
+                    benchSink = loadModel(config.objPath);
+                });
+                unmountAssetPacks();
+            }
+            std::remove(config.packPath.c_str());
+        }
+        std::remove(config.objPath.c_str());
+    }
+
+    // loadGltf: te same siatki jako .glb przez wlasny loader - z kopia CPU i prosto z mapowania do GL (NullGL)
+    if (config.filter.empty() || std::string("loadGltf").find(config.filter) != std::string::npos) {
+        std::ostringstream glbParams;
+        glbParams << "meshes=" << config.scene.meshCount << ";triangles=" << config.scene.trianglesPerMesh;
+        uint64_t triangles = (uint64_t)config.scene.meshCount * config.scene.trianglesPerMesh;
+        if (!writeSyntheticGlb(config.scene, config.glbPath)) {
+            std::cerr << "ERROR::BENCHMARK::CANNOT_WRITE " << config.glbPath << std::endl;
+        } else {
+            run("loadGltf", glbParams.str(), triangles, [&]() {
+                meshes.clear();
+                benchSink = loadModel(config.glbPath);
+            });
+            run("loadGltfNoCopy", glbParams.str(), triangles, [&]() {
+                meshes.clear();
+                benchSink = loadModel(config.glbPath, false);
+            });
+            if (writeAssetPack(config.packPath, "", std::vector<std::string>(1, config.glbPath))
+                && std::remove(config.glbPath.c_str()) == 0 && mountAssetPack(config.packPath)) {
+                run("loadGltfPacked", glbParams.str(), triangles, [&]() {
+                    meshes.clear();
+                    benchSink = loadModel(config.glbPath);
+                });
+                unmountAssetPacks();
+            }
+            std::remove(config.packPath.c_str());
+        }
+        std::remove(config.glbPath.c_str());
+    }
+
+    aiNode* aiRoot = buildSyntheticAiNodes(config.scene);
+    // graf uzywany ponownie - po pierwszej iteracji import nie alokuje
+    SceneGraph imported;
+    run("buildSceneGraph", params, nodeCount, [&]() {
+        buildSceneGraph(aiRoot, 0, imported);
+        benchSink = imported.nodes.size();
+    });
+    delete aiRoot;
+
+    SceneGraph graph;
+    StressSceneConfig stressConfig = stressConfigFor(config.scene);
+    generateStressScene(stressConfig, graph);
+    run("drawNode", params, stressNodeCount(stressConfig), [&]() {
+        drawNode(graph, 0, glm::mat4(1.0f), 1);
+        advanceFrameArenas();
+    });
+    glm::mat4 root(1.0f);
+    run("drawNodeInstanced", params, stressNodeCount(stressConfig), [&]() {
+        drawNodeInstanced(graph, 0, &root, 1);
+        advanceFrameArenas();
+    });
+
+    // statyczne paczki: wypiekanie przy starcie, potem przejscie reszty grafu + rysowanie paczek
+    StaticBatchConfig batchConfig;
+    batchConfig.upload = false;
+    SceneGraph residual;
+    StaticBatches batches;
+    run("buildStaticBatches", params, stressNodeCount(stressConfig), [&]() {
+        // kopia z wlasnymi referencjami - wypiekanie oddaje referencje siatek, ktore przejely paczki
+        releaseSceneGraph(residual);
+        residual = graph;
+        retainSceneGraph(residual);
+        buildStaticBatches(residual, batches, batchConfig);
+        benchSink = batches.meshes.size();
+    });
+    glm::mat4 batchViewProjection = glm::perspective(glm::radians(45.0f), 800.f / 600.f, 0.1f, 100.0f)
+        * glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    run("drawStaticBatches", params, stressNodeCount(stressConfig), [&]() {
+        drawNode(residual, 0, glm::mat4(1.0f), 1);
+        drawStaticBatches(batches, glm::mat4(1.0f), batchViewProjection, 1);
+        advanceFrameArenas();
+    });
+
+    // skladanie macierzy w plaskiej hierarchii (rodzic przed dzieckiem)
+    std::vector<int> parents;
+    std::vector<glm::mat4> locals, worlds(nodeCount);
+    buildSyntheticHierarchy(config.scene, parents, locals);
+    run("composeTransforms", params, nodeCount, [&]() {
+        worlds[0] = locals[0];
+        for (size_t i = 1; i < nodeCount; ++i)
+            worlds[i] = worlds[parents[i]] * locals[i];
+        benchSink = (uint64_t)worlds.back()[3][0];
+    });
+
+    std::vector<glm::vec4> spheres;
+    buildSyntheticSpheres(config.sphereCount, 200.0f, config.scene.seed, spheres);
+    std::vector<uint32_t> visible(spheres.size());
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 50.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = extractFrustum(glm::perspective(glm::radians(45.0f), 800.f / 600.f, 0.1f, 100.0f) * view);
+    std::string sphereParams = "spheres=" + std::to_string(spheres.size());
+    run("cullSpheres", sphereParams, spheres.size(), [&]() {
+        benchSink = cullSpheres(frustum, spheres.data(), spheres.size(), visible.data());
+    });
+    run("sphereInFrustum", sphereParams, spheres.size(), [&]() {
+        size_t count = 0;
+        for (const glm::vec4& sphere : spheres)
+            count += sphereInFrustum(frustum, glm::vec3(sphere), sphere.w);
+        benchSink = count;
+    });
+
+    // tekstury: mipy (pudelko SSE2 i Kaiser) i kompresja BC na puli zadan, obraz 1024x1024
+    TextureImage sourceImage, image;
+    buildSyntheticImage(1024, config.scene.seed, sourceImage);
+    std::string imageParams = "size=1024";
+    uint64_t pixels = (uint64_t)1024 * 1024;
+    run("buildMipChainBox", imageParams, pixels, [&]() {
+        image = sourceImage;
+        buildMipChain(image, MIP_FILTER_BOX);
+        benchSink = image.levels.size();
+    });
+    run("buildMipChainKaiser", imageParams, pixels, [&]() {
+        image = sourceImage;
+        buildMipChain(image, MIP_FILTER_KAISER);
+        benchSink = image.levels.size();
+    });
+    run("compressImage", imageParams, pixels, [&]() {
+        image = sourceImage;
+        compressImage(image);
+        benchSink = image.data.size();
+    });
+
+    // wirtualna tekstura: piramida kafli z 2x2 arkuszy TGA 1024x1024 i zbieranie zadan z feedbacku (bez GL)
+    if (config.filter.empty() || std::string("buildVirtualTexture").find(config.filter) != std::string::npos
+        || std::string("collectTileRequests").find(config.filter) != std::string::npos) {
+        std::vector<std::string> sheets;
+        for (uint64_t s = 0; s < 4; ++s) {
+            sheets.push_back(config.virtualTexturePath + ".sheet" + std::to_string(s) + ".tga");
+            if (!writeSyntheticTga(1024, config.scene.seed + s, sheets.back()))
+                std::cerr << "ERROR::BENCHMARK::CANNOT_WRITE " << sheets.back() << std::endl;
+        }
+        VirtualTextureBuildConfig buildConfig;
+        run("buildVirtualTexture", "sheets=2x2;size=1024", pixels * 4, [&]() {
+            benchSink = buildVirtualTexture(config.virtualTexturePath, sheets, 2, buildConfig);
+        });
+        if (!buildVirtualTexture(config.virtualTexturePath, sheets, 2, buildConfig)) {
+            std::cerr << "ERROR::BENCHMARK::CANNOT_WRITE " << config.virtualTexturePath << std::endl;
+        } else {
+            VirtualTexture virtualTexture;
+            if (loadVirtualTextureLayout(virtualTexture, config.virtualTexturePath, VirtualTextureConfig())) {
+                // feedback 100x75 (okno 800x600 / 8) jak ziemia w perspektywie: u gory niebo, dalej coraz grubsze poziomy
+                const uint32_t feedbackWidth = 100, feedbackHeight = 75;
+                std::vector<uint16_t> feedback((size_t)feedbackWidth * feedbackHeight * 4, 0);
+                uint32_t levelCount = (uint32_t)virtualTexture.levels.size();
+                for (uint32_t y = 10; y < feedbackHeight; ++y) {
+                    uint32_t level = std::min(levelCount - 1, (uint32_t)std::log2((double)feedbackHeight / (y + 1)));
+                    const VirtualTextureLevel& info = virtualTexture.levels[level];
+                    for (uint32_t x = 0; x < feedbackWidth; ++x) {
+                        uint16_t* pixel = &feedback[((size_t)y * feedbackWidth + x) * 4];
+                        pixel[0] = (uint16_t)(x * info.pagesX / feedbackWidth);
+                        pixel[1] = (uint16_t)((y - 10) * info.pagesY / (feedbackHeight - 10));
+                        pixel[2] = (uint16_t)level;
+                        pixel[3] = 1;
+                    }
+                }
+                std::string feedbackParams = "pixels=" + std::to_string(feedbackWidth * feedbackHeight) + ";tiles="
+                    + std::to_string(virtualTexture.tileSlots.size());
+                run("collectTileRequests", feedbackParams, (uint64_t)feedbackWidth * feedbackHeight, [&]() {
+                    collectTileRequests(virtualTexture, feedback.data(), feedback.size() / 4);
+                    benchSink = virtualTexture.requests.size();
+                });
+                closeVirtualTexture(virtualTexture);
+            }
+        }
+        for (const std::string& sheet : sheets)
+            std::remove(sheet.c_str());
+        std::remove(config.virtualTexturePath.c_str());
+    }
+
+    // scena LOD: kafle z miasta 512x512 probek na 2 km i wybor kafli z kamery drona nad miastem (bez GL)
+    if (config.filter.empty() || std::string("buildLodScene").find(config.filter) != std::string::npos
+        || std::string("selectLodTiles").find(config.filter) != std::string::npos) {
+        std::vector<Mesh> cityMeshes(1);
+        buildSyntheticCity(512, 2000.0f, config.scene.seed, cityMeshes[0]);
+        SceneGraph cityGraph;
+        cityGraph.nodes.assign(1, Node());
+        cityGraph.nodes[0].meshCount = 1;
+        cityGraph.meshIndices.assign(1, 0);
+        LodBuildConfig buildConfig;
+        buildConfig.leafTriangles = 8192;
+        uint64_t triangles = cityMeshes[0].indices.size() / 3;
+        run("buildLodScene", "grid=512;triangles=" + std::to_string(triangles) + ";leaf=" + std::to_string(buildConfig.leafTriangles),
+            triangles, [&]() {
+            benchSink = buildLodScene(config.lodScenePath, cityGraph, cityMeshes, buildConfig);
+        });
+        if (!buildLodScene(config.lodScenePath, cityGraph, cityMeshes, buildConfig)) {
+            std::cerr << "ERROR::BENCHMARK::CANNOT_WRITE " << config.lodScenePath << std::endl;
+        } else {
+            LodScene lodScene;
+            if (loadLodSceneLayout(lodScene, config.lodScenePath, LodStreamingConfig())) {
+                // wszystkie kafle jakby byly juz w GPU - mierzone samo przejscie hierarchii
+                for (LodTile& tile : lodScene.tiles)
+                    tile.state = LOD_TILE_RESIDENT;
+                glm::vec3 camera(-600.0f, 80.0f, -600.0f);
+                glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 5000.0f)
+                    * glm::lookAt(camera, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                selectLodTiles(lodScene, camera, viewProjection, 600.0f, glm::radians(45.0f));
+                std::string selectParams = "tiles=" + std::to_string(lodScene.nodes.size()) + ";drawn="
+                    + std::to_string(lodScene.drawList.size());
+                run("selectLodTiles", selectParams, lodScene.nodes.size(), [&]() {
+                    selectLodTiles(lodScene, camera, viewProjection, 600.0f, glm::radians(45.0f));
+                    benchSink = lodScene.drawList.size();
+                });
+                closeLodScene(lodScene);
+            }
+        }
+        std::remove(config.lodScenePath.c_str());
+    }
+
+    meshes.clear();
+    shutdownJobSystem();
+    return 0;
+}
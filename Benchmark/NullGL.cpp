@@ -0,0 +1,58 @@
+#include "NullGL.h"
+#include <glad/glad.h>
+
+NullGLStats nullGLStats = {};
+static GLuint nextName = 1;
+
+static void APIENTRY nullGenNames(GLsizei n, GLuint* names) {
+    for (GLsizei i = 0; i < n; ++i)
+        names[i] = nextName++;
+}
+
+static void APIENTRY nullBind(GLuint) {}
+static void APIENTRY nullBindTarget(GLenum, GLuint) {}
+static void APIENTRY nullEnableAttrib(GLuint) {}
+
+static void APIENTRY nullBufferData(GLenum, GLsizeiptr size, const void*, GLenum) {
+    nullGLStats.bufferBytes += (uint64_t)size;
+}
+
+static void APIENTRY nullAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+
+static GLint APIENTRY nullUniformLocation(GLuint, const GLchar*) {
+    return 0;
+}
+
+static void APIENTRY nullUniformMatrix4(GLint, GLsizei, GLboolean, const GLfloat*) {
+    nullGLStats.uniformUploads++;
+}
+
+static void APIENTRY nullDrawElements(GLenum, GLsizei count, GLenum, const void*) {
+    nullGLStats.drawCalls++;
+    nullGLStats.indices += (uint64_t)count;
+}
+
+static void APIENTRY nullDrawElementsInstanced(GLenum, GLsizei count, GLenum, const void*, GLsizei instances) {
+    nullGLStats.drawCalls++;
+    nullGLStats.indices += (uint64_t)count * instances;
+}
+
+static void APIENTRY nullAttribDivisor(GLuint, GLuint) {}
+static void APIENTRY nullDeleteNames(GLsizei, const GLuint*) {}
+
+void loadNullGL() {
+    glad_glGenVertexArrays = nullGenNames;
+    glad_glGenBuffers = nullGenNames;
+    glad_glBindVertexArray = nullBind;
+    glad_glBindBuffer = nullBindTarget;
+    glad_glBufferData = nullBufferData;
+    glad_glVertexAttribPointer = nullAttribPointer;
+    glad_glEnableVertexAttribArray = nullEnableAttrib;
+    glad_glGetUniformLocation = nullUniformLocation;
+    glad_glUniformMatrix4fv = nullUniformMatrix4;
+    glad_glDrawElements = nullDrawElements;
+    glad_glDrawElementsInstanced = nullDrawElementsInstanced;
+    glad_glVertexAttribDivisor = nullAttribDivisor;
+    glad_glDeleteBuffers = nullDeleteNames;
+    glad_glDeleteVertexArrays = nullDeleteNames;
+}
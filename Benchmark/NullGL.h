@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// podmienia wskazniki glad na puste funkcje - drawNode/uploadMesh bez kontekstu GL,
+// mierzymy tylko koszt po stronie CPU
+void loadNullGL();
+
+struct NullGLStats {
+    uint64_t drawCalls;
+    uint64_t indices;
+    uint64_t uniformUploads;
+    uint64_t bufferBytes;
+};
+
+extern NullGLStats nullGLStats;
@@ -0,0 +1,286 @@
+#include "SyntheticScene.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+static uint64_t nextRandom(uint64_t& state) {
+    uint64_t x = (state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static float randomFloat(uint64_t& state) {
+    return (float)(nextRandom(state) >> 40) / (float)(1ULL << 24);
+}
+
+static glm::mat4 childTransform(unsigned int child, unsigned int branching) {
+    float angle = 6.2831853f * child / branching;
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(std::cos(angle), 0.5f, std::sin(angle)));
+    return glm::rotate(transform, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+size_t syntheticNodeCount(const SyntheticSceneConfig& config) {
+    size_t count = 0, level = 1;
+    for (unsigned int d = 0; d < config.depth; ++d) {
+        count += level;
+        level *= config.branching;
+    }
+    return count;
+}
+
+StressSceneConfig stressConfigFor(const SyntheticSceneConfig& config) {
+    StressSceneConfig stress;
+    stress.drones = config.drones;
+    stress.depth = config.depth;
+    stress.branching = config.branching;
+    stress.meshesPerNode = config.meshesPerNode;
+    stress.meshCount = config.meshCount;
+    stress.trianglesPerMesh = config.trianglesPerMesh;
+    stress.seed = config.seed;
+    stress.upload = false;
+    return stress;
+}
+
+static aiNode* buildAiNode(const SyntheticSceneConfig& config, unsigned int depth, uint64_t& random, aiNode* parent) {
+    aiNode* node = new aiNode();
+    node->mParent = parent;
+    node->mNumMeshes = config.meshesPerNode;
+    node->mMeshes = config.meshesPerNode ? new unsigned int[config.meshesPerNode] : nullptr;
+    for (unsigned int m = 0; m < config.meshesPerNode; ++m)
+        node->mMeshes[m] = (unsigned int)(nextRandom(random) % config.meshCount);
+    if (depth + 1 >= config.depth)
+        return node;
+
+    node->mNumChildren = config.branching;
+    node->mChildren = new aiNode*[config.branching];
+    for (unsigned int c = 0; c < config.branching; ++c) {
+        node->mChildren[c] = buildAiNode(config, depth + 1, random, node);
+        glm::mat4 t = childTransform(c, config.branching);
+        // aiMatrix4x4 jest wierszowa, glm kolumnowa
+        node->mChildren[c]->mTransformation = aiMatrix4x4(
+            t[0][0], t[1][0], t[2][0], t[3][0],
+            t[0][1], t[1][1], t[2][1], t[3][1],
+            t[0][2], t[1][2], t[2][2], t[3][2],
+            t[0][3], t[1][3], t[2][3], t[3][3]);
+    }
+    return node;
+}
+
+aiNode* buildSyntheticAiNodes(const SyntheticSceneConfig& config) {
+    uint64_t random = config.seed;
+    return buildAiNode(config, 0, random, nullptr);
+}
+
+bool writeSyntheticObj(const SyntheticSceneConfig& config, const std::string& path) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    // siatka quadow, kazdy quad = 2 trojkaty
+    unsigned int quads = (config.trianglesPerMesh + 1) / 2;
+    unsigned int width = (unsigned int)std::ceil(std::sqrt((float)quads));
+    unsigned int height = (quads + width - 1) / width;
+    size_t firstVertex = 1;
+    uint64_t random = config.seed;
+    for (unsigned int m = 0; m < config.meshCount; ++m) {
+        out << "o mesh" << m << '\n';
+        for (unsigned int y = 0; y <= height; ++y) {
+            for (unsigned int x = 0; x <= width; ++x)
+                out << "v " << m * 2.0f + (float)x / width << ' ' << 0.1f * randomFloat(random) << ' ' << (float)y / height << '\n';
+        }
+        unsigned int emitted = 0;
+        for (unsigned int y = 0; y < height && emitted < quads; ++y) {
+            for (unsigned int x = 0; x < width && emitted < quads; ++x, ++emitted) {
+                size_t a = firstVertex + y * (width + 1) + x;
+                size_t b = a + 1, c = a + width + 1, d = c + 1;
+                out << "f " << a << ' ' << b << ' ' << d << '\n';
+                out << "f " << a << ' ' << d << ' ' << c << '\n';
+            }
+        }
+        firstVertex += (size_t)(width + 1) * (height + 1);
+    }
+    return (bool)out;
+}
+
+bool writeSyntheticGlb(const SyntheticSceneConfig& config, const std::string& path) {
+    unsigned int quads = (config.trianglesPerMesh + 1) / 2;
+    unsigned int width = (unsigned int)std::ceil(std::sqrt((float)quads));
+    unsigned int height = (quads + width - 1) / width;
+    uint64_t random = config.seed;
+
+    std::vector<unsigned char> bin;
+    std::ostringstream views, accessors, meshes, nodes;
+    auto append = [&](const void* data, size_t size) {
+        size_t offset = bin.size();
+        bin.resize(offset + size);
+        std::memcpy(bin.data() + offset, data, size);
+        return offset;
+    };
+    for (unsigned int m = 0; m < config.meshCount; ++m) {
+        std::vector<glm::vec3> positions, normals;
+        std::vector<uint32_t> indices;
+        glm::vec3 low(1e30f), high(-1e30f);
+        for (unsigned int y = 0; y <= height; ++y) {
+            for (unsigned int x = 0; x <= width; ++x) {
+                positions.push_back(glm::vec3(m * 2.0f + (float)x / width, 0.1f * randomFloat(random), (float)y / height));
+                normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+                low = glm::min(low, positions.back());
+                high = glm::max(high, positions.back());
+            }
+        }
+        unsigned int emitted = 0;
+        for (unsigned int y = 0; y < height && emitted < quads; ++y) {
+            for (unsigned int x = 0; x < width && emitted < quads; ++x, ++emitted) {
+                uint32_t a = y * (width + 1) + x, b = a + 1, c = a + width + 1, d = c + 1;
+                indices.insert(indices.end(), { a, b, d, a, d, c });
+            }
+        }
+        size_t positionOffset = append(positions.data(), positions.size() * sizeof(glm::vec3));
+        size_t normalOffset = append(normals.data(), normals.size() * sizeof(glm::vec3));
+        size_t indexOffset = append(indices.data(), indices.size() * sizeof(uint32_t));
+
+        const char* separator = m ? "," : "";
+        views << separator << "{\"buffer\":0,\"byteOffset\":" << positionOffset << ",\"byteLength\":" << positions.size() * 12 << "},"
+            << "{\"buffer\":0,\"byteOffset\":" << normalOffset << ",\"byteLength\":" << normals.size() * 12 << "},"
+            << "{\"buffer\":0,\"byteOffset\":" << indexOffset << ",\"byteLength\":" << indices.size() * 4 << "}";
+        accessors << separator
+            << "{\"bufferView\":" << 3 * m << ",\"componentType\":5126,\"count\":" << positions.size() << ",\"type\":\"VEC3\","
+            << "\"min\":[" << low.x << "," << low.y << "," << low.z << "],\"max\":[" << high.x << "," << high.y << "," << high.z << "]},"
+            << "{\"bufferView\":" << 3 * m + 1 << ",\"componentType\":5126,\"count\":" << normals.size() << ",\"type\":\"VEC3\"},"
+            << "{\"bufferView\":" << 3 * m + 2 << ",\"componentType\":5125,\"count\":" << indices.size() << ",\"type\":\"SCALAR\"}";
+        meshes << separator << "{\"primitives\":[{\"attributes\":{\"POSITION\":" << 3 * m << ",\"NORMAL\":" << 3 * m + 1
+            << "},\"indices\":" << 3 * m + 2 << "}]}";
+        nodes << separator << "{\"mesh\":" << m << "}";
+    }
+
+    std::ostringstream json;
+    json << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for (unsigned int m = 0; m < config.meshCount; ++m)
+        json << (m ? "," : "") << m;
+    json << "]}],\"nodes\":[" << nodes.str() << "],\"meshes\":[" << meshes.str() << "],\"accessors\":[" << accessors.str()
+        << "],\"bufferViews\":[" << views.str() << "],\"buffers\":[{\"byteLength\":" << bin.size() << "}]}";
+    // chunki wyrownane do 4 bajtow: JSON spacjami, BIN zerami
+    std::string text = json.str();
+    text.resize((text.size() + 3) & ~(size_t)3, ' ');
+    bin.resize((bin.size() + 3) & ~(size_t)3, 0);
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    uint32_t header[3] = { 0x46546C67, 2, (uint32_t)(12 + 8 + text.size() + 8 + bin.size()) };
+    uint32_t jsonChunk[2] = { (uint32_t)text.size(), 0x4E4F534A };
+    uint32_t binChunk[2] = { (uint32_t)bin.size(), 0x004E4942 };
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)jsonChunk, sizeof(jsonChunk));
+    out.write(text.data(), text.size());
+    out.write((const char*)binChunk, sizeof(binChunk));
+    out.write((const char*)bin.data(), bin.size());
+    return (bool)out;
+}
+
+void buildSyntheticHierarchy(const SyntheticSceneConfig& config, std::vector<int>& parents, std::vector<glm::mat4>& locals) {
+    // wszerz, wiec rodzic zawsze ma mniejszy indeks niz dziecko
+    size_t count = syntheticNodeCount(config);
+    parents.resize(count);
+    locals.resize(count);
+    parents[0] = -1;
+    locals[0] = glm::mat4(1.0f);
+    for (size_t i = 1; i < count; ++i) {
+        parents[i] = (int)((i - 1) / config.branching);
+        locals[i] = childTransform((unsigned int)((i - 1) % config.branching), config.branching);
+    }
+}
+
+void buildSyntheticSpheres(size_t count, float extent, uint64_t seed, std::vector<glm::vec4>& spheres) {
+    uint64_t random = seed;
+    spheres.resize(count);
+    for (glm::vec4& sphere : spheres) {
+        sphere.x = (randomFloat(random) - 0.5f) * extent;
+        sphere.y = (randomFloat(random) - 0.5f) * extent;
+        sphere.z = (randomFloat(random) - 0.5f) * extent;
+        sphere.w = 0.5f + 1.5f * randomFloat(random);
+    }
+}
+
+void buildSyntheticImage(uint32_t size, uint64_t seed, TextureImage& image) {
+    uint64_t random = seed;
+    image.format = TEXTURE_RGBA8;
+    image.levels.assign(1, { size, size, 0, (size_t)size * size * 4 });
+    image.data.resize(image.levels[0].size);
+    unsigned char* pixel = image.data.data();
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x, pixel += 4) {
+            float noise = randomFloat(random) * 32.0f;
+            pixel[0] = (unsigned char)std::min(255.0f, 223.0f * x / size + noise);
+            pixel[1] = (unsigned char)std::min(255.0f, 223.0f * y / size + noise);
+            pixel[2] = (unsigned char)std::min(255.0f, 112.0f + 111.0f * std::sin(0.05f * (x + y)) + noise);
+            pixel[3] = 255;
+        }
+    }
+}
+
+bool writeSyntheticTga(uint32_t size, uint64_t seed, const std::string& path) {
+    TextureImage image;
+    buildSyntheticImage(size, seed, image);
+    // typ 2 (bez kompresji), 32 bity, deskryptor 0x28: 8 bitow alfy, poczatek w lewym gornym rogu
+    unsigned char header[18] = {};
+    header[2] = 2;
+    header[12] = (unsigned char)(size & 0xFF);
+    header[13] = (unsigned char)(size >> 8);
+    header[14] = (unsigned char)(size & 0xFF);
+    header[15] = (unsigned char)(size >> 8);
+    header[16] = 32;
+    header[17] = 0x28;
+    for (size_t i = 0; i < image.data.size(); i += 4)
+        std::swap(image.data[i], image.data[i + 2]);
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)image.data.data(), image.data.size());
+    return (bool)out;
+}
+
+void buildSyntheticCity(uint32_t resolution, float size, uint64_t seed, Mesh& mesh) {
+    // kwartal 16 x 16 probek: ulica na brzegu, w srodku budynek
+    const uint32_t block = 16, street = 3;
+    uint32_t blocks = (resolution + block - 1) / block;
+    uint64_t random = seed;
+    std::vector<float> heights((size_t)blocks * blocks);
+    for (float& height : heights)
+        height = randomFloat(random) < 0.2f ? 0.0f : 4.0f + 40.0f * randomFloat(random) * randomFloat(random);
+    uint32_t side = resolution + 1;
+    float step = size / resolution;
+    mesh = Mesh();
+    mesh.positions.resize((size_t)side * side);
+    mesh.normals.assign(mesh.positions.size(), glm::vec3(0.0f));
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            uint32_t bx = std::min(x / block, blocks - 1), by = std::min(y / block, blocks - 1);
+            bool inside = x % block >= street && y % block >= street;
+            float height = 0.5f * std::sin(0.02f * x) * std::cos(0.03f * y) + 0.1f * randomFloat(random)
+                + (inside ? heights[(size_t)by * blocks + bx] : 0.0f);
+            mesh.positions[(size_t)y * side + x] = glm::vec3(x * step - 0.5f * size, height, y * step - 0.5f * size);
+        }
+    }
+    mesh.indices.reserve((size_t)resolution * resolution * 6);
+    for (uint32_t y = 0; y < resolution; ++y) {
+        for (uint32_t x = 0; x < resolution; ++x) {
+            unsigned int i = y * side + x;
+            const unsigned int quad[6] = { i, i + side, i + 1, i + 1, i + side, i + side + 1 };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+        const glm::vec3& a = mesh.positions[mesh.indices[t]];
+        glm::vec3 face = glm::cross(mesh.positions[mesh.indices[t + 1]] - a, mesh.positions[mesh.indices[t + 2]] - a);
+        for (int k = 0; k < 3; ++k)
+            mesh.normals[mesh.indices[t + k]] += face;
+    }
+    for (glm::vec3& normal : mesh.normals)
+        normal = glm::normalize(normal);
+}
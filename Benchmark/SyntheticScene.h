@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <assimp/scene.h>
+
+#include "ModelLoader.h"
+#include "StressScene.h"
+#include "TextureCodec.h"
+
+// powtarzalne sceny testowe: drones pelnych drzew o glebokosci depth i branching dzieciach na wezel
+struct SyntheticSceneConfig {
+    unsigned int drones = 1;
+    unsigned int depth = 6;
+    unsigned int branching = 4;
+    unsigned int meshesPerNode = 1;
+    unsigned int meshCount = 64;
+    unsigned int trianglesPerMesh = 1000;
+    uint64_t seed = 1;
+};
+
+size_t syntheticNodeCount(const SyntheticSceneConfig& config);
+
+// parametry generatora sceny testowej (bez uploadu, drawNode idzie przez NullGL)
+StressSceneConfig stressConfigFor(const SyntheticSceneConfig& config);
+// drzewo jednego drona jako aiNode (wejscie buildSceneGraph); zwolnienie: delete root
+aiNode* buildSyntheticAiNodes(const SyntheticSceneConfig& config);
+// meshCount siatek po trianglesPerMesh trojkatow w formacie OBJ (wejscie loadModel)
+bool writeSyntheticObj(const SyntheticSceneConfig& config, const std::string& path);
+// te same siatki jako .glb (pozycje, normalne, indeksy uint32 w chunku BIN), wezel na siatke - wejscie loadGltf
+bool writeSyntheticGlb(const SyntheticSceneConfig& config, const std::string& path);
+
+// plaska hierarchia: parents[i] < i (korzen ma -1), lokalne transformacje
+void buildSyntheticHierarchy(const SyntheticSceneConfig& config, std::vector<int>& parents, std::vector<glm::mat4>& locals);
+// sfery ograniczajace rozrzucone w szescianie o boku extent wokol poczatku ukladu
+void buildSyntheticSpheres(size_t count, float extent, uint64_t seed, std::vector<glm::vec4>& spheres);
+// obraz RGBA8 size x size (jeden poziom): gladkie gradienty z szumem, alfa 255 - wejscie buildMipChain/compressImage
+void buildSyntheticImage(uint32_t size, uint64_t seed, TextureImage& image);
+// ten sam obraz jako TGA 32-bit (wiersze od gory) - arkusz dla buildVirtualTexture
+bool writeSyntheticTga(uint32_t size, uint64_t seed, const std::string& path);
+// miasto jak z fotogrametrii 2.5D: siatka wysokosci resolution x resolution na kwadracie size, bloki budynkow
+// o losowej wysokosci na szumie terenu - wejscie buildLodScene
+void buildSyntheticCity(uint32_t resolution, float size, uint64_t seed, Mesh& mesh);
@@ -0,0 +1,285 @@
+#include "AllocTracker.h"
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <intrin.h>
+#define ALLOC_RETURN_ADDRESS() ((uintptr_t)_ReturnAddress())
+#else
+#include <dlfcn.h>
+#define ALLOC_RETURN_ADDRESS() ((uintptr_t)__builtin_return_address(0))
+#endif
+
+// wszystko ponizej jest uzywane z wnetrza operator new - tylko stale tablice i atomiki, zadnych alokacji
+struct AllocCounters {
+    const char* name;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+};
+
+// klucz = adres | podsystem << 56 - to samo miejsce (np. wnetrze biblioteki standardowej) osobno dla kazdego podsystemu
+struct AllocSite {
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+    std::atomic<bool> violation;
+};
+
+static AllocCounters subsystems[ALLOC_MAX_SUBSYSTEMS];
+static std::atomic<unsigned int> subsystemCount{ 1 };
+static AllocSite sites[ALLOC_MAX_SITES];
+static std::atomic<uint64_t> totalCount{ 0 }, totalBytes{ 0 }, totalViolations{ 0 };
+static std::atomic<bool> steadyState{ false };
+static std::atomic<bool> strictMode{ false };
+
+// stan poprzedniego endAllocFrame - tylko watek renderu
+static uint64_t frameIndex = 0;
+static uint64_t lastCount = 0, lastBytes = 0, lastViolations = 0;
+
+static thread_local unsigned int currentSubsystem = 0;
+static thread_local bool currentChecked = false;
+
+unsigned int registerAllocSubsystem(const char* name) {
+    unsigned int count = subsystemCount.load(std::memory_order_acquire);
+    for (unsigned int i = 1; i < count; ++i) {
+        if (subsystems[i].name == name)
+            return i;
+    }
+    unsigned int id = subsystemCount.fetch_add(1, std::memory_order_acq_rel);
+    if (id >= ALLOC_MAX_SUBSYSTEMS) {
+        std::fprintf(stderr, "ERROR::ALLOC::TOO_MANY_SUBSYSTEMS %s\n", name);
+        return 0;
+    }
+    subsystems[id].name = name;
+    return id;
+}
+
+void setAllocSteadyState(bool steady) {
+    steadyState.store(steady, std::memory_order_relaxed);
+}
+
+void setAllocStrict(bool strict) {
+    strictMode.store(strict, std::memory_order_relaxed);
+}
+
+AllocScope::AllocScope(unsigned int subsystem, bool checked) : previous(currentSubsystem), previousChecked(currentChecked) {
+    currentSubsystem = subsystem;
+    currentChecked = checked;
+}
+
+AllocScope::~AllocScope() {
+    currentSubsystem = previous;
+    currentChecked = previousChecked;
+}
+
+static const char* subsystemName(unsigned int subsystem) {
+    return subsystem && subsystem < ALLOC_MAX_SUBSYSTEMS && subsystems[subsystem].name ? subsystems[subsystem].name : "untracked";
+}
+
+// adres -> (modul, przesuniecie), zeby dalo sie go odszukac mimo ASLR
+static uintptr_t moduleOffset(uintptr_t address, const char** module) {
+    *module = "?";
+#ifdef _WIN32
+    HMODULE handle = nullptr;
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            (LPCSTR)address, &handle)) {
+        static char path[MAX_PATH];
+        GetModuleFileNameA(handle, path, MAX_PATH);
+        *module = path;
+        return address - (uintptr_t)handle;
+    }
+#else
+    Dl_info info;
+    if (dladdr((void*)address, &info) && info.dli_fbase) {
+        *module = info.dli_fname;
+        return address - (uintptr_t)info.dli_fbase;
+    }
+#endif
+    return address;
+}
+
+const uint64_t SITE_ADDRESS_MASK = (1ULL << 56) - 1;
+
+static void recordSite(uintptr_t address, unsigned int subsystem, size_t size, bool violation) {
+    // otwarte adresowanie, klucz wpisywany raz przez CAS; pelna tablica - miejsce nie jest zapisywane
+    uint64_t wanted = ((uint64_t)address & SITE_ADDRESS_MASK) | ((uint64_t)subsystem << 56);
+    size_t slot = (size_t)(((wanted >> 2) * 0x9E3779B97F4A7C15ULL) >> 32) % ALLOC_MAX_SITES;
+    for (unsigned int probe = 0; probe < ALLOC_MAX_SITES; ++probe) {
+        AllocSite& site = sites[(slot + probe) % ALLOC_MAX_SITES];
+        uint64_t key = site.key.load(std::memory_order_relaxed);
+        if (key == 0 && site.key.compare_exchange_strong(key, wanted, std::memory_order_relaxed))
+            key = wanted;
+        if (key != wanted)
+            continue;
+        site.count.fetch_add(1, std::memory_order_relaxed);
+        site.bytes.fetch_add(size, std::memory_order_relaxed);
+        if (violation)
+            site.violation.store(true, std::memory_order_relaxed);
+        return;
+    }
+}
+
+static void trackAllocation(size_t size, uintptr_t caller) {
+    unsigned int subsystem = currentSubsystem;
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(size, std::memory_order_relaxed);
+    subsystems[subsystem].count.fetch_add(1, std::memory_order_relaxed);
+    subsystems[subsystem].bytes.fetch_add(size, std::memory_order_relaxed);
+
+    bool violation = currentChecked && steadyState.load(std::memory_order_relaxed);
+    recordSite(caller, subsystem, size, violation);
+    if (!violation)
+        return;
+    totalViolations.fetch_add(1, std::memory_order_relaxed);
+    if (strictMode.load(std::memory_order_relaxed)) {
+        const char* module;
+        uintptr_t offset = moduleOffset(caller, &module);
+        std::fprintf(stderr, "ERROR::ALLOC::STEADY_STATE_ALLOCATION %zu bytes in %s at %s+0x%llx\n",
+            size, subsystemName(subsystem), module, (unsigned long long)offset);
+        std::abort();
+    }
+}
+
+AllocFrameStats endAllocFrame() {
+    AllocFrameStats stats;
+    uint64_t count = totalCount.load(std::memory_order_relaxed);
+    uint64_t bytes = totalBytes.load(std::memory_order_relaxed);
+    uint64_t violations = totalViolations.load(std::memory_order_relaxed);
+    stats.frame = frameIndex++;
+    stats.count = count - lastCount;
+    stats.bytes = bytes - lastBytes;
+    stats.violations = violations - lastViolations;
+    lastCount = count;
+    lastBytes = bytes;
+    lastViolations = violations;
+    return stats;
+}
+
+void printAllocReport(unsigned int topSites) {
+    std::printf("Allocations: %llu (%llu bytes), steady-state violations: %llu\n",
+        (unsigned long long)totalCount.load(), (unsigned long long)totalBytes.load(), (unsigned long long)totalViolations.load());
+    unsigned int count = std::min(subsystemCount.load(), ALLOC_MAX_SUBSYSTEMS);
+    for (unsigned int i = 0; i < count; ++i) {
+        if (subsystems[i].count.load() == 0)
+            continue;
+        std::printf("  %-20s %10llu allocs %14llu bytes\n", subsystemName(i),
+            (unsigned long long)subsystems[i].count.load(), (unsigned long long)subsystems[i].bytes.load());
+    }
+
+    // kopiujemy do wektora - raport sam alokuje, wiec robimy to poza sprawdzanymi zakresami
+    std::vector<const AllocSite*> used;
+    for (const AllocSite& site : sites) {
+        if (site.key.load() != 0)
+            used.push_back(&site);
+    }
+    std::sort(used.begin(), used.end(), [](const AllocSite* a, const AllocSite* b) {
+        if (a->violation.load() != b->violation.load())
+            return a->violation.load();
+        return a->count.load() > b->count.load();
+    });
+    if (used.size() > topSites)
+        used.resize(topSites);
+    for (const AllocSite* site : used) {
+        const char* module;
+        uint64_t key = site->key.load();
+        uintptr_t offset = moduleOffset((uintptr_t)(key & SITE_ADDRESS_MASK), &module);
+        std::printf("  %s%s+0x%llx [%s] %llu allocs %llu bytes\n", site->violation.load() ? "STEADY " : "",
+            module, (unsigned long long)offset, subsystemName((unsigned int)(key >> 56)),
+            (unsigned long long)site->count.load(), (unsigned long long)site->bytes.load());
+    }
+}
+
+#if ALLOC_TRACKING_ENABLED
+
+static void* allocate(size_t size, uintptr_t caller) {
+    void* memory = std::malloc(size ? size : 1);
+    if (memory)
+        trackAllocation(size, caller);
+    return memory;
+}
+
+// wersje z wyrownaniem (alignas ponad 16) - projekt kompiluje sie jako C++17, #ifdef tylko dla starszych kompilatorow
+#ifdef __cpp_aligned_new
+static void* allocateAligned(size_t size, size_t alignment, uintptr_t caller) {
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size ? size : 1, alignment);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, std::max(alignment, sizeof(void*)), size ? size : 1) != 0)
+        memory = nullptr;
+#endif
+    if (memory)
+        trackAllocation(size, caller);
+    return memory;
+}
+
+static void freeAligned(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+#endif
+
+void* operator new(size_t size) {
+    void* memory = allocate(size, ALLOC_RETURN_ADDRESS());
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    void* memory = allocate(size, ALLOC_RETURN_ADDRESS());
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, ALLOC_RETURN_ADDRESS());
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, ALLOC_RETURN_ADDRESS());
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* memory = allocateAligned(size, (size_t)alignment, ALLOC_RETURN_ADDRESS());
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    void* memory = allocateAligned(size, (size_t)alignment, ALLOC_RETURN_ADDRESS());
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+#endif
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+#ifdef __cpp_aligned_new
+void operator delete(void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// ALLOC_TRACKING_ENABLED=0 - bez podmiany operator new i bez liczenia (makra rozwijaja sie do niczego)
+#ifndef ALLOC_TRACKING_ENABLED
+#define ALLOC_TRACKING_ENABLED 1
+#endif
+
+const unsigned int ALLOC_MAX_SUBSYSTEMS = 64;
+const unsigned int ALLOC_MAX_SITES = 4096;
+
+// kazda alokacja (operator new) jest przypisana do podsystemu biezacego zakresu watku
+// i do miejsca wywolania (adres powrotu z operator new)
+struct AllocFrameStats {
+    uint64_t frame = 0;
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t violations = 0;  // alokacje w sprawdzanych zakresach po wejsciu w stan ustalony
+};
+
+// nazwa musi zyc do konca programu (literal albo internProfileName); 0 - "untracked"
+unsigned int registerAllocSubsystem(const char* name);
+
+// stan ustalony: kazda alokacja w zakresie sprawdzanym jest bledem
+void setAllocSteadyState(bool steady);
+// strict - pierwsza taka alokacja konczy program (abort), pod debuggerem widac stos
+void setAllocStrict(bool strict);
+
+// liczniki od poprzedniego wywolania (wszystkie watki razem)
+AllocFrameStats endAllocFrame();
+// sumy per podsystem + najczestsze miejsca wywolan (adres jako przesuniecie w module - addr2line / debugger)
+void printAllocReport(unsigned int topSites);
+
+struct AllocScope {
+    unsigned int previous;
+    bool previousChecked;
+
+    AllocScope(unsigned int subsystem, bool checked);
+    ~AllocScope();
+};
+
+#if ALLOC_TRACKING_ENABLED
+#define ALLOC_CONCAT_IMPL(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_IMPL(a, b)
+// zakres z juz zarejestrowanym podsystemem (np. nazwa znana dopiero w czasie dzialania)
+#define ALLOC_SUBSYSTEM_SCOPE(id, checked) AllocScope ALLOC_CONCAT(allocScope, __LINE__)(id, checked)
+#define ALLOC_NAMED_SCOPE(name, checked) \
+    static const unsigned int ALLOC_CONCAT(allocSubsystem, __LINE__) = registerAllocSubsystem(name); \
+    ALLOC_SUBSYSTEM_SCOPE(ALLOC_CONCAT(allocSubsystem, __LINE__), checked)
+// tylko liczenie
+#define ALLOC_SCOPE(name) ALLOC_NAMED_SCOPE(name, false)
+// liczenie + zakaz alokacji w stanie ustalonym (petla renderu, ticki symulacji)
+#define ALLOC_STEADY_SCOPE(name) ALLOC_NAMED_SCOPE(name, true)
+#else
+#define ALLOC_SUBSYSTEM_SCOPE(id, checked) ((void)0)
+#define ALLOC_SCOPE(name) ((void)0)
+#define ALLOC_STEADY_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,293 @@
+#include "AssetIO.h"
+#include "Profiler.h"
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+static const uint32_t ASSET_PACK_MAGIC = 0x4B415044;  // "DPAK"
+static const uint32_t ASSET_PACK_VERSION = 1;
+static const size_t ASSET_PACK_ALIGNMENT = 64;
+// tyle Read prosi system z wyprzedzeniem przed biezaca pozycja
+static const size_t READ_AHEAD_WINDOW = 8 * 1024 * 1024;
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t nameBytes;
+};
+
+struct AssetPackEntry {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+struct AssetRange {
+    int pack;
+    size_t offset;
+    size_t size;
+};
+
+static std::vector<MappedFile> packs;
+static std::unordered_map<std::string, AssetRange> packIndex;
+
+// '\\' -> '/', bez "./" i z rozwinietym "katalog/.." - Assimp skleja sciezki z separatorem systemu
+static std::string normalizeAssetPath(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == std::string::npos)
+            end = path.size();
+        std::string part = path.substr(start, end - start);
+        if (part == ".." && !parts.empty() && parts.back() != ".." && !parts.back().empty())
+            parts.pop_back();
+        else if (part != "." && (!part.empty() || parts.empty()))
+            parts.push_back(part);
+        start = end + 1;
+    }
+    std::string normalized;
+    for (size_t i = 0; i < parts.size(); ++i)
+        normalized += (i ? "/" : "") + parts[i];
+    return normalized;
+}
+
+bool mountAssetPack(const std::string& path) {
+    PROFILE_FUNCTION();
+    MappedFile file;
+    if (!mapFileForRead(file, path)) {
+        std::cerr << "ERROR::ASSET_PACK::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    AssetPackHeader header;
+    if (file.size < sizeof(header)) {
+        std::cerr << "ERROR::ASSET_PACK::INVALID " << path << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+    std::memcpy(&header, file.data, sizeof(header));
+    size_t tableEnd = sizeof(header) + (size_t)header.entryCount * sizeof(AssetPackEntry);
+    if (header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION || tableEnd + header.nameBytes > file.size) {
+        std::cerr << "ERROR::ASSET_PACK::INVALID " << path << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+    // najpierw sprawdzenie calej tablicy - uszkodzona paczka nie dodaje zadnego wpisu
+    std::vector<AssetPackEntry> entries(header.entryCount);
+    if (!entries.empty())
+        std::memcpy(entries.data(), file.data + sizeof(header), entries.size() * sizeof(AssetPackEntry));
+    for (const AssetPackEntry& entry : entries) {
+        if ((uint64_t)entry.nameOffset + entry.nameLength > header.nameBytes
+            || entry.offset > file.size || entry.size > file.size - entry.offset) {
+            std::cerr << "ERROR::ASSET_PACK::INVALID_ENTRY " << path << std::endl;
+            closeMappedFile(file);
+            return false;
+        }
+    }
+    int pack = (int)packs.size();
+    packs.push_back(file);
+    const char* names = (const char*)file.data + tableEnd;
+    for (const AssetPackEntry& entry : entries) {
+        std::string name(names + entry.nameOffset, entry.nameLength);
+        packIndex[name] = { pack, (size_t)entry.offset, (size_t)entry.size };
+    }
+    return true;
+}
+
+void unmountAssetPacks() {
+    packIndex.clear();
+    for (MappedFile& file : packs)
+        closeMappedFile(file);
+    packs.clear();
+}
+
+static size_t alignUp(size_t value) {
+    return (value + ASSET_PACK_ALIGNMENT - 1) & ~(ASSET_PACK_ALIGNMENT - 1);
+}
+
+bool writeAssetPack(const std::string& packPath, const std::string& root, const std::vector<std::string>& files) {
+    PROFILE_FUNCTION();
+    std::string directory = root.empty() ? std::string() : root + "/";
+    std::vector<MappedFile> sources(files.size());
+    std::vector<AssetPackEntry> entries(files.size());
+    std::string names;
+    bool ok = true;
+    for (size_t i = 0; i < files.size() && ok; ++i) {
+        ok = mapFileForRead(sources[i], directory + files[i]);
+        if (!ok) {
+            std::cerr << "ERROR::ASSET_PACK::CANNOT_OPEN " << directory + files[i] << std::endl;
+            break;
+        }
+        std::string name = normalizeAssetPath(files[i]);
+        entries[i].nameOffset = (uint32_t)names.size();
+        entries[i].nameLength = (uint32_t)name.size();
+        entries[i].size = sources[i].size;
+        names += name;
+    }
+
+    MappedFile pack;
+    if (ok) {
+        AssetPackHeader header = { ASSET_PACK_MAGIC, ASSET_PACK_VERSION, (uint32_t)files.size(), (uint32_t)names.size() };
+        size_t offset = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + names.size();
+        for (AssetPackEntry& entry : entries) {
+            offset = alignUp(offset);
+            entry.offset = offset;
+            offset += (size_t)entry.size;
+        }
+        ok = createMappedFile(pack, packPath, offset);
+        if (ok) {
+            // odstepy wyrownania zostaja zerami nowego pliku
+            std::memcpy(pack.data, &header, sizeof(header));
+            if (!entries.empty())
+                std::memcpy(pack.data + sizeof(header), entries.data(), entries.size() * sizeof(AssetPackEntry));
+            if (!names.empty())
+                std::memcpy(pack.data + sizeof(header) + entries.size() * sizeof(AssetPackEntry), names.data(), names.size());
+            for (size_t i = 0; i < files.size(); ++i) {
+                if (sources[i].size)
+                    std::memcpy(pack.data + entries[i].offset, sources[i].data, sources[i].size);
+            }
+            closeMappedFile(pack, offset);
+        } else {
+            std::cerr << "ERROR::ASSET_PACK::CANNOT_CREATE " << packPath << std::endl;
+        }
+    }
+    for (MappedFile& source : sources)
+        closeMappedFile(source);
+    return ok;
+}
+
+static const AssetRange* findPacked(const std::string& path) {
+    if (packIndex.empty())
+        return nullptr;
+    auto entry = packIndex.find(normalizeAssetPath(path));
+    return entry == packIndex.end() ? nullptr : &entry->second;
+}
+
+bool assetExists(const std::string& path) {
+    if (findPacked(path))
+        return true;
+    std::ifstream in(path, std::ios::binary);
+    return (bool)in;
+}
+
+bool openAsset(const std::string& path, AssetData& asset) {
+    asset = AssetData();
+    if (const AssetRange* range = findPacked(path)) {
+        asset.pack = range->pack;
+        asset.packOffset = range->offset;
+        asset.data = packs[range->pack].data + range->offset;
+        asset.size = range->size;
+    } else {
+        if (!mapFileForRead(asset.file, path))
+            return false;
+        asset.data = asset.file.data;
+        asset.size = asset.file.size;
+        adviseSequential(asset.file);
+    }
+    prefetchAsset(asset, 0, READ_AHEAD_WINDOW);
+    return true;
+}
+
+void closeAsset(AssetData& asset) {
+    if (asset.pack < 0)
+        closeMappedFile(asset.file);
+    asset = AssetData();
+}
+
+void prefetchAsset(const AssetData& asset, size_t offset, size_t length) {
+    if (offset >= asset.size)
+        return;
+    length = std::min(length, asset.size - offset);
+    if (asset.pack >= 0)
+        prefetchRange(packs[asset.pack], asset.packOffset + offset, length);
+    else
+        prefetchRange(asset.file, offset, length);
+}
+
+// Read to jedyna kopia: ze zmapowanych stron do bufora importera (stdio kopiowaloby jeszcze przez swoj bufor)
+class AssetIOStream : public Assimp::IOStream {
+public:
+    explicit AssetIOStream(const AssetData& source) : asset(source), position(0), prefetched(READ_AHEAD_WINDOW) {}
+    ~AssetIOStream() override { closeAsset(asset); }
+
+    size_t Read(void* buffer, size_t size, size_t count) override {
+        if (size == 0 || position >= asset.size)
+            return 0;
+        count = std::min(count, (asset.size - position) / size);
+        size_t bytes = count * size;
+        // kolejne okno zamawiane, gdy czytanie dojdzie do polowy poprzedniego
+        if (position + bytes + READ_AHEAD_WINDOW / 2 > prefetched && prefetched < asset.size) {
+            size_t from = std::max(prefetched, position);
+            prefetchAsset(asset, from, position + bytes + READ_AHEAD_WINDOW - from);
+            prefetched = position + bytes + READ_AHEAD_WINDOW;
+        }
+        if (bytes)
+            std::memcpy(buffer, asset.data + position, bytes);
+        position += bytes;
+        return count;
+    }
+
+    size_t Write(const void*, size_t, size_t) override {
+        return 0;
+    }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override {
+        size_t base = origin == aiOrigin_SET ? 0 : (origin == aiOrigin_CUR ? position : asset.size);
+        // poza koniec nie wolno - Read i tak nic by nie zwrocil
+        if (offset > asset.size - base)
+            return aiReturn_FAILURE;
+        position = base + offset;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override {
+        return position;
+    }
+
+    size_t FileSize() const override {
+        return asset.size;
+    }
+
+    void Flush() override {}
+
+private:
+    AssetData asset;
+    size_t position;
+    size_t prefetched;
+};
+
+class AssetIOSystem : public Assimp::IOSystem {
+public:
+    bool Exists(const char* file) const override {
+        return assetExists(file);
+    }
+
+    char getOsSeparator() const override {
+        return '/';  // Windows tez przyjmuje '/', a w paczce nazwy sa zapisane z '/'
+    }
+
+    Assimp::IOStream* Open(const char* file, const char* mode) override {
+        // tylko odczyt - eksport idzie dalej przez domyslne IO
+        if (std::strpbrk(mode, "wa+"))
+            return nullptr;
+        AssetData asset;
+        if (!openAsset(file, asset))
+            return nullptr;
+        return new AssetIOStream(asset);
+    }
+
+    void Close(Assimp::IOStream* file) override {
+        delete file;
+    }
+};
+
+Assimp::IOSystem* createAssetIOSystem() {
+    return new AssetIOSystem();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace Assimp {
+class IOSystem;
+}
+
+// zawartosc pliku tylko do odczytu: wpis z zamontowanej paczki (pack >= 0, bez wlasnosci)
+// albo osobno zmapowany plik z dysku (pack == -1, file zamykany przez closeAsset)
+struct AssetData {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    int pack = -1;
+    size_t packOffset = 0;
+    MappedFile file;
+};
+
+// paczka = jeden plik: naglowek, tablica wpisow, nazwy, dane wyrownane do 64 B.
+// Zamontowana zostaje zmapowana do unmountAssetPacks; pozniej zamontowana przeslania wczesniejsze
+bool mountAssetPack(const std::string& path);
+void unmountAssetPacks();
+// files - sciezki wzgledem root; w paczce zapisane z '/' jako separatorem, tak jak beda szukane
+bool writeAssetPack(const std::string& packPath, const std::string& root, const std::vector<std::string>& files);
+
+// najpierw zamontowane paczki, potem system plikow (mmap z podpowiedzia czytania po kolei)
+bool assetExists(const std::string& path);
+bool openAsset(const std::string& path, AssetData& asset);
+void closeAsset(AssetData& asset);
+// podpowiedz read-ahead dla zakresu wzgledem poczatku zasobu
+void prefetchAsset(const AssetData& asset, size_t offset, size_t length);
+
+// IOSystem dla Assimp::Importer::SetIOHandler (importer przejmuje obiekt) - czyta przez openAsset,
+// strumien kopiuje prosto ze zmapowanych stron i z wyprzedzeniem prosi system o kolejne
+Assimp::IOSystem* createAssetIOSystem();
@@ -0,0 +1,179 @@
+#include "BatchSimulation.h"
+#include "Simulation.h"
+#include "Scheduler.h"
+#include "JobSystem.h"
+#include "Snapshot.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+const unsigned int METRICS_RATE = 100;
+const float INITIAL_OFFSET = 1.0f;
+
+bool parseBatchArguments(int argc, char** argv, BatchConfig& config) {
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(arg, "--scenarios") == 0 && hasValue)
+            config.scenarios = (unsigned int)std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--drones") == 0 && hasValue)
+            config.dronesPerScenario = (unsigned int)std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--duration") == 0 && hasValue)
+            config.duration = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue)
+            config.baseSeed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--out") == 0 && hasValue)
+            config.summaryPath = argv[++i];
+        else if (std::strcmp(arg, "--rollouts") == 0 && hasValue)
+            config.rollouts = (unsigned int)std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--warmup") == 0 && hasValue)
+            config.warmup = std::atof(argv[++i]);
+    }
+    return headless;
+}
+
+static void runScenario(const BatchConfig& config, unsigned int index, ScenarioResult& result) {
+    PROFILE_SCOPE("scenario");
+    auto start = std::chrono::steady_clock::now();
+
+    SimState state;
+    initSimulation(state, config.dronesPerScenario);
+    state.seed = config.baseSeed + index;
+
+    // kazdy scenariusz startuje z innym (powtarzalnym) odchyleniem od punktu docelowego
+    uint64_t x = state.seed * 0x9E3779B97F4A7C15ULL;
+    for (DroneState& drone : state.drones) {
+        x ^= x >> 29; x *= 0xBF58476D1CE4E5B9ULL; x ^= x >> 32;
+        float angle = (float)(x & 0xFFFF) / 65536.0f * 6.2831853f;
+        float distance = (float)((x >> 16) & 0xFFFF) / 65536.0f;
+        float height = (float)((x >> 32) & 0xFFFF) / 65536.0f - 0.5f;
+        drone.position += INITIAL_OFFSET * glm::vec3(distance * std::cos(angle), height, distance * std::sin(angle));
+    }
+
+    double errorSquaredSum = 0.0;
+    uint64_t samples = 0;
+    float maxError = 0.0f;
+    auto measure = [&](float) {
+        for (const DroneState& drone : state.drones) {
+            float error = glm::length(drone.position - drone.home);
+            maxError = glm::max(maxError, error);
+            errorSquaredSum += error * error;
+            samples++;
+        }
+    };
+
+    SimScheduler scheduler;
+    registerSimulationSubsystems(scheduler, state);
+    addSubsystem(scheduler, "metrics", METRICS_RATE, measure);
+    runSchedulerUntil(scheduler, (uint64_t)(config.duration * NANOSECONDS_PER_SECOND));
+
+    float finalError = 0.0f;
+    for (const DroneState& drone : state.drones)
+        finalError = glm::max(finalError, glm::length(drone.position - drone.home));
+
+    result.index = index;
+    result.seed = state.seed;
+    result.simulatedSeconds = scheduler.timeNs / 1e9;
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.maxPositionError = maxError;
+    result.rmsPositionError = samples ? (float)std::sqrt(errorSquaredSum / samples) : 0.0f;
+    result.finalPositionError = finalError;
+}
+
+int runBatch(const BatchConfig& config) {
+    std::vector<ScenarioResult> results(config.scenarios);
+
+    auto start = std::chrono::steady_clock::now();
+    parallelFor(0, config.scenarios, [&](size_t i) {
+        runScenario(config, (unsigned int)i, results[i]);
+    });
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream out(config.summaryPath);
+    if (!out) {
+        std::cerr << "ERROR::BATCH::CANNOT_OPEN " << config.summaryPath << std::endl;
+        return -1;
+    }
+    out << "scenario,seed,simulated_s,wall_s,max_error_m,rms_error_m,final_error_m\n";
+    double simulatedSeconds = 0.0;
+    for (const ScenarioResult& r : results) {
+        out << r.index << ',' << r.seed << ',' << r.simulatedSeconds << ',' << r.wallSeconds << ','
+            << r.maxPositionError << ',' << r.rmsPositionError << ',' << r.finalPositionError << '\n';
+        simulatedSeconds += r.simulatedSeconds;
+    }
+
+    unsigned int cores = jobThreadCount();
+    double realtimeFactor = simulatedSeconds / wallSeconds;
+    std::cout << "Batch: " << config.scenarios << " scenarios x " << config.dronesPerScenario << " drones, "
+        << simulatedSeconds << " s simulated in " << wallSeconds << " s on " << cores << " cores" << std::endl;
+    std::cout << "  " << realtimeFactor / cores << " sim-s per wall-s per core, "
+        << realtimeFactor * 60.0 * config.dronesPerScenario << " flight-min per hour" << std::endl;
+    std::cout << "  summary written to " << config.summaryPath << std::endl;
+    return 0;
+}
+
+// what-if: kazde rozgalezienie dostaje inny punkt docelowy i seed szumu
+int runRolloutBatch(const BatchConfig& config) {
+    SimState base;
+    initSimulation(base, config.dronesPerScenario);
+    base.seed = config.baseSeed;
+    SimScheduler scheduler;
+    registerSimulationSubsystems(scheduler, base);
+    runSchedulerUntil(scheduler, (uint64_t)(config.warmup * NANOSECONDS_PER_SECOND));
+
+    SnapshotArena arena;
+    initSnapshotArena(arena, base.drones.size(), 1);
+    size_t baseSlot = takeSnapshot(arena, base);
+
+    // koszt samego odtworzenia stanu
+    const int restoreCount = 1000;
+    SimState restored;
+    auto restoreStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < restoreCount; ++i)
+        restoreSnapshot(arena, baseSlot, restored);
+    double restoreSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - restoreStart).count() / restoreCount;
+
+    auto setup = [&](SimState& state, size_t rollout) {
+        float angle = (float)rollout / config.rollouts * 6.2831853f;
+        DroneCommand command = { ALL_DRONES, INITIAL_OFFSET * glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) };
+        applyDroneCommand(state, command);
+        state.seed = config.baseSeed + rollout + 1;
+    };
+
+    SnapshotArena results;
+    auto start = std::chrono::steady_clock::now();
+    runRollouts(arena, baseSlot, config.rollouts, config.duration, setup, results);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream out(config.summaryPath);
+    if (!out) {
+        std::cerr << "ERROR::BATCH::CANNOT_OPEN " << config.summaryPath << std::endl;
+        return -1;
+    }
+    out << "rollout,seed,final_error_m\n";
+    SimState state;
+    for (size_t i = 0; i < config.rollouts; ++i) {
+        restoreSnapshot(results, i, state);
+        float finalError = 0.0f;
+        for (const DroneState& drone : state.drones)
+            finalError = glm::max(finalError, glm::length(drone.position - drone.home));
+        out << i << ',' << state.seed << ',' << finalError << '\n';
+    }
+
+    unsigned int cores = jobThreadCount();
+    double simulatedSeconds = config.duration * config.rollouts;
+    std::cout << "Rollouts: " << config.rollouts << " x " << config.duration << " s from t=" << base.time
+        << " s, " << wallSeconds << " s wall on " << cores << " cores" << std::endl;
+    std::cout << "  snapshot " << arena.slotSize << " B, restore " << restoreSeconds * 1e6 << " us, "
+        << simulatedSeconds / wallSeconds / cores << " sim-s per wall-s per core" << std::endl;
+    std::cout << "  summary written to " << config.summaryPath << std::endl;
+    return 0;
+}
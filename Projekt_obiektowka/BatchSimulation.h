@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// tryb bez okna: N niezaleznych scenariuszy liczonych rownolegle tak szybko jak sie da
+struct BatchConfig {
+    unsigned int scenarios = 64;
+    unsigned int dronesPerScenario = 1;
+    double duration = 600.0;   // sekundy symulacji na scenariusz
+    uint64_t baseSeed = 1;
+    std::string summaryPath = "batch_summary.csv";
+    // > 0: zamiast scenariuszy jeden stan po rozgrzewce rozgaleziony na tyle wariantow
+    unsigned int rollouts = 0;
+    double warmup = 10.0;
+};
+
+struct ScenarioResult {
+    unsigned int index;
+    uint64_t seed;
+    double simulatedSeconds;
+    double wallSeconds;
+    float maxPositionError;
+    float rmsPositionError;
+    float finalPositionError;
+};
+
+bool parseBatchArguments(int argc, char** argv, BatchConfig& config);
+int runBatch(const BatchConfig& config);
+int runRolloutBatch(const BatchConfig& config);
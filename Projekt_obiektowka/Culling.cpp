@@ -0,0 +1,38 @@
+#include "Culling.h"
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+    // wiersze macierzy (glm trzyma kolumny)
+    glm::mat4 m = glm::transpose(viewProjection);
+    Frustum frustum;
+    frustum.planes[0] = m[3] + m[0];  // lewa
+    frustum.planes[1] = m[3] - m[0];  // prawa
+    frustum.planes[2] = m[3] + m[1];  // dol
+    frustum.planes[3] = m[3] - m[1];  // gora
+    frustum.planes[4] = m[3] + m[2];  // blizsza
+    frustum.planes[5] = m[3] - m[2];  // dalsza
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+    for (const glm::vec4& plane : frustum.planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+size_t cullSpheres(const Frustum& frustum, const glm::vec4* spheres, size_t count, uint32_t* visible) {
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const glm::vec4& s = spheres[i];
+        // bez rozgalezien w petli po plaszczyznach - zapis zawsze, licznik rosnie tylko dla widocznych
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.planes)
+            inside &= plane.x * s.x + plane.y * s.y + plane.z * s.z + plane.w >= -s.w;
+        visible[visibleCount] = (uint32_t)i;
+        visibleCount += inside;
+    }
+    return visibleCount;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// plaszczyzny (nx, ny, nz, d) skierowane do wnetrza, znormalizowane
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+Frustum extractFrustum(const glm::mat4& viewProjection);
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+
+// spheres[i] = (srodek, promien); indeksy widocznych trafiaja do visible (miejsce na count), zwraca ich liczbe
+size_t cullSpheres(const Frustum& frustum, const glm::vec4* spheres, size_t count, uint32_t* visible);
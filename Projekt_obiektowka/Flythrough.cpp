@@ -0,0 +1,264 @@
+#include "Flythrough.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+const unsigned int DEFAULT_PATH_POINTS = 8;
+
+bool parseFlythroughArguments(int argc, char** argv, FlythroughConfig& config) {
+    bool flythrough = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+        if (std::strcmp(arg, "--flythrough") == 0) {
+            flythrough = true;
+            config.frames = (unsigned int)std::max(1, std::atoi(value));
+        }
+        else if (std::strcmp(arg, "--flythrough-path") == 0) config.pathFile = value;
+        else if (std::strcmp(arg, "--flythrough-budget") == 0) config.budgetMs = (float)std::atof(value);
+        else if (std::strcmp(arg, "--flythrough-radius") == 0) config.pathRadius = (float)std::atof(value);
+        else if (std::strcmp(arg, "--flythrough-hidden") == 0) config.hidden = true;
+        else if (std::strcmp(arg, "--flythrough-out") == 0) config.framesPath = value;
+        else if (std::strcmp(arg, "--flythrough-baseline") == 0) config.baselinePath = value;
+        else if (std::strcmp(arg, "--flythrough-save-baseline") == 0) config.saveBaselinePath = value;
+    }
+    return flythrough;
+}
+
+bool initFlythrough(Flythrough& flythrough, const FlythroughConfig& config) {
+    flythrough.config = config;
+    flythrough.frameMs.reserve(config.frames);
+    flythrough.cpuMs.reserve(config.frames);
+    flythrough.gpuMs.reserve(config.frames);
+
+    if (config.pathFile.empty()) {
+        // orbita z falujaca wysokoscia i promieniem, cel krazy blisko srodka
+        for (unsigned int i = 0; i < DEFAULT_PATH_POINTS; ++i) {
+            float angle = 6.2831853f * i / DEFAULT_PATH_POINTS;
+            float radius = config.pathRadius * (i % 2 ? 0.6f : 1.0f);
+            flythrough.positions.push_back(glm::vec3(radius * std::cos(angle), 0.3f * config.pathRadius * (1.0f + std::sin(2.0f * angle)), radius * std::sin(angle)));
+            flythrough.targets.push_back(0.15f * config.pathRadius * glm::vec3(std::cos(-angle), 0.0f, std::sin(-angle)));
+        }
+        return true;
+    }
+
+    std::ifstream in(config.pathFile);
+    if (!in) {
+        std::cerr << "ERROR::FLYTHROUGH::CANNOT_OPEN " << config.pathFile << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream values(line);
+        glm::vec3 position, target;
+        if (values >> position.x >> position.y >> position.z >> target.x >> target.y >> target.z) {
+            flythrough.positions.push_back(position);
+            flythrough.targets.push_back(target);
+        }
+    }
+    if (flythrough.positions.size() < 2) {
+        std::cerr << "ERROR::FLYTHROUGH::PATH_TOO_SHORT " << config.pathFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static glm::vec3 catmullRom(const std::vector<glm::vec3>& points, float t) {
+    size_t n = points.size();
+    float scaled = t * n;
+    size_t i = (size_t)scaled % n;
+    float u = scaled - std::floor(scaled);
+    const glm::vec3& p0 = points[(i + n - 1) % n];
+    const glm::vec3& p1 = points[i];
+    const glm::vec3& p2 = points[(i + 1) % n];
+    const glm::vec3& p3 = points[(i + 2) % n];
+    float u2 = u * u, u3 = u2 * u;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+}
+
+void flythroughCamera(const Flythrough& flythrough, unsigned int frame, glm::vec3& position, glm::vec3& target) {
+    float t = (float)frame / flythrough.config.frames;
+    position = catmullRom(flythrough.positions, t);
+    target = catmullRom(flythrough.targets, t);
+}
+
+void recordFlythroughFrame(Flythrough& flythrough, float cpuMs, float frameMs) {
+    flythrough.cpuMs.push_back(cpuMs);
+    flythrough.frameMs.push_back(frameMs);
+}
+
+void recordFlythroughGpu(Flythrough& flythrough, float gpuMs) {
+    flythrough.gpuMs.push_back(gpuMs);
+}
+
+bool flythroughFinished(const Flythrough& flythrough) {
+    return flythrough.frameMs.size() >= flythrough.config.frames;
+}
+
+static double percentileOf(std::vector<float> values, double fraction) {
+    if (values.empty())
+        return 0.0;
+    size_t n = (size_t)(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+static double meanOf(const std::vector<float>& values) {
+    double sum = 0.0;
+    for (float v : values)
+        sum += v;
+    return values.empty() ? 0.0 : sum / values.size();
+}
+
+FlythroughStats computeFlythroughStats(const Flythrough& flythrough) {
+    FlythroughStats stats;
+    const std::vector<float>& frames = flythrough.frameMs;
+    stats.frames = (unsigned int)frames.size();
+    if (frames.empty())
+        return stats;
+
+    stats.meanMs = meanOf(frames);
+    double squares = 0.0;
+    for (float v : frames)
+        squares += (v - stats.meanMs) * (v - stats.meanMs);
+    stats.varianceMs = frames.size() > 1 ? squares / (frames.size() - 1) : 0.0;
+    stats.p50 = percentileOf(frames, 0.50);
+    stats.p95 = percentileOf(frames, 0.95);
+    stats.p99 = percentileOf(frames, 0.99);
+    stats.maxMs = *std::max_element(frames.begin(), frames.end());
+    for (float v : frames) {
+        stats.overBudget += v > flythrough.config.budgetMs;
+        stats.hitches += v > 2.0 * stats.p50;
+    }
+    stats.cpuMeanMs = meanOf(flythrough.cpuMs);
+    stats.gpuMeanMs = meanOf(flythrough.gpuMs);
+    return stats;
+}
+
+// regularyzowana niepelna funkcja beta (ulamek lancuchowy, Numerical Recipes)
+static double betaContinuedFraction(double a, double b, double x) {
+    const double tiny = 1e-300;
+    double c = 1.0, d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+    for (int m = 1; m <= 200; ++m) {
+        double m2 = 2.0 * m;
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + aa * d; d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + aa / c; c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + aa * d; d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + aa / c; c = std::fabs(c) < tiny ? tiny : c;
+        double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1.0) < 1e-12)
+            break;
+    }
+    return h;
+}
+
+static double incompleteBeta(double a, double b, double x) {
+    if (x <= 0.0) return 0.0;
+    if (x >= 1.0) return 1.0;
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+    if (x < (a + 1.0) / (a + b + 2.0))
+        return front * betaContinuedFraction(a, b, x) / a;
+    return 1.0 - front * betaContinuedFraction(b, a, 1.0 - x) / b;
+}
+
+double welchSlowdownPValue(const FlythroughStats& baseline, const FlythroughStats& current) {
+    if (baseline.frames < 2 || current.frames < 2)
+        return 1.0;
+    double vb = baseline.varianceMs / baseline.frames;
+    double vc = current.varianceMs / current.frames;
+    if (vb + vc <= 0.0)
+        return current.meanMs > baseline.meanMs ? 0.0 : 1.0;
+    double t = (current.meanMs - baseline.meanMs) / std::sqrt(vb + vc);
+    double df = (vb + vc) * (vb + vc) / (vb * vb / (baseline.frames - 1) + vc * vc / (current.frames - 1));
+    // P(T > t) dla rozkladu t-Studenta z df stopniami swobody
+    double tail = 0.5 * incompleteBeta(0.5 * df, 0.5, df / (df + t * t));
+    return t > 0.0 ? tail : 1.0 - tail;
+}
+
+static bool writeStats(const std::string& path, const FlythroughStats& stats) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out << "frames " << stats.frames << "\nmean_ms " << stats.meanMs << "\nvariance_ms " << stats.varianceMs
+        << "\np50_ms " << stats.p50 << "\np95_ms " << stats.p95 << "\np99_ms " << stats.p99 << "\nmax_ms " << stats.maxMs
+        << "\nover_budget " << stats.overBudget << "\nhitches " << stats.hitches
+        << "\ncpu_mean_ms " << stats.cpuMeanMs << "\ngpu_mean_ms " << stats.gpuMeanMs << "\n";
+    return true;
+}
+
+static bool readStats(const std::string& path, FlythroughStats& stats) {
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string key;
+    double value;
+    while (in >> key >> value) {
+        if (key == "frames") stats.frames = (unsigned int)value;
+        else if (key == "mean_ms") stats.meanMs = value;
+        else if (key == "variance_ms") stats.varianceMs = value;
+        else if (key == "p50_ms") stats.p50 = value;
+        else if (key == "p95_ms") stats.p95 = value;
+        else if (key == "p99_ms") stats.p99 = value;
+        else if (key == "max_ms") stats.maxMs = value;
+        else if (key == "over_budget") stats.overBudget = (unsigned int)value;
+        else if (key == "hitches") stats.hitches = (unsigned int)value;
+        else if (key == "cpu_mean_ms") stats.cpuMeanMs = value;
+        else if (key == "gpu_mean_ms") stats.gpuMeanMs = value;
+    }
+    return stats.frames > 0;
+}
+
+int finishFlythrough(const Flythrough& flythrough) {
+    const FlythroughConfig& config = flythrough.config;
+    if (!config.framesPath.empty()) {
+        std::ofstream out(config.framesPath);
+        out << "frame,frame_ms,cpu_ms,gpu_ms\n";
+        for (size_t i = 0; i < flythrough.frameMs.size(); ++i) {
+            // probki GPU w kolejnosci odbioru; niegotowe zapytania przepadaja, wiec kolumna bywa krotsza
+            out << i << ',' << flythrough.frameMs[i] << ',' << flythrough.cpuMs[i] << ',';
+            if (i < flythrough.gpuMs.size())
+                out << flythrough.gpuMs[i];
+            out << '\n';
+        }
+    }
+
+    FlythroughStats stats = computeFlythroughStats(flythrough);
+    std::cout << "Flythrough: " << stats.frames << " frames, mean " << stats.meanMs << " ms, p50 " << stats.p50
+        << " p95 " << stats.p95 << " p99 " << stats.p99 << " max " << stats.maxMs << " ms" << std::endl;
+    std::cout << "  over " << config.budgetMs << " ms budget: " << stats.overBudget << " frames, hitches (>2x median): "
+        << stats.hitches << std::endl;
+    std::cout << "  CPU " << stats.cpuMeanMs << " ms, GPU " << stats.gpuMeanMs << " ms -> "
+        << (stats.gpuMeanMs > stats.cpuMeanMs ? "GPU" : "CPU") << " bound" << std::endl;
+
+    if (!config.saveBaselinePath.empty() && !writeStats(config.saveBaselinePath, stats))
+        std::cerr << "ERROR::FLYTHROUGH::CANNOT_WRITE " << config.saveBaselinePath << std::endl;
+
+    if (config.baselinePath.empty())
+        return 0;
+    FlythroughStats baseline;
+    if (!readStats(config.baselinePath, baseline)) {
+        std::cerr << "ERROR::FLYTHROUGH::CANNOT_READ_BASELINE " << config.baselinePath << std::endl;
+        return 1;
+    }
+    double pValue = welchSlowdownPValue(baseline, stats);
+    double slowdown = baseline.meanMs > 0.0 ? stats.meanMs / baseline.meanMs - 1.0 : 0.0;
+    std::cout << "  vs baseline: mean " << baseline.meanMs << " -> " << stats.meanMs << " ms (" << slowdown * 100.0
+        << "%), p95 " << baseline.p95 << " -> " << stats.p95 << " ms, Welch p = " << pValue << std::endl;
+    if (pValue < config.alpha && slowdown > config.minSlowdown) {
+        std::cerr << "REGRESSION: frame time " << slowdown * 100.0 << "% slower than baseline (p = " << pValue << ")" << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// przelot kamery po zamknietej krzywej Catmulla-Roma: klatka i -> punkt i / frames krzywej,
+// wiec kazdy przebieg pokazuje dokladnie te same widoki niezaleznie od szybkosci
+struct FlythroughConfig {
+    unsigned int frames = 2000;
+    float budgetMs = 16.67f;
+    float pathRadius = 8.0f;
+    bool hidden = false;  // okno niewidoczne, bez vsync
+    std::string pathFile;  // linie "px py pz tx ty tz", puste - domyslna orbita
+    std::string framesPath = "flythrough_frames.csv";
+    std::string baselinePath;
+    std::string saveBaselinePath;
+    // regresja = istotny wzrost sredniej (p < alpha) i co najmniej o tyle wzglednie
+    double alpha = 0.01;
+    double minSlowdown = 0.05;
+};
+
+struct FlythroughStats {
+    unsigned int frames = 0;
+    double meanMs = 0.0, varianceMs = 0.0;
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0, maxMs = 0.0;
+    unsigned int overBudget = 0;
+    unsigned int hitches = 0;  // klatki dluzsze niz 2x mediana
+    double cpuMeanMs = 0.0, gpuMeanMs = 0.0;
+};
+
+struct Flythrough {
+    FlythroughConfig config;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> targets;
+    std::vector<float> frameMs;
+    std::vector<float> cpuMs;
+    std::vector<float> gpuMs;
+};
+
+// --flythrough N [--flythrough-path plik --flythrough-budget ms --flythrough-radius r --flythrough-hidden
+//  --flythrough-out plik.csv --flythrough-baseline plik --flythrough-save-baseline plik]
+bool parseFlythroughArguments(int argc, char** argv, FlythroughConfig& config);
+bool initFlythrough(Flythrough& flythrough, const FlythroughConfig& config);
+void flythroughCamera(const Flythrough& flythrough, unsigned int frame, glm::vec3& position, glm::vec3& target);
+
+void recordFlythroughFrame(Flythrough& flythrough, float cpuMs, float frameMs);
+// probki GPU przychodza z opoznieniem kilku klatek
+void recordFlythroughGpu(Flythrough& flythrough, float gpuMs);
+bool flythroughFinished(const Flythrough& flythrough);
+
+FlythroughStats computeFlythroughStats(const Flythrough& flythrough);
+// jednostronny test Welcha: p-wartosc hipotezy, ze current jest wolniejszy niz baseline
+double welchSlowdownPValue(const FlythroughStats& baseline, const FlythroughStats& current);
+// zapis CSV klatek, raport, zapis/porownanie z baseline; 0 - ok, 2 - regresja
+int finishFlythrough(const Flythrough& flythrough);
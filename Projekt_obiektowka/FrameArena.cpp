@@ -0,0 +1,116 @@
+#include "FrameArena.h"
+#include <atomic>
+#include <cstdlib>
+
+static std::atomic<uint64_t> currentFrame{ 0 };
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void* alignedBlock(size_t size, size_t alignment) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    // posix_memalign wymaga wielokrotnosci sizeof(void*)
+    void* memory = nullptr;
+    if (alignment < sizeof(void*))
+        alignment = sizeof(void*);
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+#endif
+}
+
+static void freeBlock(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void* arenaAllocate(LinearArena& arena, size_t size, size_t alignment) {
+    // wyrownany adres, nie przesuniecie - bufor ma tylko FRAME_ARENA_ALIGNMENT, alignas(64) wymaga wiecej
+    uintptr_t base = (uintptr_t)arena.memory;
+    size_t offset = alignUp(base + arena.used, alignment) - base;
+    if (arena.memory && offset + size <= arena.capacity) {
+        arena.used = offset + size;
+        if (arena.used + arena.overflowBytes > arena.peak)
+            arena.peak = arena.used + arena.overflowBytes;
+        return arena.memory + offset;
+    }
+
+    // brak miejsca: osobny blok do konca cyklu
+    void* block = alignedBlock(alignUp(size ? size : 1, alignment), alignment);
+    if (!block)
+        throw std::bad_alloc();
+    arena.overflow.push_back(block);
+    arena.overflowBytes += size + alignment;
+    if (arena.used + arena.overflowBytes > arena.peak)
+        arena.peak = arena.used + arena.overflowBytes;
+    return block;
+}
+
+void resetArena(LinearArena& arena) {
+    if (!arena.overflow.empty()) {
+        for (void* block : arena.overflow)
+            freeBlock(block);
+        arena.overflow.clear();
+        arena.overflowBytes = 0;
+    }
+    if (arena.peak > arena.capacity) {
+        // rosniemy z zapasem, zeby kolejne klatki zmiescily sie bez przepelnienia
+        size_t capacity = alignUp(arena.peak + arena.peak / 2, FRAME_ARENA_ALIGNMENT);
+        freeBlock(arena.memory);
+        arena.memory = static_cast<unsigned char*>(alignedBlock(capacity, FRAME_ARENA_ALIGNMENT));
+        if (!arena.memory)
+            throw std::bad_alloc();
+        arena.capacity = capacity;
+    }
+    arena.used = 0;
+    arena.peak = 0;
+}
+
+void releaseArena(LinearArena& arena) {
+    for (void* block : arena.overflow)
+        freeBlock(block);
+    arena.overflow.clear();
+    arena.overflowBytes = 0;
+    freeBlock(arena.memory);
+    arena.memory = nullptr;
+    arena.capacity = arena.used = arena.peak = 0;
+}
+
+// para aren watku, klatka parzysta/nieparzysta
+struct ThreadFrameArenas {
+    LinearArena arenas[2];
+    uint64_t frame = UINT64_MAX;
+
+    ~ThreadFrameArenas() {
+        releaseArena(arenas[0]);
+        releaseArena(arenas[1]);
+    }
+};
+
+static thread_local ThreadFrameArenas threadArenas;
+
+LinearArena& frameArena() {
+    uint64_t frame = currentFrame.load(std::memory_order_acquire);
+    LinearArena& arena = threadArenas.arenas[frame & 1];
+    if (threadArenas.frame != frame) {
+        threadArenas.frame = frame;
+        if (!arena.memory) {
+            arena.memory = static_cast<unsigned char*>(alignedBlock(FRAME_ARENA_INITIAL_SIZE, FRAME_ARENA_ALIGNMENT));
+            arena.capacity = FRAME_ARENA_INITIAL_SIZE;
+        }
+        resetArena(arena);
+    }
+    return arena;
+}
+
+void advanceFrameArenas() {
+    currentFrame.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint64_t frameArenaFrame() {
+    return currentFrame.load(std::memory_order_acquire);
+}
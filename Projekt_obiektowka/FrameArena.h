@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+const size_t FRAME_ARENA_INITIAL_SIZE = 1 << 20;
+const size_t FRAME_ARENA_ALIGNMENT = 16;
+
+// liniowy alokator: przesuniecie wskaznika, zwalnianie tylko calosci naraz
+struct LinearArena {
+    unsigned char* memory = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peak = 0;  // najwiekszy rozmiar w jednym cyklu (razem z przepelnieniem)
+    // przepelnienie idzie na sterte, przy resecie bufor rosnie do peak - w stanie ustalonym zero alokacji
+    std::vector<void*> overflow;
+    size_t overflowBytes = 0;
+};
+
+void* arenaAllocate(LinearArena& arena, size_t size, size_t alignment = FRAME_ARENA_ALIGNMENT);
+// O(1), chyba ze poprzedni cykl sie przepelnil - wtedy jednorazowo powieksza bufor
+void resetArena(LinearArena& arena);
+void releaseArena(LinearArena& arena);
+
+// arena biezacej klatki dla biezacego watku (osobna dla kazdego watku, bez blokad);
+// podwojne buforowanie: dane z klatki N zyja do konca klatki N + 1 (np. az GPU je zuzyje)
+LinearArena& frameArena();
+// koniec klatki (watek renderu) - kazdy watek zeruje swoja arene leniwie przy pierwszym uzyciu w nowej klatce
+void advanceFrameArenas();
+uint64_t frameArenaFrame();
+
+// adapter dla kontenerow STL, deallocate nic nie robi
+template <typename T>
+struct ArenaAllocator {
+    typedef T value_type;
+    LinearArena* arena;
+
+    ArenaAllocator() : arena(&frameArena()) {}
+    explicit ArenaAllocator(LinearArena& target) : arena(&target) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        size_t alignment = alignof(T) > FRAME_ARENA_ALIGNMENT ? alignof(T) : FRAME_ARENA_ALIGNMENT;
+        return static_cast<T*>(arenaAllocate(*arena, count * sizeof(T), alignment));
+    }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// wektor na arenie klatki - nie moze przezyc nastepnej klatki
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
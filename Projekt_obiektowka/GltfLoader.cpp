@@ -0,0 +1,801 @@
+#include "GltfLoader.h"
+#include "AssetIO.h"
+#include "MeshRegistry.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+// JSON: plaska tablica tokenow (jak jsmn), tekst nie jest kopiowany ani dekodowany
+enum JsonType {
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_PRIMITIVE
+};
+
+struct JsonToken {
+    JsonType type;
+    uint32_t start, end;  // napis bez cudzyslowow
+    uint32_t children;    // bezposrednie dzieci - w obiekcie klucze i wartosci osobno
+    uint32_t next;        // pierwszy token za calym poddrzewem
+};
+
+struct Json {
+    const char* text = nullptr;
+    std::vector<JsonToken> tokens;
+};
+
+static bool parseJson(const char* text, size_t length, Json& json) {
+    PROFILE_FUNCTION();
+    json.text = text;
+    json.tokens.clear();
+    json.tokens.reserve(length / 8);
+    std::vector<uint32_t> open;
+    auto addToken = [&](JsonType type, size_t start, size_t end) {
+        if (!open.empty())
+            json.tokens[open.back()].children++;
+        uint32_t index = (uint32_t)json.tokens.size();
+        json.tokens.push_back({ type, (uint32_t)start, (uint32_t)end, 0, index + 1 });
+        return index;
+    };
+    for (size_t i = 0; i < length; ++i) {
+        char c = text[i];
+        switch (c) {
+        case '{':
+        case '[':
+            open.push_back(addToken(c == '{' ? JSON_OBJECT : JSON_ARRAY, i, i));
+            break;
+        case '}':
+        case ']': {
+            if (open.empty() || json.tokens[open.back()].type != (c == '}' ? JSON_OBJECT : JSON_ARRAY))
+                return false;
+            JsonToken& container = json.tokens[open.back()];
+            container.end = (uint32_t)(i + 1);
+            container.next = (uint32_t)json.tokens.size();
+            open.pop_back();
+            break;
+        }
+        case '"': {
+            size_t end = i + 1;
+            while (end < length && text[end] != '"')
+                end += text[end] == '\\' ? 2 : 1;
+            if (end >= length)
+                return false;
+            addToken(JSON_STRING, i + 1, end);
+            i = end;
+            break;
+        }
+        case ' ': case '\t': case '\r': case '\n': case ',': case ':': case '\0':
+            break;
+        default: {
+            if (!std::strchr("-0123456789tfn", c))
+                return false;
+            size_t end = i;
+            while (end < length && text[end] && !std::strchr(" \t\r\n,:]}", text[end]))
+                ++end;
+            addToken(JSON_PRIMITIVE, i, end);
+            i = end - 1;
+            break;
+        }
+        }
+    }
+    return open.empty() && !json.tokens.empty() && json.tokens[0].type == JSON_OBJECT;
+}
+
+static bool jsonEquals(const Json& json, int token, const char* value) {
+    const JsonToken& t = json.tokens[token];
+    size_t length = std::strlen(value);
+    return t.type == JSON_STRING && t.end - t.start == length && std::memcmp(json.text + t.start, value, length) == 0;
+}
+
+// wartosc klucza albo -1
+static int jsonMember(const Json& json, int object, const char* key) {
+    if (object < 0 || json.tokens[object].type != JSON_OBJECT)
+        return -1;
+    uint32_t child = (uint32_t)object + 1;
+    for (uint32_t pair = 0; pair < json.tokens[object].children / 2; ++pair) {
+        uint32_t value = json.tokens[child].next;
+        if (jsonEquals(json, child, key))
+            return (int)value;
+        child = json.tokens[value].next;
+    }
+    return -1;
+}
+
+// indeksy tokenow elementow tablicy (pusto dla -1) - potem dostep bez przechodzenia tablicy od poczatku
+static std::vector<int> jsonElements(const Json& json, int array) {
+    std::vector<int> elements;
+    if (array < 0 || json.tokens[array].type != JSON_ARRAY)
+        return elements;
+    elements.reserve(json.tokens[array].children);
+    uint32_t child = (uint32_t)array + 1;
+    for (uint32_t i = 0; i < json.tokens[array].children; ++i) {
+        elements.push_back((int)child);
+        child = json.tokens[child].next;
+    }
+    return elements;
+}
+
+static double jsonNumber(const Json& json, int token, double fallback) {
+    if (token < 0 || json.tokens[token].type != JSON_PRIMITIVE)
+        return fallback;
+    return std::strtod(json.text + json.tokens[token].start, nullptr);
+}
+
+// liczby z pliku przed rzutowaniem na typ calkowity: ujemna, NaN albo poza zakresem to UB.
+// Brak klucza -> fallback; wartosc ulamkowa albo poza zakresem -> false
+static bool jsonSize(const Json& json, int token, size_t fallback, size_t& out) {
+    double value = jsonNumber(json, token, (double)fallback);
+    // 2^53 - powyzej double nie trzyma juz kazdej liczby calkowitej
+    double limit = std::min(9007199254740992.0, (double)SIZE_MAX);
+    if (!std::isfinite(value) || value < 0.0 || value > limit || value != std::floor(value))
+        return false;
+    out = (size_t)value;
+    return true;
+}
+
+// indeks w tablicy pliku, brak klucza -> -1
+static bool jsonIndex(const Json& json, int token, int& out) {
+    double value = jsonNumber(json, token, -1.0);
+    if (value == -1.0) {
+        out = -1;
+        return true;
+    }
+    if (!std::isfinite(value) || value < 0.0 || value > (double)INT_MAX || value != std::floor(value))
+        return false;
+    out = (int)value;
+    return true;
+}
+
+static std::string jsonString(const Json& json, int token) {
+    if (token < 0 || json.tokens[token].type != JSON_STRING)
+        return std::string();
+    return std::string(json.text + json.tokens[token].start, json.tokens[token].end - json.tokens[token].start);
+}
+
+const uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+
+const uint32_t GLTF_UNSIGNED_BYTE = 5121;
+const uint32_t GLTF_UNSIGNED_SHORT = 5123;
+const uint32_t GLTF_UNSIGNED_INT = 5125;
+const uint32_t GLTF_FLOAT = 5126;
+const int GLTF_TRIANGLES = 4;
+
+struct GltfBuffer {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// akcesor po walidacji: wskaznik w zmapowany bufor, krok miedzy elementami
+struct GltfAccessor {
+    const unsigned char* data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;
+    uint32_t componentType = 0;
+    uint32_t components = 0;
+};
+
+// data == nullptr w normals/texcoords/indices - brak atrybutu, material < 0 - bez materialu
+struct GltfPrimitive {
+    GltfAccessor positions, normals, texcoords, indices;
+    int material = -1;
+};
+
+// zmapowane pliki (albo wpisy paczki) i zdekodowane bufory data: zyja do konca loadGltf (GL kopiuje przy glBufferData)
+struct GltfFile {
+    Json json;
+    std::vector<AssetData> mapped;
+    std::vector<std::vector<unsigned char>> decoded;
+    std::vector<GltfBuffer> buffers;
+
+    ~GltfFile() {
+        for (AssetData& asset : mapped)
+            closeAsset(asset);
+    }
+};
+
+bool isGltfPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string extension = path.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+    return extension == ".gltf" || extension == ".glb";
+}
+
+static uint32_t readUint32(const unsigned char* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static bool decodeBase64(const char* text, size_t length, std::vector<unsigned char>& out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.reserve(length * 3 / 4);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (size_t i = 0; i < length && text[i] != '='; ++i) {
+        const char* position = text[i] ? std::strchr(alphabet, text[i]) : nullptr;
+        if (!position)
+            return false;
+        bits = (bits << 6) | (uint32_t)(position - alphabet);
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back((unsigned char)(bits >> bitCount));
+        }
+    }
+    return true;
+}
+
+// %20 itd. w wzglednych URI
+static std::string decodeUri(const std::string& uri) {
+    std::string path;
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size()) {
+            path += (char)std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            path += uri[i];
+        }
+    }
+    return path;
+}
+
+static bool openGltf(const std::string& path, GltfFile& file) {
+    PROFILE_FUNCTION();
+    AssetData main;
+    bool opened = openAsset(path, main);
+    if (opened)
+        file.mapped.push_back(main);
+    if (!opened || !main.data) {
+        std::cerr << "ERROR::GLTF::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+
+    // .glb: naglowek 12 B, chunk JSON, opcjonalnie chunk BIN (bufor 0 bez uri)
+    const char* jsonText = (const char*)main.data;
+    size_t jsonLength = main.size;
+    GltfBuffer binChunk;
+    if (main.size >= 12 && readUint32(main.data) == GLB_MAGIC) {
+        size_t offset = 12;
+        jsonLength = 0;
+        while (offset + 8 <= main.size) {
+            size_t chunkLength = readUint32(main.data + offset);
+            uint32_t chunkType = readUint32(main.data + offset + 4);
+            if (offset + 8 + chunkLength > main.size)
+                break;
+            if (chunkType == GLB_CHUNK_JSON && jsonLength == 0) {
+                jsonText = (const char*)main.data + offset + 8;
+                jsonLength = chunkLength;
+            } else if (chunkType == GLB_CHUNK_BIN && !binChunk.data) {
+                binChunk.data = main.data + offset + 8;
+                binChunk.size = chunkLength;
+            }
+            offset += 8 + ((chunkLength + 3) & ~(size_t)3);
+        }
+    }
+    if (!parseJson(jsonText, jsonLength, file.json)) {
+        std::cerr << "ERROR::GLTF::INVALID_JSON " << path << std::endl;
+        return false;
+    }
+
+    size_t slash = path.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    std::vector<int> buffers = jsonElements(file.json, jsonMember(file.json, 0, "buffers"));
+    file.buffers.resize(buffers.size());
+    file.decoded.reserve(buffers.size());
+    for (size_t b = 0; b < buffers.size(); ++b) {
+        std::string uri = jsonString(file.json, jsonMember(file.json, buffers[b], "uri"));
+        size_t byteLength;
+        if (!jsonSize(file.json, jsonMember(file.json, buffers[b], "byteLength"), 0, byteLength)) {
+            std::cerr << "ERROR::GLTF::INVALID_BUFFER buffer " << b << std::endl;
+            return false;
+        }
+        GltfBuffer& buffer = file.buffers[b];
+        if (uri.empty()) {
+            buffer = binChunk;
+        } else if (uri.compare(0, 5, "data:") == 0) {
+            size_t comma = uri.find(";base64,");
+            file.decoded.emplace_back();
+            if (comma == std::string::npos || !decodeBase64(uri.c_str() + comma + 8, uri.size() - comma - 8, file.decoded.back())) {
+                std::cerr << "ERROR::GLTF::INVALID_DATA_URI buffer " << b << std::endl;
+                return false;
+            }
+            buffer.data = file.decoded.back().data();
+            buffer.size = file.decoded.back().size();
+        } else {
+            AssetData bin;
+            std::string binPath = directory + decodeUri(uri);
+            if (!openAsset(binPath, bin)) {
+                std::cerr << "ERROR::GLTF::CANNOT_OPEN " << binPath << std::endl;
+                return false;
+            }
+            file.mapped.push_back(bin);
+            buffer.data = bin.data;
+            buffer.size = bin.size;
+        }
+        if (buffer.size < byteLength) {
+            std::cerr << "ERROR::GLTF::BUFFER_TOO_SHORT buffer " << b << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t componentSize(uint32_t componentType) {
+    switch (componentType) {
+    case 5120: case GLTF_UNSIGNED_BYTE: return 1;
+    case 5122: case GLTF_UNSIGNED_SHORT: return 2;
+    case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+static uint32_t typeComponents(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+struct GltfTables {
+    std::vector<int> accessors, views, meshes, nodes;
+};
+
+static bool readAccessor(const GltfFile& file, const GltfTables& tables, int index, GltfAccessor& out) {
+    const Json& json = file.json;
+    if (index < 0 || index >= (int)tables.accessors.size())
+        return false;
+    int accessor = tables.accessors[index];
+    int viewIndex;
+    // akcesor bez bufferView (same zera) i sparse - rzadkie w eksportach, zostawiamy Assimpowi
+    if (!jsonIndex(json, jsonMember(json, accessor, "bufferView"), viewIndex) || jsonMember(json, accessor, "sparse") >= 0
+        || viewIndex < 0 || viewIndex >= (int)tables.views.size())
+        return false;
+    int view = tables.views[viewIndex];
+    int bufferIndex;
+    if (!jsonIndex(json, jsonMember(json, view, "buffer"), bufferIndex) || bufferIndex < 0
+        || bufferIndex >= (int)file.buffers.size())
+        return false;
+    const GltfBuffer& buffer = file.buffers[bufferIndex];
+    size_t viewOffset, viewLength, viewStride, offset, componentType;
+    if (!jsonSize(json, jsonMember(json, view, "byteOffset"), 0, viewOffset)
+        || !jsonSize(json, jsonMember(json, view, "byteLength"), 0, viewLength)
+        || !jsonSize(json, jsonMember(json, view, "byteStride"), 0, viewStride)
+        || !jsonSize(json, jsonMember(json, accessor, "byteOffset"), 0, offset)
+        || !jsonSize(json, jsonMember(json, accessor, "componentType"), 0, componentType)
+        || !jsonSize(json, jsonMember(json, accessor, "count"), 0, out.count))
+        return false;
+
+    out.componentType = componentType <= UINT32_MAX ? (uint32_t)componentType : 0;
+    out.components = typeComponents(jsonString(json, jsonMember(json, accessor, "type")));
+    size_t elementSize = componentSize(out.componentType) * out.components;
+    out.stride = viewStride ? viewStride : elementSize;
+    // kazda suma i iloczyn z pliku sprawdzane bez przepelnienia: ostatni element konczy sie w widoku
+    if (elementSize == 0 || out.count == 0 || out.stride < elementSize || viewOffset > buffer.size
+        || viewLength > buffer.size - viewOffset || offset > viewLength || elementSize > viewLength - offset
+        || out.count - 1 > (viewLength - offset - elementSize) / out.stride)
+        return false;
+    out.data = buffer.data + viewOffset + offset;
+    return true;
+}
+
+static void readVec3(const GltfAccessor& accessor, glm::vec3* out) {
+    if (accessor.stride == sizeof(glm::vec3)) {
+        std::memcpy(out, accessor.data, accessor.count * sizeof(glm::vec3));
+        return;
+    }
+    for (size_t i = 0; i < accessor.count; ++i)
+        std::memcpy(&out[i], accessor.data + i * accessor.stride, sizeof(glm::vec3));
+}
+
+static void readVec2(const GltfAccessor& accessor, glm::vec2* out) {
+    if (accessor.stride == sizeof(glm::vec2)) {
+        std::memcpy(out, accessor.data, accessor.count * sizeof(glm::vec2));
+        return;
+    }
+    for (size_t i = 0; i < accessor.count; ++i)
+        std::memcpy(&out[i], accessor.data + i * accessor.stride, sizeof(glm::vec2));
+}
+
+static bool isIndexType(uint32_t componentType) {
+    return componentType == GLTF_UNSIGNED_BYTE || componentType == GLTF_UNSIGNED_SHORT || componentType == GLTF_UNSIGNED_INT;
+}
+
+// tylko typy z isIndexType - glTF nie dopuszcza indeksow ze znakiem
+static uint32_t readIndex(const GltfAccessor& accessor, size_t i) {
+    const unsigned char* element = accessor.data + i * accessor.stride;
+    switch (accessor.componentType) {
+    case GLTF_UNSIGNED_BYTE:
+        return *element;
+    case GLTF_UNSIGNED_SHORT: {
+        uint16_t value;
+        std::memcpy(&value, element, sizeof(value));
+        return value;
+    }
+    default:
+        return readUint32(element);
+    }
+}
+
+static void readIndices(const GltfPrimitive& primitive, unsigned int* out) {
+    if (!primitive.indices.data) {
+        for (size_t i = 0; i < primitive.positions.count; ++i)
+            out[i] = (unsigned int)i;
+        return;
+    }
+    if (primitive.indices.componentType == GLTF_UNSIGNED_INT && primitive.indices.stride == sizeof(unsigned int)) {
+        std::memcpy(out, primitive.indices.data, primitive.indices.count * sizeof(unsigned int));
+        return;
+    }
+    for (size_t i = 0; i < primitive.indices.count; ++i)
+        out[i] = readIndex(primitive.indices, i);
+}
+
+static size_t primitiveIndexCount(const GltfPrimitive& primitive) {
+    return primitive.indices.data ? primitive.indices.count : primitive.positions.count;
+}
+
+// brak NORMAL w pliku - normalne wierzcholkow usrednione z trojkatow (wagi = pola)
+static void computeNormals(const glm::vec3* positions, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+    glm::vec3* normals) {
+    std::fill(normals, normals + vertexCount, glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        glm::vec3 a = positions[indices[i]], b = positions[indices[i + 1]], c = positions[indices[i + 2]];
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        normals[indices[i]] += normal;
+        normals[indices[i + 1]] += normal;
+        normals[indices[i + 2]] += normal;
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (glm::length(normals[v]) > 0.0f)
+            normals[v] = glm::normalize(normals[v]);
+    }
+}
+
+static bool readPrimitive(const GltfFile& file, const GltfTables& tables, int token, GltfPrimitive& primitive) {
+    const Json& json = file.json;
+    size_t mode;
+    if (!jsonSize(json, jsonMember(json, token, "mode"), GLTF_TRIANGLES, mode) || mode != (size_t)GLTF_TRIANGLES)
+        return false;
+    int attributes = jsonMember(json, token, "attributes");
+    int positions, normals, texcoords, indices;
+    if (!jsonIndex(json, jsonMember(json, attributes, "POSITION"), positions)
+        || !jsonIndex(json, jsonMember(json, attributes, "NORMAL"), normals)
+        || !jsonIndex(json, jsonMember(json, attributes, "TEXCOORD_0"), texcoords)
+        || !jsonIndex(json, jsonMember(json, token, "indices"), indices)
+        || !jsonIndex(json, jsonMember(json, token, "material"), primitive.material))
+        return false;
+    if (!readAccessor(file, tables, positions, primitive.positions)
+        || primitive.positions.componentType != GLTF_FLOAT || primitive.positions.components != 3)
+        return false;
+    if (normals >= 0 && (!readAccessor(file, tables, normals, primitive.normals)
+        || primitive.normals.componentType != GLTF_FLOAT || primitive.normals.components != 3
+        || primitive.normals.count != primitive.positions.count))
+        return false;
+    // UV tylko jako float - znormalizowane bajty/shorty (KHR_mesh_quantization) siatka dostaje bez tekstury
+    if (texcoords >= 0 && (!readAccessor(file, tables, texcoords, primitive.texcoords)
+        || primitive.texcoords.componentType != GLTF_FLOAT || primitive.texcoords.components != 2
+        || primitive.texcoords.count != primitive.positions.count))
+        primitive.texcoords = GltfAccessor();
+    if (indices >= 0) {
+        if (!readAccessor(file, tables, indices, primitive.indices)
+            || primitive.indices.components != 1 || !isIndexType(primitive.indices.componentType))
+            return false;
+        // indeksy poza tablica wierzcholkow nie moga trafic do GL
+        for (size_t i = 0; i < primitive.indices.count; ++i) {
+            if (readIndex(primitive.indices, i) >= primitive.positions.count)
+                return false;
+        }
+    }
+    return primitiveIndexCount(primitive) % 3 == 0;
+}
+
+// kopia do wektorow Mesh - bez posrednich struktur jak aiScene
+static void convertPrimitive(const GltfPrimitive& primitive, Mesh& mesh) {
+    size_t vertexCount = primitive.positions.count;
+    mesh.positions.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+    mesh.indices.resize(primitiveIndexCount(primitive));
+    readVec3(primitive.positions, mesh.positions.data());
+    readIndices(primitive, mesh.indices.data());
+    if (primitive.texcoords.data) {
+        mesh.texcoords.resize(vertexCount);
+        readVec2(primitive.texcoords, mesh.texcoords.data());
+    }
+    if (primitive.normals.data)
+        readVec3(primitive.normals, mesh.normals.data());
+    else
+        computeNormals(mesh.positions.data(), vertexCount, mesh.indices.data(), mesh.indices.size(), mesh.normals.data());
+}
+
+// ciasno upakowane akcesory ida do GL prosto z mapowania; kopia tylko przy przeplocie, waskich indeksach albo braku normalnych
+static void uploadPrimitive(const GltfPrimitive& primitive, Mesh& mesh) {
+    size_t vertexCount = primitive.positions.count;
+    size_t indexCount = primitiveIndexCount(primitive);
+    std::vector<glm::vec3> positionCopy, normalCopy;
+    std::vector<glm::vec2> texcoordCopy;
+    std::vector<unsigned int> indexCopy;
+
+    const glm::vec3* positions = (const glm::vec3*)primitive.positions.data;
+    if (primitive.positions.stride != sizeof(glm::vec3)) {
+        positionCopy.resize(vertexCount);
+        readVec3(primitive.positions, positionCopy.data());
+        positions = positionCopy.data();
+    }
+    const unsigned int* indices = (const unsigned int*)primitive.indices.data;
+    if (!primitive.indices.data || primitive.indices.componentType != GLTF_UNSIGNED_INT
+        || primitive.indices.stride != sizeof(unsigned int)) {
+        indexCopy.resize(indexCount);
+        readIndices(primitive, indexCopy.data());
+        indices = indexCopy.data();
+    }
+    const glm::vec3* normals = (const glm::vec3*)primitive.normals.data;
+    if (!primitive.normals.data) {
+        normalCopy.resize(vertexCount);
+        computeNormals(positions, vertexCount, indices, indexCount, normalCopy.data());
+        normals = normalCopy.data();
+    } else if (primitive.normals.stride != sizeof(glm::vec3)) {
+        normalCopy.resize(vertexCount);
+        readVec3(primitive.normals, normalCopy.data());
+        normals = normalCopy.data();
+    }
+    const glm::vec2* texcoords = (const glm::vec2*)primitive.texcoords.data;
+    if (primitive.texcoords.data && primitive.texcoords.stride != sizeof(glm::vec2)) {
+        texcoordCopy.resize(vertexCount);
+        readVec2(primitive.texcoords, texcoordCopy.data());
+        texcoords = texcoordCopy.data();
+    }
+    uploadMeshData(mesh, positions, normals, texcoords, vertexCount, indices, indexCount);
+}
+
+// material -> baseColorTexture -> textures[].source -> images[]: plik obok .gltf, data URI albo bufferView (.glb)
+static uint32_t imageTexture(const GltfFile& file, const GltfTables& tables, const std::string& path, int image) {
+    const Json& json = file.json;
+    std::vector<int> images = jsonElements(json, jsonMember(json, 0, "images"));
+    if (image < 0 || image >= (int)images.size())
+        return NO_TEXTURE;
+    std::string uri = jsonString(json, jsonMember(json, images[image], "uri"));
+    std::string name = path + "#image" + std::to_string(image);
+    if (uri.compare(0, 5, "data:") == 0) {
+        size_t comma = uri.find(";base64,");
+        std::vector<unsigned char> encoded;
+        if (comma == std::string::npos || !decodeBase64(uri.c_str() + comma + 8, uri.size() - comma - 8, encoded)) {
+            std::cerr << "ERROR::GLTF::INVALID_DATA_URI image " << image << std::endl;
+            return NO_TEXTURE;
+        }
+        return requestTextureFromMemory(name, encoded.data(), encoded.size());
+    }
+    if (!uri.empty()) {
+        size_t slash = path.find_last_of("/\\");
+        return requestTexture(path.substr(0, slash == std::string::npos ? 0 : slash + 1) + decodeUri(uri));
+    }
+    int viewIndex;
+    if (!jsonIndex(json, jsonMember(json, images[image], "bufferView"), viewIndex) || viewIndex < 0
+        || viewIndex >= (int)tables.views.size())
+        return NO_TEXTURE;
+    int view = tables.views[viewIndex];
+    int bufferIndex;
+    size_t offset, length;
+    if (!jsonIndex(json, jsonMember(json, view, "buffer"), bufferIndex) || bufferIndex < 0
+        || bufferIndex >= (int)file.buffers.size() || !jsonSize(json, jsonMember(json, view, "byteOffset"), 0, offset)
+        || !jsonSize(json, jsonMember(json, view, "byteLength"), 0, length))
+        return NO_TEXTURE;
+    // jak w readAccessor - bez sumy, ktora moglaby sie przekrecic
+    size_t size = file.buffers[bufferIndex].size;
+    if (offset > size || length > size - offset)
+        return NO_TEXTURE;
+    return requestTextureFromMemory(name, file.buffers[bufferIndex].data + offset, length);
+}
+
+static uint32_t materialTexture(const GltfFile& file, const GltfTables& tables, const std::string& path, int material) {
+    const Json& json = file.json;
+    std::vector<int> materials = jsonElements(json, jsonMember(json, 0, "materials"));
+    if (material < 0 || material >= (int)materials.size())
+        return NO_TEXTURE;
+    int pbr = jsonMember(json, materials[material], "pbrMetallicRoughness");
+    int texture, image;
+    std::vector<int> textures = jsonElements(json, jsonMember(json, 0, "textures"));
+    if (!jsonIndex(json, jsonMember(json, jsonMember(json, pbr, "baseColorTexture"), "index"), texture) || texture < 0
+        || texture >= (int)textures.size() || !jsonIndex(json, jsonMember(json, textures[texture], "source"), image))
+        return NO_TEXTURE;
+    return imageTexture(file, tables, path, image);
+}
+
+static glm::mat4 nodeTransform(const Json& json, int node) {
+    std::vector<int> matrix = jsonElements(json, jsonMember(json, node, "matrix"));
+    if (matrix.size() == 16) {
+        // glTF tez trzyma macierze kolumnami
+        float values[16];
+        for (int i = 0; i < 16; ++i)
+            values[i] = (float)jsonNumber(json, matrix[i], 0.0);
+        return glm::make_mat4(values);
+    }
+    glm::vec3 translation(0.0f), scale(1.0f);
+    glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+    std::vector<int> t = jsonElements(json, jsonMember(json, node, "translation"));
+    std::vector<int> r = jsonElements(json, jsonMember(json, node, "rotation"));
+    std::vector<int> s = jsonElements(json, jsonMember(json, node, "scale"));
+    if (t.size() == 3)
+        translation = glm::vec3(jsonNumber(json, t[0], 0.0), jsonNumber(json, t[1], 0.0), jsonNumber(json, t[2], 0.0));
+    // glTF: x, y, z, w
+    if (r.size() == 4)
+        rotation = glm::quat((float)jsonNumber(json, r[3], 1.0), (float)jsonNumber(json, r[0], 0.0),
+            (float)jsonNumber(json, r[1], 0.0), (float)jsonNumber(json, r[2], 0.0));
+    if (s.size() == 3)
+        scale = glm::vec3(jsonNumber(json, s[0], 1.0), jsonNumber(json, s[1], 1.0), jsonNumber(json, s[2], 1.0));
+    return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+// wszerz od sztucznego korzenia (jak w Assimp), indeksy siatek = indeksy prymitywow - przemapowane po uploadzie
+static bool buildGltfGraph(const Json& json, const GltfTables& tables, const std::vector<uint32_t>& firstPrimitive,
+    SceneGraph& graph) {
+    std::vector<int> roots;
+    std::vector<int> scenes = jsonElements(json, jsonMember(json, 0, "scenes"));
+    int scene;
+    if (!jsonIndex(json, jsonMember(json, 0, "scene"), scene))
+        return false;
+    if (scene < 0)
+        scene = 0;  // bez "scene" - pierwsza scena
+    if (scene >= 0 && scene < (int)scenes.size()) {
+        for (int token : jsonElements(json, jsonMember(json, scenes[scene], "nodes"))) {
+            roots.push_back(-1);
+            if (!jsonIndex(json, token, roots.back()))
+                return false;
+        }
+    } else {
+        // bez scen: wszystkie wezly, ktore nie sa niczyim dzieckiem
+        std::vector<char> isChild(tables.nodes.size(), 0);
+        for (int node : tables.nodes) {
+            for (int token : jsonElements(json, jsonMember(json, node, "children"))) {
+                int child;
+                if (!jsonIndex(json, token, child))
+                    return false;
+                if (child >= 0 && child < (int)isChild.size())
+                    isChild[child] = 1;
+            }
+        }
+        for (size_t n = 0; n < tables.nodes.size(); ++n) {
+            if (!isChild[n])
+                roots.push_back((int)n);
+        }
+    }
+
+    std::vector<int> order(1, -1);
+    std::vector<char> visited(tables.nodes.size(), 0);
+    graph.nodes.clear();
+    graph.meshIndices.clear();
+    graph.nodes.reserve(tables.nodes.size() + 1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        Node node;
+        std::vector<int> children = roots;
+        if (order[i] >= 0) {
+            int source = tables.nodes[order[i]];
+            node.transform = nodeTransform(json, source);
+            int mesh;
+            if (!jsonIndex(json, jsonMember(json, source, "mesh"), mesh))
+                return false;
+            node.firstMesh = (uint32_t)graph.meshIndices.size();
+            if (mesh >= 0 && mesh + 1 < (int)firstPrimitive.size()) {
+                for (uint32_t p = firstPrimitive[mesh]; p < firstPrimitive[mesh + 1]; ++p)
+                    graph.meshIndices.push_back(p);
+            }
+            node.meshCount = (uint32_t)graph.meshIndices.size() - node.firstMesh;
+            children.clear();
+            for (int token : jsonElements(json, jsonMember(json, source, "children"))) {
+                children.push_back(-1);
+                if (!jsonIndex(json, token, children.back()))
+                    return false;
+            }
+        }
+        node.firstChild = (uint32_t)order.size();
+        node.childCount = (uint32_t)children.size();
+        for (int child : children) {
+            // glTF wymaga drzewa - cykl albo dwoch rodzicow traktujemy jak uszkodzony plik
+            if (child < 0 || child >= (int)tables.nodes.size() || visited[child])
+                return false;
+            visited[child] = 1;
+            order.push_back(child);
+        }
+        graph.nodes.push_back(node);
+    }
+    return true;
+}
+
+bool loadGltf(const std::string& path, SceneGraph& graph, bool retainCpuData) {
+    PROFILE_FUNCTION();
+    GltfFile file;
+    if (!openGltf(path, file))
+        return false;
+    const Json& json = file.json;
+    if (jsonMember(json, 0, "extensionsRequired") >= 0) {
+        std::cerr << "ERROR::GLTF::UNSUPPORTED_EXTENSION " << path << std::endl;
+        return false;
+    }
+    GltfTables tables;
+    tables.accessors = jsonElements(json, jsonMember(json, 0, "accessors"));
+    tables.views = jsonElements(json, jsonMember(json, 0, "bufferViews"));
+    tables.meshes = jsonElements(json, jsonMember(json, 0, "meshes"));
+    tables.nodes = jsonElements(json, jsonMember(json, 0, "nodes"));
+
+    // 1. walidacja calego pliku, zanim cokolwiek trafi do meshes
+    std::vector<GltfPrimitive> primitives;
+    std::vector<uint32_t> firstPrimitive(tables.meshes.size() + 1, 0);
+    for (size_t m = 0; m < tables.meshes.size(); ++m) {
+        firstPrimitive[m] = (uint32_t)primitives.size();
+        for (int token : jsonElements(json, jsonMember(json, tables.meshes[m], "primitives"))) {
+            primitives.emplace_back();
+            if (!readPrimitive(file, tables, token, primitives.back())) {
+                std::cerr << "ERROR::GLTF::UNSUPPORTED_PRIMITIVE mesh " << m << " in " << path << std::endl;
+                return false;
+            }
+        }
+    }
+    firstPrimitive.back() = (uint32_t)primitives.size();
+    SceneGraph loadedGraph;
+    if (primitives.empty() || !buildGltfGraph(json, tables, firstPrimitive, loadedGraph)) {
+        std::cerr << "ERROR::GLTF::INVALID_SCENE " << path << std::endl;
+        return false;
+    }
+
+    // tekstura raz na material; bez UV nie ma czego probkowac
+    std::vector<uint32_t> textures(primitives.size(), NO_TEXTURE);
+    std::unordered_map<int, uint32_t> materialTextures;
+    for (size_t p = 0; p < primitives.size(); ++p) {
+        if (!primitives[p].texcoords.data || primitives[p].material < 0)
+            continue;
+        auto known = materialTextures.find(primitives[p].material);
+        if (known == materialTextures.end())
+            known = materialTextures.emplace(primitives[p].material, materialTexture(file, tables, path, primitives[p].material)).first;
+        textures[p] = known->second;
+    }
+
+    // 2. siatki: z kopia CPU rownolegle + MeshRegistry, bez kopii - upload prosto z mapowania
+    std::vector<unsigned int> meshIndex(primitives.size());
+    if (retainCpuData) {
+        std::vector<Mesh> loaded(primitives.size());
+        parallelFor(0, primitives.size(), [&](size_t p) {
+            convertPrimitive(primitives[p], loaded[p]);
+            loaded[p].contentHash = meshContentHash(loaded[p]);
+            loaded[p].texture = textures[p];
+        });
+        // graf trzyma jedna referencje na siatke - powtorzenie w pliku oddaje dodatkowa
+        std::unordered_set<unsigned int> held;
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            meshIndex[p] = acquireMesh(loaded[p], true);
+            if (!held.insert(meshIndex[p]).second)
+                releaseMesh(meshIndex[p]);
+        }
+    } else {
+        PROFILE_SCOPE("upload from mapping");
+        meshes.reserve(meshes.size() + primitives.size());
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            meshIndex[p] = (unsigned int)meshes.size();
+            meshes.emplace_back();
+            uploadPrimitive(primitives[p], meshes.back());
+            meshes.back().texture = textures[p];
+            meshes.back().references = 1;
+        }
+    }
+
+    for (unsigned int& index : loadedGraph.meshIndices)
+        index = meshIndex[index];
+    graph = std::move(loadedGraph);
+    return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "ModelLoader.h"
+
+// .gltf / .glb bez Assimp: bufory zmapowane w pamiec (MappedFile), JSON tokenizowany w miejscu,
+// dane akcesorow czytane prosto z mapowania; kazdy prymityw glTF = jedna Mesh (jak w Assimp)
+bool isGltfPath(const std::string& path);
+
+// retainCpuData - pozycje/normalne/indeksy zostaja w Mesh (MeshRegistry, statyczne paczki);
+// false - ciasno upakowane akcesory ida do GL prosto z mapowania, bez zadnej kopii po stronie CPU.
+// false przy bledzie albo nieobslugiwanej funkcji (sparse, kompresja, inne niz trojkaty) - nic nie zostaje
+// dodane do meshes, wolajacy moze sprobowac przez Assimp
+bool loadGltf(const std::string& path, SceneGraph& graph, bool retainCpuData);
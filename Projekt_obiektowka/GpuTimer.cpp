@@ -0,0 +1,138 @@
+#include "GpuTimer.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+const float OVERLAY_FULL_SCALE_MS = 33.3f;
+const int OVERLAY_BAR_HEIGHT = 6;
+const int OVERLAY_BAR_GAP = 3;
+const int OVERLAY_MARGIN = 10;
+
+void initGpuTimers(GpuTimers& timers, const std::string& csvPath) {
+    if (csvPath.empty())
+        return;
+    timers.csv.open(csvPath);
+    if (!timers.csv) {
+        std::cerr << "ERROR::GPU_TIMER::CANNOT_OPEN " << csvPath << std::endl;
+        return;
+    }
+    timers.csv << "frame,pass,gpu_ms,p50_ms,p95_ms,p99_ms\n";
+}
+
+unsigned int addGpuPass(GpuTimers& timers, const std::string& name) {
+    GpuPass pass;
+    pass.name = name;
+    glGenQueries(GPU_TIMER_FRAMES * 2, &pass.queries[0][0]);
+    std::fill(pass.pending, pass.pending + GPU_TIMER_FRAMES, false);
+    pass.history.reserve(GPU_TIMER_HISTORY);
+    timers.scratch.reserve(GPU_TIMER_HISTORY);
+    timers.passes.push_back(pass);
+    return (unsigned int)timers.passes.size() - 1;
+}
+
+void beginGpuPass(GpuTimers& timers, unsigned int pass) {
+    glQueryCounter(timers.passes[pass].queries[timers.frame][0], GL_TIMESTAMP);
+}
+
+void endGpuPass(GpuTimers& timers, unsigned int pass) {
+    GpuPass& gpuPass = timers.passes[pass];
+    glQueryCounter(gpuPass.queries[timers.frame][1], GL_TIMESTAMP);
+    gpuPass.pending[timers.frame] = true;
+}
+
+static float percentile(std::vector<float>& values, float fraction) {
+    size_t n = (size_t)(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+static void addSample(GpuPass& pass, float ms, std::vector<float>& scratch) {
+    pass.lastMs = ms;
+    pass.sampleCount++;
+    if (pass.history.size() < GPU_TIMER_HISTORY)
+        pass.history.push_back(ms);
+    else
+        pass.history[pass.historyNext] = ms;
+    pass.historyNext = (pass.historyNext + 1) % GPU_TIMER_HISTORY;
+
+    scratch.assign(pass.history.begin(), pass.history.end());
+    pass.p50 = percentile(scratch, 0.50f);
+    pass.p95 = percentile(scratch, 0.95f);
+    pass.p99 = percentile(scratch, 0.99f);
+}
+
+void endGpuFrame(GpuTimers& timers) {
+    // najstarszy slot - zaraz zostanie uzyty ponownie
+    unsigned int oldest = (timers.frame + 1) % GPU_TIMER_FRAMES;
+    for (GpuPass& pass : timers.passes) {
+        if (!pass.pending[oldest])
+            continue;
+        pass.pending[oldest] = false;
+
+        // nadal niegotowe - probka przepada, nie blokujemy
+        GLint available = 0;
+        glGetQueryObjectiv(pass.queries[oldest][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(pass.queries[oldest][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(pass.queries[oldest][1], GL_QUERY_RESULT, &end);
+        addSample(pass, (end - begin) / 1e6f, timers.scratch);
+
+        if (timers.csv.is_open()) {
+            timers.csv << timers.frameIndex + 1 - GPU_TIMER_FRAMES << ',' << pass.name << ',' << pass.lastMs << ','
+                << pass.p50 << ',' << pass.p95 << ',' << pass.p99 << '\n';
+        }
+    }
+    timers.frame = oldest;
+    timers.frameIndex++;
+}
+
+static void fillRect(int x, int y, int width, int height, float r, float g, float b) {
+    if (width <= 0)
+        return;
+    glScissor(x, y, width, height);
+    glClearColor(r, g, b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void drawGpuOverlay(const GpuTimers& timers, int framebufferWidth, int framebufferHeight) {
+    // same prostokaty przez scissor + clear - bez shaderow i bez zmiany stanu rysowania
+    int fullWidth = framebufferWidth / 3;
+    float scale = fullWidth / OVERLAY_FULL_SCALE_MS;
+    glEnable(GL_SCISSOR_TEST);
+    for (size_t i = 0; i < timers.passes.size(); ++i) {
+        const GpuPass& pass = timers.passes[i];
+        int y = framebufferHeight - OVERLAY_MARGIN - (int)(i + 1) * (OVERLAY_BAR_HEIGHT + OVERLAY_BAR_GAP);
+        fillRect(OVERLAY_MARGIN, y, fullWidth, OVERLAY_BAR_HEIGHT, 0.1f, 0.1f, 0.1f);
+        fillRect(OVERLAY_MARGIN, y, std::min(fullWidth, (int)(pass.p99 * scale)), OVERLAY_BAR_HEIGHT, 0.9f, 0.2f, 0.2f);
+        fillRect(OVERLAY_MARGIN, y, std::min(fullWidth, (int)(pass.p95 * scale)), OVERLAY_BAR_HEIGHT, 0.9f, 0.8f, 0.2f);
+        fillRect(OVERLAY_MARGIN, y, std::min(fullWidth, (int)(pass.p50 * scale)), OVERLAY_BAR_HEIGHT, 0.2f, 0.8f, 0.3f);
+    }
+    // znacznik 16.7 ms
+    int budgetX = OVERLAY_MARGIN + (int)(16.7f * scale);
+    int barsHeight = (int)timers.passes.size() * (OVERLAY_BAR_HEIGHT + OVERLAY_BAR_GAP);
+    fillRect(budgetX, framebufferHeight - OVERLAY_MARGIN - barsHeight, 1, barsHeight, 1.0f, 1.0f, 1.0f);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+std::string gpuTimersSummary(const GpuTimers& timers) {
+    std::ostringstream text;
+    text.setf(std::ios::fixed);
+    text.precision(2);
+    for (const GpuPass& pass : timers.passes) {
+        text << (&pass == &timers.passes.front() ? "" : " | ") << pass.name << " GPU p50 " << pass.p50
+            << " p95 " << pass.p95 << " p99 " << pass.p99 << " ms";
+    }
+    return text.str();
+}
+
+void shutdownGpuTimers(GpuTimers& timers) {
+    if (!timers.passes.empty())
+        std::cout << gpuTimersSummary(timers) << std::endl;
+    for (GpuPass& pass : timers.passes)
+        glDeleteQueries(GPU_TIMER_FRAMES * 2, &pass.queries[0][0]);
+    timers.passes.clear();
+    timers.csv.close();
+}
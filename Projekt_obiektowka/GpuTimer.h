@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+// zapytania sa czytane GPU_TIMER_FRAMES - 1 klatek pozniej, wiec CPU nigdy nie czeka na GPU
+const unsigned int GPU_TIMER_FRAMES = 4;
+const unsigned int GPU_TIMER_HISTORY = 240;
+
+// jeden przebieg renderu mierzony para GL_TIMESTAMP (pary moga sie zagniezdzac)
+struct GpuPass {
+    std::string name;
+    GLuint queries[GPU_TIMER_FRAMES][2];
+    bool pending[GPU_TIMER_FRAMES];
+    std::vector<float> history;  // ms, bufor cykliczny
+    size_t historyNext = 0;
+    float lastMs = 0.0f;
+    uint64_t sampleCount = 0;  // rosnie z kazda odebrana probka
+    float p50 = 0.0f, p95 = 0.0f, p99 = 0.0f;
+};
+
+struct GpuTimers {
+    std::vector<GpuPass> passes;
+    unsigned int frame = 0;
+    uint64_t frameIndex = 0;
+    std::ofstream csv;
+    std::vector<float> scratch;  // do percentyli, zeby nie alokowac co klatke
+};
+
+// csvPath puste - bez zapisu do pliku
+void initGpuTimers(GpuTimers& timers, const std::string& csvPath);
+unsigned int addGpuPass(GpuTimers& timers, const std::string& name);
+void beginGpuPass(GpuTimers& timers, unsigned int pass);
+void endGpuPass(GpuTimers& timers, unsigned int pass);
+// odbiera gotowe wyniki sprzed kilku klatek, przelicza p50/p95/p99 i przechodzi do nastepnej klatki
+void endGpuFrame(GpuTimers& timers);
+// paski w lewym gornym rogu (p50 zielony, p95 zolty, p99 czerwony; cala szerokosc = 2 klatki 60 Hz)
+void drawGpuOverlay(const GpuTimers& timers, int framebufferWidth, int framebufferHeight);
+std::string gpuTimersSummary(const GpuTimers& timers);
+void shutdownGpuTimers(GpuTimers& timers);
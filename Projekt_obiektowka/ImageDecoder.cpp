@@ -0,0 +1,676 @@
+#include "ImageDecoder.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+#endif
+
+// wiekszy bok traktujemy jak uszkodzony naglowek - chroni przed alokacja gigabajtow
+const uint32_t MAX_IMAGE_SIDE = 16384;
+
+static uint32_t readLittleEndian16(const unsigned char* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8);
+}
+
+static uint32_t readLittleEndian32(const unsigned char* data) {
+    return readLittleEndian16(data) | (readLittleEndian16(data + 2) << 16);
+}
+
+#ifndef _WIN32
+// wlasne PNG i BMP tylko poza Windows (narzedzia i benchmark na Linuksie) - na Windows dekoduje WIC
+
+static uint32_t readBigEndian32(const unsigned char* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+// --- inflate (RFC 1951) ---
+
+// bity od najmlodszego; za koncem danych doklejane sa zera, a overrun() mowi, czy ktores zostaly zuzyte
+struct BitReader {
+    const unsigned char* data;
+    size_t size, position;
+    uint64_t buffer;
+    uint32_t bitCount;
+    size_t paddedBytes;
+
+    void refill() {
+        while (bitCount <= 56) {
+            uint64_t byte = 0;
+            if (position < size)
+                byte = data[position++];
+            else
+                ++paddedBytes;
+            buffer |= byte << bitCount;
+            bitCount += 8;
+        }
+    }
+
+    uint32_t bits(uint32_t count) {
+        if (bitCount < count)
+            refill();
+        uint32_t value = (uint32_t)(buffer & ((1ULL << count) - 1));
+        buffer >>= count;
+        bitCount -= count;
+        return value;
+    }
+
+    bool overrun() const {
+        return paddedBytes * 8 > bitCount;
+    }
+};
+
+const uint32_t HUFFMAN_FAST_BITS = 9;
+const uint32_t HUFFMAN_MAX_BITS = 15;
+
+// kody do 9 bitow z tablicy (dlugosc << 9 | symbol, 0 = dluzszy kod), dluzsze kanonicznie bit po bicie
+struct Huffman {
+    uint16_t fast[1 << HUFFMAN_FAST_BITS];
+    uint16_t count[HUFFMAN_MAX_BITS + 1];
+    uint16_t symbols[288];
+};
+
+static bool buildHuffman(Huffman& huffman, const uint8_t* lengths, uint32_t symbolCount) {
+    std::memset(&huffman, 0, sizeof(huffman));
+    for (uint32_t s = 0; s < symbolCount; ++s)
+        ++huffman.count[lengths[s]];
+    huffman.count[0] = 0;
+    // nadmiarowy zestaw dlugosci nie jest kodem prefiksowym; niepelny jest dozwolony (np. jeden kod odleglosci)
+    int left = 1;
+    for (uint32_t length = 1; length <= HUFFMAN_MAX_BITS; ++length) {
+        left = (left << 1) - huffman.count[length];
+        if (left < 0)
+            return false;
+    }
+    uint16_t offsets[HUFFMAN_MAX_BITS + 2] = {};
+    uint32_t nextCode[HUFFMAN_MAX_BITS + 1] = {};
+    for (uint32_t length = 1, code = 0; length <= HUFFMAN_MAX_BITS; ++length) {
+        offsets[length + 1] = (uint16_t)(offsets[length] + huffman.count[length]);
+        code = (code + huffman.count[length - 1]) << 1;
+        nextCode[length] = code;
+    }
+    for (uint32_t s = 0; s < symbolCount; ++s) {
+        uint32_t length = lengths[s];
+        if (!length)
+            continue;
+        huffman.symbols[offsets[length]++] = (uint16_t)s;
+        uint32_t code = nextCode[length]++;
+        if (length > HUFFMAN_FAST_BITS)
+            continue;
+        // w strumieniu kod idzie od najstarszego bitu, a czytamy od najmlodszego - odwrocenie
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < length; ++b)
+            reversed |= ((code >> b) & 1) << (length - 1 - b);
+        for (uint32_t k = reversed; k < (1u << HUFFMAN_FAST_BITS); k += 1u << length)
+            huffman.fast[k] = (uint16_t)((length << 9) | s);
+    }
+    return true;
+}
+
+static int decodeSymbol(BitReader& reader, const Huffman& huffman) {
+    if (reader.bitCount < HUFFMAN_MAX_BITS)
+        reader.refill();
+    uint16_t entry = huffman.fast[reader.buffer & ((1u << HUFFMAN_FAST_BITS) - 1)];
+    if (entry) {
+        reader.bits(entry >> 9);
+        return entry & 511;
+    }
+    int code = 0, first = 0, index = 0;
+    for (uint32_t length = 1; length <= HUFFMAN_MAX_BITS; ++length) {
+        code |= (int)((reader.buffer >> (length - 1)) & 1);
+        int count = huffman.count[length];
+        if (code - first < count) {
+            reader.bits(length);
+            return huffman.symbols[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+    131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025,
+    1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12,
+    13, 13 };
+
+static bool inflateCodes(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<unsigned char>& out,
+    size_t maxSize) {
+    for (;;) {
+        int symbol = decodeSymbol(reader, literals);
+        if (symbol < 0 || reader.overrun())
+            return false;
+        if (symbol < 256) {
+            if (out.size() >= maxSize)
+                return false;
+            out.push_back((unsigned char)symbol);
+            continue;
+        }
+        if (symbol == 256)
+            return true;
+        symbol -= 257;
+        if (symbol >= 29)
+            return false;
+        size_t length = LENGTH_BASE[symbol] + reader.bits(LENGTH_EXTRA[symbol]);
+        int distanceSymbol = decodeSymbol(reader, distances);
+        if (distanceSymbol < 0 || distanceSymbol >= 30)
+            return false;
+        size_t distance = DISTANCE_BASE[distanceSymbol] + reader.bits(DISTANCE_EXTRA[distanceSymbol]);
+        if (reader.overrun() || distance > out.size() || length > maxSize - out.size())
+            return false;
+        // zrodlo moze nachodzic na cel (distance < length) - kopia bajt po bajcie
+        size_t from = out.size() - distance;
+        for (size_t i = 0; i < length; ++i)
+            out.push_back(out[from + i]);
+    }
+}
+
+static bool inflateDynamicTables(BitReader& reader, Huffman& literals, Huffman& distances) {
+    static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    uint32_t literalCount = reader.bits(5) + 257;
+    uint32_t distanceCount = reader.bits(5) + 1;
+    uint32_t codeLengthCount = reader.bits(4) + 4;
+    if (literalCount > 286 || distanceCount > 30)
+        return false;
+    uint8_t lengths[320] = {};
+    for (uint32_t i = 0; i < codeLengthCount; ++i)
+        lengths[ORDER[i]] = (uint8_t)reader.bits(3);
+    Huffman codeLengths;
+    if (!buildHuffman(codeLengths, lengths, 19))
+        return false;
+    std::memset(lengths, 0, sizeof(lengths));
+    uint32_t total = literalCount + distanceCount;
+    for (uint32_t i = 0; i < total;) {
+        int symbol = decodeSymbol(reader, codeLengths);
+        if (symbol < 0 || reader.overrun())
+            return false;
+        if (symbol < 16) {
+            lengths[i++] = (uint8_t)symbol;
+            continue;
+        }
+        uint8_t value = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+            if (i == 0)
+                return false;
+            value = lengths[i - 1];
+            repeat = 3 + reader.bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + reader.bits(3);
+        } else {
+            repeat = 11 + reader.bits(7);
+        }
+        if (i + repeat > total)
+            return false;
+        std::fill(lengths + i, lengths + i + repeat, value);
+        i += repeat;
+    }
+    // bez kodu konca bloku nie da sie go zakonczyc
+    if (lengths[256] == 0)
+        return false;
+    return buildHuffman(literals, lengths, literalCount) && buildHuffman(distances, lengths + literalCount, distanceCount);
+}
+
+// surowy deflate; maxSize - wiecej danych niz obraz moze miec to blad (ochrona przed "bomba")
+static bool inflate(const unsigned char* data, size_t size, std::vector<unsigned char>& out, size_t maxSize) {
+    BitReader reader = { data, size, 0, 0, 0, 0 };
+    out.clear();
+    out.reserve(maxSize);
+    Huffman literals, distances;
+    bool last = false;
+    while (!last) {
+        last = reader.bits(1) != 0;
+        uint32_t type = reader.bits(2);
+        if (type == 0) {
+            // blok bez kompresji: od granicy bajtu, LEN i ~LEN
+            reader.bits(reader.bitCount & 7);
+            uint32_t length = reader.bits(16);
+            uint32_t inverse = reader.bits(16);
+            if ((length ^ 0xFFFF) != inverse || reader.overrun() || length > maxSize - out.size())
+                return false;
+            while (length && reader.bitCount >= 8) {
+                out.push_back((unsigned char)reader.bits(8));
+                --length;
+            }
+            if (reader.overrun() || length > reader.size - reader.position)
+                return false;
+            out.insert(out.end(), reader.data + reader.position, reader.data + reader.position + length);
+            reader.position += length;
+        } else if (type == 1) {
+            uint8_t lengths[320];
+            std::fill(lengths, lengths + 144, (uint8_t)8);
+            std::fill(lengths + 144, lengths + 256, (uint8_t)9);
+            std::fill(lengths + 256, lengths + 280, (uint8_t)7);
+            std::fill(lengths + 280, lengths + 288, (uint8_t)8);
+            std::fill(lengths + 288, lengths + 320, (uint8_t)5);
+            buildHuffman(literals, lengths, 288);
+            buildHuffman(distances, lengths + 288, 30);
+            if (!inflateCodes(reader, literals, distances, out, maxSize))
+                return false;
+        } else if (type == 2) {
+            if (!inflateDynamicTables(reader, literals, distances) || !inflateCodes(reader, literals, distances, out, maxSize))
+                return false;
+        } else {
+            return false;
+        }
+        if (reader.overrun())
+            return false;
+    }
+    return true;
+}
+
+// --- PNG ---
+
+const uint32_t PNG_GRAY = 0, PNG_RGB = 2, PNG_PALETTE = 3, PNG_GRAY_ALPHA = 4, PNG_RGBA = 6;
+
+struct PngInfo {
+    uint32_t width = 0, height = 0;
+    uint32_t bitDepth = 0, colorType = 0, interlace = 0;
+    uint32_t channels = 0;
+    unsigned char palette[256 * 4];
+    uint32_t paletteSize = 0;
+    bool hasTransparentKey = false;
+    uint32_t transparentKey[3] = {};  // tRNS dla szarosci/RGB: probki w oryginalnej glebi
+};
+
+static bool validPngFormat(uint32_t colorType, uint32_t bitDepth) {
+    switch (colorType) {
+    case PNG_GRAY: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+    case PNG_PALETTE: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+    case PNG_RGB: case PNG_GRAY_ALPHA: case PNG_RGBA: return bitDepth == 8 || bitDepth == 16;
+    default: return false;
+    }
+}
+
+static uint32_t pngChannels(uint32_t colorType) {
+    switch (colorType) {
+    case PNG_RGB: return 3;
+    case PNG_GRAY_ALPHA: return 2;
+    case PNG_RGBA: return 4;
+    default: return 1;
+    }
+}
+
+static size_t pngRowBytes(const PngInfo& info, uint32_t width) {
+    return ((size_t)width * info.channels * info.bitDepth + 7) / 8;
+}
+
+static uint32_t pngSample(const unsigned char* row, uint32_t bitDepth, size_t index) {
+    if (bitDepth == 8)
+        return row[index];
+    if (bitDepth == 16)
+        return ((uint32_t)row[2 * index] << 8) | row[2 * index + 1];
+    size_t bit = index * bitDepth;
+    return (row[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1u << bitDepth) - 1);
+}
+
+static unsigned char paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return (unsigned char)(pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+}
+
+// filtry wierszy w miejscu; previous == nullptr - pierwszy wiersz przebiegu (poprzedni = zera)
+static bool unfilterRow(unsigned char* row, const unsigned char* previous, size_t rowBytes, size_t pixelBytes, uint32_t filter) {
+    for (size_t i = 0; i < rowBytes; ++i) {
+        int left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+        int up = previous ? previous[i] : 0;
+        int upLeft = previous && i >= pixelBytes ? previous[i - pixelBytes] : 0;
+        switch (filter) {
+        case 0: break;
+        case 1: row[i] = (unsigned char)(row[i] + left); break;
+        case 2: row[i] = (unsigned char)(row[i] + up); break;
+        case 3: row[i] = (unsigned char)(row[i] + ((left + up) >> 1)); break;
+        case 4: row[i] = (unsigned char)(row[i] + paethPredictor(left, up, upLeft)); break;
+        default: return false;
+        }
+    }
+    return true;
+}
+
+static void pngPixel(const PngInfo& info, const unsigned char* row, uint32_t x, unsigned char* out) {
+    size_t first = (size_t)x * info.channels;
+    uint32_t samples[4];
+    for (uint32_t c = 0; c < info.channels; ++c)
+        samples[c] = pngSample(row, info.bitDepth, first + c);
+    auto to8 = [&](uint32_t value) -> unsigned char {
+        if (info.bitDepth == 16)
+            return (unsigned char)(value >> 8);
+        return (unsigned char)(value * 255 / ((1u << info.bitDepth) - 1));
+    };
+    switch (info.colorType) {
+    case PNG_PALETTE: {
+        uint32_t index = std::min(samples[0], 255u);
+        std::memcpy(out, info.palette + index * 4, 4);
+        break;
+    }
+    case PNG_GRAY:
+        out[0] = out[1] = out[2] = to8(samples[0]);
+        out[3] = info.hasTransparentKey && samples[0] == info.transparentKey[0] ? 0 : 255;
+        break;
+    case PNG_GRAY_ALPHA:
+        out[0] = out[1] = out[2] = to8(samples[0]);
+        out[3] = to8(samples[1]);
+        break;
+    case PNG_RGB:
+        for (int c = 0; c < 3; ++c)
+            out[c] = to8(samples[c]);
+        out[3] = info.hasTransparentKey && samples[0] == info.transparentKey[0] && samples[1] == info.transparentKey[1]
+            && samples[2] == info.transparentKey[2] ? 0 : 255;
+        break;
+    default:
+        for (int c = 0; c < 4; ++c)
+            out[c] = to8(samples[c]);
+        break;
+    }
+}
+
+static bool decodePng(const unsigned char* data, size_t size, uint32_t& width, uint32_t& height,
+    std::vector<unsigned char>& pixels) {
+    PngInfo info;
+    std::vector<unsigned char> compressed;
+    bool header = false;
+    for (size_t offset = 8; offset + 12 <= size;) {
+        size_t length = readBigEndian32(data + offset);
+        const unsigned char* type = data + offset + 4;
+        const unsigned char* chunk = data + offset + 8;
+        if (length > size - offset - 12)
+            return false;
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            if (length < 13)
+                return false;
+            info.width = readBigEndian32(chunk);
+            info.height = readBigEndian32(chunk + 4);
+            info.bitDepth = chunk[8];
+            info.colorType = chunk[9];
+            info.interlace = chunk[12];
+            // kompresja i filtr: w PNG zdefiniowany jest tylko wariant 0
+            if (chunk[10] != 0 || chunk[11] != 0 || info.interlace > 1 || !validPngFormat(info.colorType, info.bitDepth))
+                return false;
+            info.channels = pngChannels(info.colorType);
+            header = true;
+        } else if (std::memcmp(type, "PLTE", 4) == 0) {
+            info.paletteSize = (uint32_t)std::min(length / 3, (size_t)256);
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (int c = 0; c < 3; ++c)
+                    info.palette[i * 4 + c] = i < info.paletteSize ? chunk[i * 3 + c] : 0;
+                info.palette[i * 4 + 3] = 255;
+            }
+        } else if (std::memcmp(type, "tRNS", 4) == 0) {
+            if (info.colorType == PNG_PALETTE) {
+                for (size_t i = 0; i < length && i < 256; ++i)
+                    info.palette[i * 4 + 3] = chunk[i];
+            } else if (info.colorType == PNG_GRAY && length >= 2) {
+                info.hasTransparentKey = true;
+                info.transparentKey[0] = ((uint32_t)chunk[0] << 8) | chunk[1];
+            } else if (info.colorType == PNG_RGB && length >= 6) {
+                info.hasTransparentKey = true;
+                for (int c = 0; c < 3; ++c)
+                    info.transparentKey[c] = ((uint32_t)chunk[2 * c] << 8) | chunk[2 * c + 1];
+            }
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        offset += 12 + length;
+    }
+    if (!header || info.width == 0 || info.height == 0 || info.width > MAX_IMAGE_SIDE || info.height > MAX_IMAGE_SIDE
+        || (info.colorType == PNG_PALETTE && info.paletteSize == 0))
+        return false;
+    // naglowek zlib: deflate, bez slownika, suma kontrolna naglowka
+    if (compressed.size() < 2 || (compressed[0] & 15) != 8 || (compressed[1] & 32) || ((compressed[0] << 8) | compressed[1]) % 31)
+        return false;
+
+    // przeplot Adam7: 7 przebiegow po coraz gestszej siatce, bez przeplotu jeden przebieg 1:1
+    static const uint32_t START_X[7] = { 0, 4, 0, 2, 0, 1, 0 }, START_Y[7] = { 0, 0, 4, 0, 2, 0, 1 };
+    static const uint32_t STEP_X[7] = { 8, 8, 4, 4, 2, 2, 1 }, STEP_Y[7] = { 8, 8, 8, 4, 4, 2, 2 };
+    static const uint32_t SINGLE_START[1] = { 0 }, SINGLE_STEP[1] = { 1 };
+    uint32_t passCount = info.interlace ? 7 : 1;
+    const uint32_t* startX = info.interlace ? START_X : SINGLE_START;
+    const uint32_t* startY = info.interlace ? START_Y : SINGLE_START;
+    const uint32_t* stepX = info.interlace ? STEP_X : SINGLE_STEP;
+    const uint32_t* stepY = info.interlace ? STEP_Y : SINGLE_STEP;
+    size_t rawSize = 0;
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        uint32_t passWidth = info.width > startX[pass] ? (info.width - startX[pass] + stepX[pass] - 1) / stepX[pass] : 0;
+        uint32_t passHeight = info.height > startY[pass] ? (info.height - startY[pass] + stepY[pass] - 1) / stepY[pass] : 0;
+        if (passWidth && passHeight)
+            rawSize += (size_t)passHeight * (1 + pngRowBytes(info, passWidth));
+    }
+    std::vector<unsigned char> raw;
+    if (!inflate(compressed.data() + 2, compressed.size() - 2, raw, rawSize) || raw.size() < rawSize)
+        return false;
+
+    width = info.width;
+    height = info.height;
+    pixels.assign((size_t)width * height * 4, 0);
+    size_t pixelBytes = std::max<size_t>(1, info.channels * info.bitDepth / 8);
+    unsigned char* row = raw.data();
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        uint32_t passWidth = info.width > startX[pass] ? (info.width - startX[pass] + stepX[pass] - 1) / stepX[pass] : 0;
+        uint32_t passHeight = info.height > startY[pass] ? (info.height - startY[pass] + stepY[pass] - 1) / stepY[pass] : 0;
+        if (!passWidth || !passHeight)
+            continue;
+        size_t rowBytes = pngRowBytes(info, passWidth);
+        const unsigned char* previous = nullptr;
+        for (uint32_t y = 0; y < passHeight; ++y) {
+            if (!unfilterRow(row + 1, previous, rowBytes, pixelBytes, row[0]))
+                return false;
+            size_t targetY = startY[pass] + (size_t)y * stepY[pass];
+            for (uint32_t x = 0; x < passWidth; ++x) {
+                size_t targetX = startX[pass] + (size_t)x * stepX[pass];
+                pngPixel(info, row + 1, x, &pixels[(targetY * width + targetX) * 4]);
+            }
+            previous = row + 1;
+            row += 1 + rowBytes;
+        }
+    }
+    return true;
+}
+
+#endif
+
+// --- TGA ---
+
+const uint32_t TGA_TRUECOLOR = 2, TGA_GRAY = 3, TGA_RLE = 8;
+
+static bool decodeTga(const unsigned char* data, size_t size, uint32_t& width, uint32_t& height,
+    std::vector<unsigned char>& pixels) {
+    if (size < 18)
+        return false;
+    uint32_t idLength = data[0], colorMapType = data[1], imageType = data[2];
+    uint32_t baseType = imageType & ~TGA_RLE;
+    width = readLittleEndian16(data + 12);
+    height = readLittleEndian16(data + 14);
+    uint32_t depth = data[16], descriptor = data[17];
+    // TGA nie ma sygnatury - wszystko poza obslugiwanymi typami to "nie TGA"
+    if (colorMapType != 0 || (baseType != TGA_TRUECOLOR && baseType != TGA_GRAY) || width == 0 || height == 0
+        || width > MAX_IMAGE_SIDE || height > MAX_IMAGE_SIDE)
+        return false;
+    if ((baseType == TGA_TRUECOLOR && depth != 24 && depth != 32) || (baseType == TGA_GRAY && depth != 8))
+        return false;
+    size_t pixelBytes = depth / 8, pixelCount = (size_t)width * height;
+    size_t position = 18 + idLength;
+    std::vector<unsigned char> source(pixelCount * pixelBytes);
+    if (imageType & TGA_RLE) {
+        for (size_t filled = 0; filled < pixelCount;) {
+            if (position >= size)
+                return false;
+            uint32_t packet = data[position++];
+            size_t count = std::min<size_t>((packet & 127) + 1, pixelCount - filled);
+            size_t bytes = (packet & 128) ? pixelBytes : count * pixelBytes;
+            if (bytes > size - position)
+                return false;
+            if (packet & 128) {
+                for (size_t i = 0; i < count; ++i)
+                    std::memcpy(&source[(filled + i) * pixelBytes], data + position, pixelBytes);
+            } else {
+                std::memcpy(&source[filled * pixelBytes], data + position, bytes);
+            }
+            position += bytes;
+            filled += count;
+        }
+    } else {
+        if (source.size() > size - std::min(size, position))
+            return false;
+        std::memcpy(source.data(), data + position, source.size());
+    }
+    // domyslnie wiersze od dolu (bit 5 - od gory), bit 4 - kolumny od prawej; piksele BGR(A)
+    bool topDown = (descriptor & 0x20) != 0, rightToLeft = (descriptor & 0x10) != 0;
+    pixels.resize(pixelCount * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        uint32_t sourceY = topDown ? y : height - 1 - y;
+        for (uint32_t x = 0; x < width; ++x) {
+            uint32_t sourceX = rightToLeft ? width - 1 - x : x;
+            const unsigned char* in = &source[((size_t)sourceY * width + sourceX) * pixelBytes];
+            unsigned char* out = &pixels[((size_t)y * width + x) * 4];
+            if (pixelBytes == 1) {
+                out[0] = out[1] = out[2] = in[0];
+                out[3] = 255;
+            } else {
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+                out[3] = pixelBytes == 4 ? in[3] : 255;
+            }
+        }
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+// --- BMP ---
+
+static bool decodeBmp(const unsigned char* data, size_t size, uint32_t& width, uint32_t& height,
+    std::vector<unsigned char>& pixels) {
+    if (size < 54 || readLittleEndian32(data + 14) < 40)
+        return false;
+    size_t pixelOffset = readLittleEndian32(data + 10);
+    int32_t signedWidth = (int32_t)readLittleEndian32(data + 18);
+    int32_t signedHeight = (int32_t)readLittleEndian32(data + 22);
+    uint32_t bitCount = readLittleEndian16(data + 28);
+    uint32_t compression = readLittleEndian32(data + 30);
+    // tylko bez kompresji (3 = maski bitowe, przy 32 bitach w praktyce zawsze BGRA)
+    if ((bitCount != 24 && bitCount != 32) || (compression != 0 && !(compression == 3 && bitCount == 32)))
+        return false;
+    bool topDown = signedHeight < 0;
+    width = (uint32_t)signedWidth;
+    height = topDown ? (uint32_t)(-(int64_t)signedHeight) : (uint32_t)signedHeight;
+    if (signedWidth <= 0 || height == 0 || width > MAX_IMAGE_SIDE || height > MAX_IMAGE_SIDE)
+        return false;
+    size_t stride = ((size_t)width * bitCount + 31) / 32 * 4;
+    if (pixelOffset > size || stride * height > size - pixelOffset)
+        return false;
+    size_t pixelBytes = bitCount / 8;
+    pixels.resize((size_t)width * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        const unsigned char* in = data + pixelOffset + (size_t)(topDown ? y : height - 1 - y) * stride;
+        unsigned char* out = &pixels[(size_t)y * width * 4];
+        for (uint32_t x = 0; x < width; ++x, in += pixelBytes, out += 4) {
+            out[0] = in[2];
+            out[1] = in[1];
+            out[2] = in[0];
+            out[3] = 255;  // alfa w BMP rzadko jest wypelniona, kanal traktujemy jak zarezerwowany
+        }
+    }
+    return true;
+}
+
+#else
+
+// --- WIC (Windows Imaging Component) ---
+
+// fabryka na watek - dekodowanie idzie rownolegle na workerach puli; watek z COM juz w trybie STA tez dziala
+struct WicThread {
+    IWICImagingFactory* factory = nullptr;
+    bool comInitialized = false;
+
+    WicThread() {
+        HRESULT result = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        comInitialized = SUCCEEDED(result);
+        if (comInitialized || result == RPC_E_CHANGED_MODE)
+            CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+    }
+    ~WicThread() {
+        if (factory)
+            factory->Release();
+        if (comInitialized)
+            CoUninitialize();
+    }
+};
+
+// systemowe dekodery PNG, JPEG (tez progresywny), BMP, GIF i TIFF; pierwsza klatka skonwertowana do RGBA8
+static bool decodeWic(const unsigned char* data, size_t size, uint32_t& width, uint32_t& height,
+    std::vector<unsigned char>& pixels) {
+    using Microsoft::WRL::ComPtr;
+    static thread_local WicThread wic;
+    ComPtr<IWICStream> stream;
+    ComPtr<IWICBitmapDecoder> decoder;
+    ComPtr<IWICBitmapFrameDecode> frame;
+    ComPtr<IWICFormatConverter> converter;
+    UINT frameWidth = 0, frameHeight = 0;
+    if (!wic.factory || size > MAXDWORD || FAILED(wic.factory->CreateStream(&stream))
+        || FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(data), (DWORD)size))
+        || FAILED(wic.factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &decoder))
+        || FAILED(decoder->GetFrame(0, &frame)) || FAILED(frame->GetSize(&frameWidth, &frameHeight)))
+        return false;
+    if (frameWidth == 0 || frameHeight == 0 || frameWidth > MAX_IMAGE_SIDE || frameHeight > MAX_IMAGE_SIDE)
+        return false;
+    // alfa bez premultiplikacji, wiersze od gory - tak jak TGA
+    if (FAILED(wic.factory->CreateFormatConverter(&converter))
+        || FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0,
+            WICBitmapPaletteTypeCustom)))
+        return false;
+    width = frameWidth;
+    height = frameHeight;
+    pixels.resize((size_t)width * height * 4);
+    return SUCCEEDED(converter->CopyPixels(nullptr, width * 4, (UINT)pixels.size(), pixels.data()));
+}
+
+#endif
+
+bool decodeImageRgba(const unsigned char* data, size_t size, uint32_t& width, uint32_t& height,
+    std::vector<unsigned char>& pixels) {
+    PROFILE_FUNCTION();
+    static const unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    bool png = size >= 8 && std::memcmp(data, PNG_SIGNATURE, 8) == 0;
+    bool bmp = size >= 2 && data[0] == 'B' && data[1] == 'M';
+    bool jpeg = size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+    bool ok;
+#ifdef _WIN32
+    bool gif = size >= 4 && std::memcmp(data, "GIF8", 4) == 0;
+    bool tiff = size >= 4 && (std::memcmp(data, "II*\0", 4) == 0 || std::memcmp(data, "MM\0*", 4) == 0);
+    // TGA nie ma sygnatury ani dekodera w WIC - zostaje wszystko, czego WIC nie rozpoznal po naglowku
+    if (png || bmp || jpeg || gif || tiff)
+        ok = decodeWic(data, size, width, height, pixels);
+    else
+        ok = decodeTga(data, size, width, height, pixels);
+#else
+    if (png) {
+        ok = decodePng(data, size, width, height, pixels);
+    } else if (bmp) {
+        ok = decodeBmp(data, size, width, height, pixels);
+    } else if (jpeg) {
+        std::cerr << "ERROR::IMAGE_DECODER::UNSUPPORTED_FORMAT JPEG (only with WIC on Windows)" << std::endl;
+        ok = false;
+    } else {
+        ok = decodeTga(data, size, width, height, pixels);
+    }
+#endif
+    if (!ok)
+        pixels.clear();
+    return ok;
+}
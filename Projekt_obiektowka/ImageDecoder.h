@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Windows: PNG, JPEG, BMP, GIF i TIFF przez systemowy WIC, TGA (2/3/10/11, 8/24/32 bity) wlasnym dekoderem.
+// Poza Windows (narzedzia, benchmark) wlasne PNG (wszystkie typy kolorow, 1-16 bitow, Adam7, tRNS) i BMP (24/32 bity),
+// bez JPEG. libraries/include/stb_image.h to same deklaracje stbi-1.33, bez stb_image.c
+// wynik zawsze RGBA8, pierwszy wiersz = gora obrazu; format rozpoznawany po zawartosci, nie po rozszerzeniu
+bool decodeImageRgba(const unsigned char* data, size_t size, uint32_t& width, uint32_t& height,
+    std::vector<unsigned char>& pixels);
@@ -0,0 +1,307 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+const int64_t DEQUE_CAPACITY = 4096;
+const unsigned int JOB_POOL_SIZE = 8192;
+
+// kolejka Chase-Lev: wlasciciel push/pop z dolu, inni kradna z gory
+class WorkStealingDeque {
+public:
+    bool push(Job* job) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= DEQUE_CAPACITY)
+            return false;
+        buffer[b & (DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    Job* pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job* job = buffer[b & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // ostatni element - wyscig ze zlodziejem
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job* steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        Job* job = buffer[t & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+
+    // alignas(64) - zwykly new przed C++17 nie gwarantuje wyrownania
+    static void* operator new(size_t size) {
+#ifdef _WIN32
+        void* memory = _aligned_malloc(size, alignof(WorkStealingDeque));
+#else
+        void* memory = nullptr;
+        if (posix_memalign(&memory, alignof(WorkStealingDeque), size) != 0)
+            memory = nullptr;
+#endif
+        if (!memory)
+            throw std::bad_alloc();
+        return memory;
+    }
+    static void operator delete(void* memory) {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    std::atomic<Job*> buffer[DEQUE_CAPACITY];
+};
+
+struct JobSystem {
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{ false };
+
+    // zadania zlecane z watkow spoza puli (np. watek symulacji)
+    std::mutex globalMutex;
+    std::deque<Job*> globalQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<int> sleeping{ 0 };
+
+    // wyjscie z main bez shutdownJobSystem - watki musza byc dolaczone przed zniszczeniem
+    ~JobSystem();
+};
+
+static JobSystem jobSystem;
+static thread_local int threadIndex = -1;
+
+// kazdy watek ma wlasna pule zadan uzywana cyklicznie
+struct JobPool {
+    Job jobs[JOB_POOL_SIZE];
+    unsigned int next = 0;
+};
+static thread_local std::unique_ptr<JobPool> jobPool;
+
+static void executeJob(Job* job);
+static Job* findJob();
+
+// miejsce zajete az do konca wykonania - przy ponad JOB_POOL_SIZE zadaniach w locie
+// pomagamy w pracy zamiast nadpisac czekajace zadanie
+static Job* allocateJob() {
+    if (!jobPool)
+        jobPool.reset(new JobPool());
+    Job* job = &jobPool->jobs[jobPool->next++ % JOB_POOL_SIZE];
+    while (job->pending.load(std::memory_order_acquire)) {
+        if (Job* other = jobSystem.deques.empty() ? nullptr : findJob())
+            executeJob(other);
+        else
+            std::this_thread::yield();
+    }
+    job->pending.store(true, std::memory_order_relaxed);
+    return job;
+}
+
+static void scheduleJob(Job* job) {
+    if (threadIndex >= 0) {
+        if (!jobSystem.deques[threadIndex]->push(job)) {
+            executeJob(job);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(jobSystem.globalMutex);
+        jobSystem.globalQueue.push_back(job);
+    }
+    if (jobSystem.sleeping.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+        jobSystem.wakeUp.notify_one();
+    }
+}
+
+static void finishJob(Job* job) {
+    JobCounter* counter = job->counter;
+    if (!counter)
+        return;
+
+    // dopoki nie jestesmy ostatni wystarczy CAS, bez blokady
+    int value = counter->value.load(std::memory_order_relaxed);
+    while (value > 1) {
+        if (counter->value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel))
+            return;
+    }
+
+    // zejscie do zera pod blokada - czekajacy bierze ja przed zwolnieniem licznika,
+    // wiec po unlock juz nie dotykamy licznika
+    std::vector<Job*> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->waitingMutex);
+        if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ready.swap(counter->waiting);
+    }
+    for (Job* dependent : ready)
+        scheduleJob(dependent);
+}
+
+static void executeJob(Job* job) {
+    job->function(job->data, job->begin, job->end);
+    finishJob(job);
+    job->pending.store(false, std::memory_order_release);
+}
+
+static Job* findJob() {
+    if (threadIndex >= 0) {
+        if (Job* job = jobSystem.deques[threadIndex]->pop())
+            return job;
+    }
+
+    size_t count = jobSystem.deques.size();
+    size_t start = threadIndex >= 0 ? threadIndex + 1 : 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if ((int)victim == threadIndex)
+            continue;
+        if (Job* job = jobSystem.deques[victim]->steal())
+            return job;
+    }
+
+    std::lock_guard<std::mutex> lock(jobSystem.globalMutex);
+    if (jobSystem.globalQueue.empty())
+        return nullptr;
+    Job* job = jobSystem.globalQueue.front();
+    jobSystem.globalQueue.pop_front();
+    return job;
+}
+
+static void workerLoop(int index) {
+    threadIndex = index;
+    PROFILE_THREAD(internProfileName("worker " + std::to_string(index)));
+    while (jobSystem.running.load(std::memory_order_relaxed)) {
+        if (Job* job = findJob()) {
+            executeJob(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(jobSystem.sleepMutex);
+        jobSystem.sleeping++;
+        jobSystem.wakeUp.wait_for(lock, std::chrono::milliseconds(1));
+        jobSystem.sleeping--;
+    }
+}
+
+void initJobSystem(unsigned int workerCount) {
+    if (workerCount == 0)
+        workerCount = std::thread::hardware_concurrency();
+    if (workerCount == 0)
+        workerCount = 1;
+
+    for (unsigned int i = 0; i < workerCount; ++i)
+        jobSystem.deques.emplace_back(new WorkStealingDeque());
+
+    // watek wywolujacy ma indeks 0, pozostali to pracownicy
+    threadIndex = 0;
+    jobSystem.running = true;
+    for (unsigned int i = 1; i < workerCount; ++i)
+        jobSystem.workers.emplace_back(workerLoop, (int)i);
+}
+
+void shutdownJobSystem() {
+    jobSystem.running = false;
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+        jobSystem.wakeUp.notify_all();
+    }
+    for (std::thread& worker : jobSystem.workers)
+        worker.join();
+    jobSystem.workers.clear();
+    jobSystem.deques.clear();
+    threadIndex = -1;
+}
+
+JobSystem::~JobSystem() {
+    if (!workers.empty())
+        shutdownJobSystem();
+}
+
+unsigned int jobThreadCount() {
+    return jobSystem.deques.empty() ? 1 : (unsigned int)jobSystem.deques.size();
+}
+
+void runJob(JobFunction function, void* data, size_t begin, size_t end, JobCounter* counter) {
+    if (counter)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+    Job* job = allocateJob();
+    job->function = function;
+    job->data = data;
+    job->begin = begin;
+    job->end = end;
+    job->counter = counter;
+    if (jobSystem.deques.empty()) {
+        executeJob(job);
+        return;
+    }
+    scheduleJob(job);
+}
+
+void runJobAfter(JobCounter& dependency, JobFunction function, void* data, size_t begin, size_t end, JobCounter* counter) {
+    if (counter)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+    Job* job = allocateJob();
+    job->function = function;
+    job->data = data;
+    job->begin = begin;
+    job->end = end;
+    job->counter = counter;
+    {
+        std::lock_guard<std::mutex> lock(dependency.waitingMutex);
+        if (dependency.value.load(std::memory_order_acquire) != 0) {
+            dependency.waiting.push_back(job);
+            return;
+        }
+    }
+    if (jobSystem.deques.empty())
+        executeJob(job);
+    else
+        scheduleJob(job);
+}
+
+void waitForCounter(JobCounter& counter) {
+    while (counter.value.load(std::memory_order_acquire) != 0) {
+        if (Job* job = jobSystem.deques.empty() ? nullptr : findJob())
+            executeJob(job);
+        else
+            std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> lock(counter.waitingMutex);
+}
+
+size_t parallelGrain(size_t count, size_t minGrain) {
+    size_t chunks = (size_t)jobThreadCount() * 4;
+    size_t grain = (count + chunks - 1) / chunks;
+    return grain < minGrain ? minGrain : (grain == 0 ? 1 : grain);
+}
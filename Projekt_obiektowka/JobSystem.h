@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+struct Job;
+
+// licznik zadan - zeruje sie gdy wszystkie przypisane zadania sie skoncza,
+// zadania czekajace na licznik (zaleznosci) startuja dopiero wtedy
+struct JobCounter {
+    std::atomic<int> value{ 0 };
+    std::mutex waitingMutex;
+    std::vector<Job*> waiting;
+};
+
+typedef void (*JobFunction)(void* data, size_t begin, size_t end);
+
+struct Job {
+    JobFunction function;
+    void* data;
+    size_t begin, end;
+    JobCounter* counter;
+    std::atomic<bool> pending{ false };  // miejsce w puli zajete do konca wykonania
+};
+
+// workerCount == 0 -> tyle watkow ile rdzeni (watek wywolujacy tez pracuje)
+void initJobSystem(unsigned int workerCount = 0);
+void shutdownJobSystem();
+unsigned int jobThreadCount();
+
+// zlec zadanie, counter (opcjonalny) rosnie o 1 i maleje po wykonaniu
+void runJob(JobFunction function, void* data, size_t begin, size_t end, JobCounter* counter);
+// jak wyzej, ale zadanie wystartuje dopiero gdy dependency spadnie do zera
+void runJobAfter(JobCounter& dependency, JobFunction function, void* data, size_t begin, size_t end, JobCounter* counter);
+// czekajac wykonujemy cudze zadania zamiast spac
+void waitForCounter(JobCounter& counter);
+
+// automatyczny podzial: ~4 porcje na watek, ale nie mniej niz minGrain elementow
+size_t parallelGrain(size_t count, size_t minGrain);
+
+// body(i) dla kazdego i z [begin, end), wraca po wykonaniu wszystkich
+template <typename F>
+void parallelFor(size_t begin, size_t end, const F& body, size_t minGrain = 1) {
+    if (end <= begin)
+        return;
+    size_t grain = parallelGrain(end - begin, minGrain);
+    if (end - begin <= grain) {
+        for (size_t i = begin; i < end; ++i)
+            body(i);
+        return;
+    }
+
+    struct Range {
+        static void run(void* data, size_t first, size_t last) {
+            const F& f = *static_cast<const F*>(data);
+            for (size_t i = first; i < last; ++i)
+                f(i);
+        }
+    };
+
+    JobCounter counter;
+    // pierwsza porcje robimy sami, reszta idzie do kolejki
+    for (size_t first = begin + grain; first < end; first += grain) {
+        size_t last = first + grain < end ? first + grain : end;
+        runJob(&Range::run, (void*)&body, first, last, &counter);
+    }
+    Range::run((void*)&body, begin, begin + grain);
+    waitForCounter(counter);
+}
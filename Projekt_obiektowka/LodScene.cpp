@@ -0,0 +1,432 @@
+#include "LodScene.h"
+#include "Profiler.h"
+#include "TextureManager.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// kamera w sferze wezla - blad liczony jak z tej odleglosci (bardzo duzy, wezel do rozwiniecia)
+const float MIN_NODE_DISTANCE = 1e-3f;
+
+static size_t positionBytes(uint32_t vertexCount) {
+    return ((size_t)vertexCount * 3 * sizeof(uint16_t) + 3) & ~(size_t)3;
+}
+
+size_t lodTileBytes(const LodNodeRecord& node) {
+    return (size_t)node.vertexCount * 2 * sizeof(glm::vec3) + (size_t)node.indexCount * sizeof(unsigned int);
+}
+
+size_t lodTileDataSize(const LodNodeRecord& node) {
+    return positionBytes(node.vertexCount) + (size_t)node.vertexCount * 4 + (size_t)node.indexCount * sizeof(uint32_t);
+}
+
+// zadanie w puli: rozpakowanie kafla ze zmapowanego pliku (tu system czyta z dysku, nie na watku renderu)
+static void loadLodTile(void* data, size_t, size_t) {
+    PROFILE_FUNCTION();
+    LodLoad& load = *static_cast<LodLoad*>(data);
+    int expected = LOD_LOAD_QUEUED;
+    if (!load.state.compare_exchange_strong(expected, LOD_LOAD_RUNNING, std::memory_order_acquire)) {
+        // anulowane zanim zadanie ruszylo - tylko zwolnienie miejsca
+        load.state.store(LOD_LOAD_FREE, std::memory_order_release);
+        return;
+    }
+    const LodScene& scene = *load.scene;
+    const LodNodeRecord& node = scene.nodes[load.node];
+    const unsigned char* source = scene.asset.data + node.dataOffset;
+    glm::vec3 minimum(node.boundsMin[0], node.boundsMin[1], node.boundsMin[2]);
+    glm::vec3 scale = (glm::vec3(node.boundsMax[0], node.boundsMax[1], node.boundsMax[2]) - minimum) / 65535.0f;
+    for (uint32_t v = 0; v < node.vertexCount; ++v) {
+        uint16_t quantized[3];
+        std::memcpy(quantized, source + (size_t)v * sizeof(quantized), sizeof(quantized));
+        load.positions[v] = minimum + glm::vec3(quantized[0], quantized[1], quantized[2]) * scale;
+    }
+    const signed char* normals = (const signed char*)(source + positionBytes(node.vertexCount));
+    for (uint32_t v = 0; v < node.vertexCount; ++v)
+        load.normals[v] = glm::vec3(normals[4 * v], normals[4 * v + 1], normals[4 * v + 2]) * (1.0f / 127.0f);
+    std::memcpy(load.indices.data(), normals + (size_t)node.vertexCount * 4, (size_t)node.indexCount * sizeof(uint32_t));
+    // indeks poza kaflem wyszedlby poza bufor GL
+    bool valid = true;
+    for (uint32_t i = 0; i < node.indexCount; ++i)
+        valid &= load.indices[i] < node.vertexCount;
+    load.state.store(valid ? LOD_LOAD_DONE : LOD_LOAD_FAILED, std::memory_order_release);
+}
+
+bool loadLodSceneLayout(LodScene& scene, const std::string& path, const LodStreamingConfig& config) {
+    scene.config = config;
+    scene.config.loadsInFlight = std::max(1u, config.loadsInFlight);
+    scene.config.uploadBytesPerFrame = std::max<size_t>(64 * 1024, config.uploadBytesPerFrame);
+    if (!openAsset(path, scene.asset)) {
+        std::cerr << "ERROR::LOD_SCENE::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    LodSceneHeader& header = scene.header;
+    size_t size = scene.asset.size;
+    bool valid = size >= sizeof(header);
+    if (valid)
+        std::memcpy(&header, scene.asset.data, sizeof(header));
+    valid = valid && std::memcmp(header.magic, "DLOD", 4) == 0 && header.version == LOD_SCENE_VERSION && header.nodeCount > 0
+        && header.nodeOffset <= size && header.nodeCount <= (size - header.nodeOffset) / sizeof(LodNodeRecord);
+    scene.nodes.clear();
+    if (valid) {
+        scene.nodes.resize(header.nodeCount);
+        std::memcpy(scene.nodes.data(), scene.asset.data + header.nodeOffset, header.nodeCount * sizeof(LodNodeRecord));
+    }
+    // dzieci zawsze za rodzicem - przejscie nie moze sie zapetlic; geometria kazdego kafla lezy w pliku
+    uint32_t maxVertices = 0, maxIndices = 0;
+    for (uint32_t i = 0; valid && i < header.nodeCount; ++i) {
+        const LodNodeRecord& node = scene.nodes[i];
+        valid = (node.childCount == 0 || (node.firstChild > i && node.firstChild <= header.nodeCount
+            && node.childCount <= header.nodeCount - node.firstChild))
+            && node.indexCount % 3 == 0 && node.dataOffset <= size && lodTileDataSize(node) <= size - node.dataOffset;
+        maxVertices = std::max(maxVertices, node.vertexCount);
+        maxIndices = std::max(maxIndices, node.indexCount);
+    }
+    // bufory zadan z maksimow policzonych z rekordow (ograniczonych rozmiarem pliku), naglowek musi sie z nimi zgadzac
+    valid = valid && header.maxVertices == maxVertices && header.maxIndices == maxIndices;
+    if (!valid) {
+        std::cerr << "ERROR::LOD_SCENE::INVALID_FILE " << path << std::endl;
+        closeAsset(scene.asset);
+        return false;
+    }
+
+    scene.spheres.resize(header.nodeCount);
+    for (uint32_t i = 0; i < header.nodeCount; ++i) {
+        const LodNodeRecord& node = scene.nodes[i];
+        glm::vec3 minimum(node.boundsMin[0], node.boundsMin[1], node.boundsMin[2]);
+        glm::vec3 maximum(node.boundsMax[0], node.boundsMax[1], node.boundsMax[2]);
+        scene.spheres[i] = glm::vec4(0.5f * (minimum + maximum), 0.5f * glm::length(maximum - minimum));
+    }
+    scene.tiles.assign(header.nodeCount, LodTile());
+    scene.resident.clear();
+    scene.resident.reserve(1024);
+    scene.meshPool.clear();
+    scene.meshPool.reserve(1024);
+    scene.freeMeshes.clear();
+    scene.freeMeshes.reserve(1024);
+    scene.requests.clear();
+    scene.requests.reserve(1024);
+    scene.drawList.clear();
+    scene.drawList.reserve(1024);
+    scene.loads.reset(new LodLoad[scene.config.loadsInFlight]);
+    for (uint32_t i = 0; i < scene.config.loadsInFlight; ++i) {
+        scene.loads[i].scene = &scene;
+        scene.loads[i].positions.resize(maxVertices);
+        scene.loads[i].normals.resize(maxVertices);
+        scene.loads[i].indices.resize(maxIndices);
+    }
+    scene.frame = 0;
+    scene.residentBytes = 0;
+    scene.stats = LodStats();
+    return true;
+}
+
+static void releaseTileMesh(LodScene& scene, uint32_t node) {
+    LodTile& tile = scene.tiles[node];
+    Mesh& mesh = scene.meshPool[tile.mesh];
+    glDeleteVertexArrays(MESH_LAYOUT_COUNT, mesh.VAO);
+    glDeleteBuffers(VERTEX_STREAM_COUNT, mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh = Mesh();
+    scene.freeMeshes.push_back(tile.mesh);
+    tile.mesh = LOD_NO_MESH;
+    tile.state = LOD_TILE_EMPTY;
+    scene.residentBytes -= lodTileBytes(scene.nodes[node]);
+}
+
+// wypieranie najdawniej odwiedzonych kafli spoza biezacej klatki (korzen przypiety); false - reszta jest w uzyciu
+static bool makeRoom(LodScene& scene, size_t bytes) {
+    while (scene.residentBytes + bytes > scene.config.memoryBudget) {
+        size_t best = SIZE_MAX;
+        for (size_t i = 0; i < scene.resident.size(); ++i) {
+            const LodTile& tile = scene.tiles[scene.resident[i]];
+            if (scene.resident[i] == 0 || tile.lastUsed >= scene.frame)
+                continue;
+            if (best == SIZE_MAX || tile.lastUsed < scene.tiles[scene.resident[best]].lastUsed)
+                best = i;
+        }
+        if (best == SIZE_MAX)
+            return false;
+        releaseTileMesh(scene, scene.resident[best]);
+        scene.resident[best] = scene.resident.back();
+        scene.resident.pop_back();
+        scene.stats.evicted++;
+    }
+    return true;
+}
+
+// rezerwacja budzetu i pustych buforow GL; dane dochodza w continueTileUpload
+static bool beginTileUpload(LodScene& scene, LodLoad& load) {
+    const LodNodeRecord& node = scene.nodes[load.node];
+    LodTile& tile = scene.tiles[load.node];
+    size_t bytes = lodTileBytes(node);
+    if (!makeRoom(scene, bytes)) {
+        tile.state = LOD_TILE_EMPTY;
+        tile.rejectedFrame = scene.frame;
+        scene.stats.rejected++;
+        return false;
+    }
+    if (scene.freeMeshes.empty()) {
+        tile.mesh = (uint32_t)scene.meshPool.size();
+        scene.meshPool.push_back(Mesh());
+    } else {
+        tile.mesh = scene.freeMeshes.back();
+        scene.freeMeshes.pop_back();
+    }
+    uploadMeshData(scene.meshPool[tile.mesh], nullptr, nullptr, nullptr, node.vertexCount, nullptr, node.indexCount);
+    scene.residentBytes += bytes;
+    scene.stats.peakResidentBytes = std::max(scene.stats.peakResidentBytes, scene.residentBytes);
+    tile.state = LOD_TILE_UPLOADING;
+    load.uploaded = 0;
+    load.state.store(LOD_LOAD_UPLOADING, std::memory_order_relaxed);
+    return true;
+}
+
+// kolejne bajty pozycji, normalnych i indeksow w ramach budget; true - kafel kompletny
+static bool continueTileUpload(LodScene& scene, LodLoad& load, size_t& budget) {
+    const LodNodeRecord& node = scene.nodes[load.node];
+    const Mesh& mesh = scene.meshPool[scene.tiles[load.node].mesh];
+    size_t vertexBytes = (size_t)node.vertexCount * sizeof(glm::vec3);
+    struct Part {
+        GLuint buffer;
+        const unsigned char* data;
+        size_t size;
+    };
+    const Part parts[3] = {
+        { mesh.VBO[STREAM_POSITION], (const unsigned char*)load.positions.data(), vertexBytes },
+        { mesh.VBO[STREAM_NORMAL], (const unsigned char*)load.normals.data(), vertexBytes },
+        { mesh.EBO, (const unsigned char*)load.indices.data(), (size_t)node.indexCount * sizeof(unsigned int) } };
+    size_t start = 0;
+    for (const Part& part : parts) {
+        size_t end = start + part.size;
+        if (load.uploaded < end && budget > 0) {
+            // GL_COPY_WRITE_BUFFER - bez ruszania VAO (EBO jest jego stanem)
+            size_t offset = load.uploaded - start, chunk = std::min(part.size - offset, budget);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, part.buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)chunk, part.data + offset);
+            load.uploaded += chunk;
+            budget -= chunk;
+            scene.stats.uploadedBytes += chunk;
+        }
+        start = end;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return load.uploaded == start;
+}
+
+static void finishTileUpload(LodScene& scene, LodLoad& load) {
+    LodTile& tile = scene.tiles[load.node];
+    tile.state = LOD_TILE_RESIDENT;
+    // kafel, ktory przestal byc potrzebny w trakcie wczytywania, idzie pierwszy do wymiany
+    tile.lastUsed = tile.lastRequested;
+    scene.resident.push_back(load.node);
+    scene.stats.loaded++;
+    load.state.store(LOD_LOAD_FREE, std::memory_order_release);
+}
+
+bool openLodScene(LodScene& scene, const std::string& path, const LodStreamingConfig& config) {
+    PROFILE_FUNCTION();
+    if (!loadLodSceneLayout(scene, path, config))
+        return false;
+    // korzen od razu i na stale - zawsze jest co rysowac
+    LodLoad& load = scene.loads[0];
+    load.node = 0;
+    load.state.store(LOD_LOAD_QUEUED, std::memory_order_relaxed);
+    loadLodTile(&load, 0, 1);
+    if (load.state.load(std::memory_order_relaxed) != LOD_LOAD_DONE) {
+        std::cerr << "ERROR::LOD_SCENE::INVALID_FILE " << path << std::endl;
+        closeLodScene(scene);
+        return false;
+    }
+    if (!beginTileUpload(scene, load)) {
+        std::cerr << "ERROR::LOD_SCENE::ROOT_OVER_BUDGET " << lodTileBytes(scene.nodes[0]) << " bytes" << std::endl;
+        load.state.store(LOD_LOAD_FREE, std::memory_order_relaxed);
+        closeLodScene(scene);
+        return false;
+    }
+    size_t budget = SIZE_MAX;
+    continueTileUpload(scene, load, budget);
+    finishTileUpload(scene, load);
+    return true;
+}
+
+void closeLodScene(LodScene& scene) {
+    if (!scene.loads)
+        return;
+    // zadania trzymaja wskazniki na loads i scene
+    for (uint32_t i = 0; i < scene.config.loadsInFlight; ++i) {
+        int expected = LOD_LOAD_QUEUED;
+        scene.loads[i].state.compare_exchange_strong(expected, LOD_LOAD_CANCELLED);
+    }
+    waitForCounter(scene.loadJobs);
+    for (Mesh& mesh : scene.meshPool) {
+        if (!mesh.EBO)
+            continue;
+        glDeleteVertexArrays(MESH_LAYOUT_COUNT, mesh.VAO);
+        glDeleteBuffers(VERTEX_STREAM_COUNT, mesh.VBO);
+        glDeleteBuffers(1, &mesh.EBO);
+    }
+    scene.meshPool.clear();
+    scene.freeMeshes.clear();
+    scene.resident.clear();
+    scene.tiles.clear();
+    scene.residentBytes = 0;
+    scene.loads.reset();
+    closeAsset(scene.asset);
+}
+
+static bool nodeVisible(const LodScene& scene, uint32_t node) {
+    const glm::vec4& sphere = scene.spheres[node];
+    return sphereInFrustum(scene.frustum, glm::vec3(sphere), sphere.w);
+}
+
+// blad kafla w pikselach z najblizszego punktu jego sfery
+static float screenError(const LodScene& scene, uint32_t node) {
+    const glm::vec4& sphere = scene.spheres[node];
+    float distance = std::max(MIN_NODE_DISTANCE, glm::length(glm::vec3(sphere) - scene.cameraPosition) - sphere.w);
+    return scene.nodes[node].geometricError * scene.errorScale / distance;
+}
+
+static void requestTile(LodScene& scene, uint32_t node, float priority) {
+    LodTile& tile = scene.tiles[node];
+    tile.lastRequested = scene.frame;
+    if (tile.state != LOD_TILE_EMPTY)
+        return;
+    if (tile.rejectedFrame && scene.frame - tile.rejectedFrame < scene.config.retryFrames)
+        return;
+    scene.requests.push_back({ node, priority });
+}
+
+static void selectNode(LodScene& scene, uint32_t node) {
+    scene.tiles[node].lastUsed = scene.frame;
+    const LodNodeRecord& record = scene.nodes[node];
+    float error = screenError(scene, node);
+    if (record.childCount && error > scene.config.maxScreenError) {
+        // dzieci zastepuja kafel dopiero wszystkie naraz - inaczej dziura tam, gdzie jeszcze nie doszly
+        bool ready = true;
+        for (uint32_t c = record.firstChild; c < record.firstChild + record.childCount; ++c) {
+            if (scene.tiles[c].state != LOD_TILE_RESIDENT && nodeVisible(scene, c)) {
+                requestTile(scene, c, error);
+                ready = false;
+            }
+        }
+        if (ready) {
+            for (uint32_t c = record.firstChild; c < record.firstChild + record.childCount; ++c) {
+                if (nodeVisible(scene, c))
+                    selectNode(scene, c);
+            }
+            return;
+        }
+        // rysowany rodzic - dzieci juz w GPU albo w drodze tez sa potrzebne, inaczej wymiana wypiera je
+        // dla brakujacego rodzenstwa i zastapienie nigdy sie nie konczy
+        for (uint32_t c = record.firstChild; c < record.firstChild + record.childCount; ++c) {
+            if (scene.tiles[c].state != LOD_TILE_EMPTY && nodeVisible(scene, c))
+                scene.tiles[c].lastUsed = scene.frame;
+        }
+    }
+    scene.drawList.push_back(node);
+    scene.stats.drawnTriangles += record.indexCount / 3;
+}
+
+void selectLodTiles(LodScene& scene, const glm::vec3& cameraPosition, const glm::mat4& viewProjection,
+    float viewportHeight, float fovY) {
+    PROFILE_FUNCTION();
+    uint32_t frame = ++scene.frame;
+    scene.stats.frames++;
+    scene.frustum = extractFrustum(viewProjection);
+    scene.cameraPosition = cameraPosition;
+    scene.errorScale = viewportHeight / (2.0f * std::tan(0.5f * fovY));
+    scene.drawList.clear();
+    scene.requests.clear();
+    scene.stats.drawnTriangles = 0;
+    scene.tiles[0].lastUsed = frame;
+    if (nodeVisible(scene, 0))
+        selectNode(scene, 0);
+    scene.stats.drawnTiles = scene.drawList.size();
+    // najwiekszy blad na ekranie pierwszy - rodzice przed dziecmi, blisko przed daleko
+    std::sort(scene.requests.begin(), scene.requests.end(), [](const LodRequest& a, const LodRequest& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.node < b.node;
+    });
+
+    for (uint32_t i = 0; i < scene.config.loadsInFlight; ++i) {
+        LodLoad& load = scene.loads[i];
+        if (load.state.load(std::memory_order_relaxed) != LOD_LOAD_QUEUED || scene.tiles[load.node].lastRequested == frame)
+            continue;
+        int expected = LOD_LOAD_QUEUED;
+        if (load.state.compare_exchange_strong(expected, LOD_LOAD_CANCELLED)) {
+            scene.tiles[load.node].state = LOD_TILE_EMPTY;
+            scene.stats.cancelled++;
+        }
+    }
+
+    size_t next = 0;
+    for (uint32_t i = 0; i < scene.config.loadsInFlight && next < scene.requests.size(); ++i) {
+        LodLoad& load = scene.loads[i];
+        if (load.state.load(std::memory_order_acquire) != LOD_LOAD_FREE)
+            continue;
+        uint32_t node = scene.requests[next++].node;
+        load.node = node;
+        load.state.store(LOD_LOAD_QUEUED, std::memory_order_relaxed);
+        scene.tiles[node].state = LOD_TILE_LOADING;
+        scene.stats.requested++;
+        prefetchAsset(scene.asset, scene.nodes[node].dataOffset, lodTileDataSize(scene.nodes[node]));
+        runJob(&loadLodTile, &load, 0, 1, &scene.loadJobs);
+    }
+}
+
+void uploadLodTiles(LodScene& scene) {
+    PROFILE_FUNCTION();
+    size_t budget = scene.config.uploadBytesPerFrame;
+    // najpierw zaczete kafle - maja juz zarezerwowane miejsce w budzecie pamieci
+    for (uint32_t i = 0; i < scene.config.loadsInFlight && budget > 0; ++i) {
+        LodLoad& load = scene.loads[i];
+        if (load.state.load(std::memory_order_relaxed) == LOD_LOAD_UPLOADING && continueTileUpload(scene, load, budget))
+            finishTileUpload(scene, load);
+    }
+    for (uint32_t i = 0; i < scene.config.loadsInFlight && budget > 0; ++i) {
+        LodLoad& load = scene.loads[i];
+        int state = load.state.load(std::memory_order_acquire);
+        if (state == LOD_LOAD_FAILED) {
+            std::cerr << "ERROR::LOD_SCENE::INVALID_TILE " << load.node << std::endl;
+            scene.tiles[load.node].state = LOD_TILE_EMPTY;
+            scene.tiles[load.node].rejectedFrame = scene.frame;
+            scene.stats.failed++;
+            load.state.store(LOD_LOAD_FREE, std::memory_order_release);
+            continue;
+        }
+        if (state != LOD_LOAD_DONE)
+            continue;
+        if (!beginTileUpload(scene, load)) {
+            load.state.store(LOD_LOAD_FREE, std::memory_order_release);
+            continue;
+        }
+        if (continueTileUpload(scene, load, budget))
+            finishTileUpload(scene, load);
+    }
+}
+
+void drawLodScene(const LodScene& scene, GLuint shaderProgram, MeshLayout layout) {
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    // kafle bez UV - wariant z tekstura probkuje biala 1x1
+    if (layout == LAYOUT_TEXTURED)
+        glBindTexture(GL_TEXTURE_2D, textureId(NO_TEXTURE));
+    for (uint32_t node : scene.drawList) {
+        const Mesh& mesh = scene.meshPool[scene.tiles[node].mesh];
+        glBindVertexArray(mesh.VAO[layout]);
+        glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+    }
+    glBindVertexArray(0);
+}
+
+void printLodSceneReport(const LodScene& scene) {
+    if (!scene.loads)
+        return;
+    const LodStats& stats = scene.stats;
+    std::cout << "LOD scene: " << scene.nodes.size() << " tiles, " << scene.resident.size() << " resident ("
+        << scene.residentBytes / (1024 * 1024) << " MB, peak " << stats.peakResidentBytes / (1024 * 1024) << " of "
+        << scene.config.memoryBudget / (1024 * 1024) << " MB budget); last frame " << stats.drawnTiles << " tiles, "
+        << stats.drawnTriangles << " triangles; " << stats.requested << " tile loads, " << stats.cancelled << " cancelled, "
+        << stats.loaded << " uploaded, " << stats.evicted << " evicted, " << stats.rejected << " rejected over budget, "
+        << stats.failed << " failed, " << stats.uploadedBytes / (1024 * 1024) << " MB uploaded" << std::endl;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AssetIO.h"
+#include "Culling.h"
+#include "JobSystem.h"
+#include "ModelLoader.h"
+
+const uint32_t LOD_SCENE_VERSION = 1;
+const uint32_t LOD_NO_MESH = 0xFFFFFFFF;
+
+// plik sceny strumieniowanej: naglowek, geometria kafli jedna za druga, na koncu tablica wezlow
+// (wszerz - dzieci wezla leza obok siebie, nodes[0] - korzen). Kafel to cala zawartosc wezla z bledem
+// geometricError; dzieci razem pokrywaja to samo dokladniej i zastepuja rodzica (odswiezanie REPLACE)
+struct LodSceneHeader {
+    char magic[4];  // "DLOD"
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t maxVertices, maxIndices;  // najwiekszy kafel - bufory zadan alokowane raz
+    uint32_t reserved;
+    uint64_t nodeOffset;
+};
+
+// geometria kafla od dataOffset: pozycje uint16 x3 w zakresie bounds (wyrownane do 4 B), normalne int8 x4, indeksy uint32
+struct LodNodeRecord {
+    float boundsMin[3], boundsMax[3];
+    float geometricError;  // najwieksze przesuniecie wierzcholka wzgledem pelnej szczegolowosci (jednostki swiata)
+    uint32_t firstChild, childCount;
+    uint32_t vertexCount, indexCount;
+    uint32_t reserved;
+    uint64_t dataOffset;
+};
+
+struct LodBuildConfig {
+    uint32_t leafTriangles = 16384;  // wezel z co najwyzej tyloma trojkatami zostaje lisciem (pelna szczegolowosc)
+    uint32_t clusterGrid = 64;       // uproszczenie wezla: komorki laczenia wierzcholkow na najdluzszy bok
+};
+
+// wejscie budowania w plikach tymczasowych obok wyniku (outputPath + ".positions.tmp" itd.) - trojkaty
+// w ukladzie swiata dopisywane kawalkami, np. model po modelu, bez trzymania wszystkich grafow naraz
+struct LodBuildInput {
+    std::string outputPath;
+    MappedFile positions, normals, indices;
+    size_t vertexCount = 0, indexCount = 0;
+};
+
+bool beginLodBuild(LodBuildInput& input, const std::string& outputPath);
+// trojkaty wszystkich wezlow grafu (instancje siatki powielone); graf mozna zwolnic zaraz potem
+bool addLodBuildGeometry(LodBuildInput& input, const SceneGraph& graph, const std::vector<Mesh>& meshes);
+// offline: dopisane trojkaty -> hierarchia kafli (podzial przestrzeni po srodkach trojkatow, 2-8 dzieci), liscie
+// z oryginalnymi trojkatami, wyzsze poziomy upraszczane laczeniem wierzcholkow w siatce komorek. Kafle liczone
+// partiami w puli zadan i od razu zapisywane. Geometria wejscia czytana ze zmapowanych plikow (stronicowana przez
+// system), ale kolejnosc, srodki i bufor podzialu (~20 B na trojkat) oraz wezly hierarchii sa w RAM.
+// Pliki tymczasowe usuwane takze po bledzie
+bool finishLodBuild(LodBuildInput& input, const LodBuildConfig& config);
+void abortLodBuild(LodBuildInput& input);
+
+// begin + jeden graf + finish
+bool buildLodScene(const std::string& outputPath, const SceneGraph& graph, const std::vector<Mesh>& meshes,
+    const LodBuildConfig& config);
+
+struct LodStreamingConfig {
+    float maxScreenError = 2.0f;            // piksele - wiekszy blad kafla na ekranie -> dzieci
+    size_t memoryBudget = 256u << 20;       // twardy limit bajtow GPU wczytanych kafli
+    uint32_t loadsInFlight = 8;             // zadania wczytania naraz (bufory najwiekszego kafla alokowane raz)
+    size_t uploadBytesPerFrame = 4u << 20;  // reszta duzego kafla idzie w kolejnych klatkach
+    uint32_t retryFrames = 60;              // kafel odrzucony przez budzet - tyle klatek bez ponownego zadania
+};
+
+enum LodTileState {
+    LOD_TILE_EMPTY,
+    LOD_TILE_LOADING,    // zadanie w puli albo czeka na upload
+    LOD_TILE_UPLOADING,  // bufory GL zarezerwowane, dane dochodza po kawalku
+    LOD_TILE_RESIDENT
+};
+
+enum LodLoadState {
+    LOD_LOAD_FREE,
+    LOD_LOAD_QUEUED,     // w puli zadan
+    LOD_LOAD_CANCELLED,  // juz niepotrzebny - zadanie tylko zwolni miejsce
+    LOD_LOAD_RUNNING,
+    LOD_LOAD_DONE,       // geometria rozpakowana, czeka na watek renderu
+    LOD_LOAD_FAILED,     // uszkodzony kafel
+    LOD_LOAD_UPLOADING   // tylko watek renderu
+};
+
+struct LodScene;
+
+struct LodLoad {
+    std::atomic<int> state{ LOD_LOAD_FREE };
+    uint32_t node = 0;
+    const LodScene* scene = nullptr;
+    std::vector<glm::vec3> positions, normals;  // rozmiar najwiekszego kafla
+    std::vector<unsigned int> indices;
+    size_t uploaded = 0;  // bajty wyslane do GL: pozycje, normalne, indeksy po kolei
+};
+
+struct LodTile {
+    uint8_t state = LOD_TILE_EMPTY;
+    uint32_t lastUsed = 0;       // klatka, w ktorej przejscie odwiedzilo kafel
+    uint32_t lastRequested = 0;  // klatka, w ktorej kafel byl potrzebny (anulowanie zadan)
+    uint32_t rejectedFrame = 0;  // ostatnie odrzucenie przez budzet
+    uint32_t mesh = LOD_NO_MESH;  // indeks w LodScene::meshPool
+};
+
+struct LodRequest {
+    uint32_t node;
+    float priority;  // blad rodzica na ekranie w pikselach
+};
+
+struct LodStats {
+    uint64_t frames = 0;
+    uint64_t requested = 0;
+    uint64_t loaded = 0;
+    uint64_t cancelled = 0;
+    uint64_t evicted = 0;
+    uint64_t rejected = 0;  // budzet pamieci pelny kafli uzywanych w tej klatce
+    uint64_t failed = 0;
+    uint64_t uploadedBytes = 0;
+    size_t peakResidentBytes = 0;
+    size_t drawnTiles = 0;  // ostatnia klatka
+    size_t drawnTriangles = 0;
+};
+
+// plik czytany przez openAsset (mmap albo paczka), w pamieci tylko tablica wezlow i stan kafli.
+// Przejscie od korzenia: kafel o bledzie na ekranie powyzej progu zastepuja dzieci, gdy wszystkie widoczne
+// sa juz w GPU - do tego czasu rysowany jest on, a dzieci czekaja w kolejce (najwiekszy blad pierwszy).
+// Niepotrzebne juz zadania anulowane; kafle ponad budzet wypieraja najdawniej odwiedzone (LRU)
+struct LodScene {
+    LodStreamingConfig config;
+    LodSceneHeader header = {};
+    AssetData asset;
+    std::vector<LodNodeRecord> nodes;
+    std::vector<glm::vec4> spheres;  // sfera ograniczajaca wezla (srodek, promien)
+
+    // stan kafli - tylko watek renderu
+    std::vector<LodTile> tiles;
+    std::vector<uint32_t> resident;  // kafle w GPU - kandydaci do wymiany
+    std::vector<Mesh> meshPool;      // bufory GL kafli; miejsca po wypartych w freeMeshes
+    std::vector<uint32_t> freeMeshes;
+    std::vector<LodRequest> requests;
+    std::vector<uint32_t> drawList;
+    std::unique_ptr<LodLoad[]> loads;
+    JobCounter loadJobs;
+    uint32_t frame = 0;
+    size_t residentBytes = 0;  // z kaflami w trakcie uploadu
+
+    // przejscie biezacej klatki
+    Frustum frustum;
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float errorScale = 0.0f;  // wysokosc widoku / (2 tan(fovY / 2)) - blad na ekranie = error * errorScale / odleglosc
+    LodStats stats;
+};
+
+// naglowek, wezly i stan kafli bez GL (narzedzia, benchmarki)
+bool loadLodSceneLayout(LodScene& scene, const std::string& path, const LodStreamingConfig& config);
+// + synchronicznie korzen (przypiety) - zawsze jest co rysowac
+bool openLodScene(LodScene& scene, const std::string& path, const LodStreamingConfig& config);
+void closeLodScene(LodScene& scene);
+
+// raz na klatke: wybor kafli do rysowania (scene.drawList), zadania brakujacych, anulowanie niepotrzebnych
+// i zlecenie wczytania na wolne miejsca (bez GL)
+void selectLodTiles(LodScene& scene, const glm::vec3& cameraPosition, const glm::mat4& viewProjection,
+    float viewportHeight, float fovY);
+// wczytane kafle do GL w limicie bajtow na klatke, wymiana najdawniej odwiedzonych ponad budzet
+void uploadLodTiles(LodScene& scene);
+// kafle w ukladzie swiata; view/projection juz ustawione
+void drawLodScene(const LodScene& scene, GLuint shaderProgram, MeshLayout layout = LAYOUT_SHADED);
+
+// bajty GPU kafla: pozycje i normalne float, indeksy uint32
+size_t lodTileBytes(const LodNodeRecord& node);
+// bajty geometrii kafla w pliku
+size_t lodTileDataSize(const LodNodeRecord& node);
+
+void printLodSceneReport(const LodScene& scene);
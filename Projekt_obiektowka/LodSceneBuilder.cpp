@@ -0,0 +1,393 @@
+#include "LodScene.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+const uint64_t TILE_DATA_OFFSET = 64;
+const size_t NODE_BATCH = 64;  // kafle liczone naraz przed zapisem
+const uint32_t CLUSTER_AXIS_BITS = 21;
+const size_t INPUT_INITIAL_CAPACITY = 1u << 20;
+
+// widok na zmapowane wejscie na czas budowania hierarchii i kafli
+struct LodInputArrays {
+    const glm::vec3* positions;
+    const glm::vec3* normals;
+    const uint32_t* indices;
+    size_t indexCount;
+};
+
+struct LodBuildNode {
+    glm::vec3 boundsMin, boundsMax;
+    uint32_t firstTriangle, triangleCount;  // zakres w order - poddrzewo ma dokladnie te trojkaty
+    uint32_t firstChild, childCount;
+    float geometricError;
+};
+
+struct LodTileGeometry {
+    std::vector<glm::vec3> positions, normals;
+    std::vector<uint32_t> indices;
+};
+
+static bool ensureCapacity(MappedFile& file, size_t required) {
+    if (required <= file.size)
+        return true;
+    size_t capacity = file.size;
+    while (capacity < required)
+        capacity *= 2;
+    return resizeMappedFile(file, capacity);
+}
+
+static std::string inputPath(const LodBuildInput& input, const char* stream) {
+    return input.outputPath + "." + stream + ".tmp";
+}
+
+bool beginLodBuild(LodBuildInput& input, const std::string& outputPath) {
+    input.outputPath = outputPath;
+    input.vertexCount = input.indexCount = 0;
+    if (!createMappedFile(input.positions, inputPath(input, "positions"), INPUT_INITIAL_CAPACITY)
+        || !createMappedFile(input.normals, inputPath(input, "normals"), INPUT_INITIAL_CAPACITY)
+        || !createMappedFile(input.indices, inputPath(input, "indices"), INPUT_INITIAL_CAPACITY)) {
+        std::cerr << "ERROR::LOD_SCENE::CANNOT_CREATE " << inputPath(input, "*") << std::endl;
+        abortLodBuild(input);
+        return false;
+    }
+    return true;
+}
+
+void abortLodBuild(LodBuildInput& input) {
+    const char* streams[3] = { "positions", "normals", "indices" };
+    MappedFile* files[3] = { &input.positions, &input.normals, &input.indices };
+    for (int i = 0; i < 3; ++i) {
+        closeMappedFile(*files[i], 0);
+        std::remove(inputPath(input, streams[i]).c_str());
+    }
+    input.vertexCount = input.indexCount = 0;
+}
+
+bool addLodBuildGeometry(LodBuildInput& input, const SceneGraph& graph, const std::vector<Mesh>& meshes) {
+    PROFILE_FUNCTION();
+    if (!input.positions.data)
+        return false;
+    if (graph.nodes.empty())
+        return true;
+    // rodzic zawsze przed dziecmi - jedno przejscie po tablicy
+    std::vector<glm::mat4> world(graph.nodes.size());
+    world[0] = graph.nodes[0].transform;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        const Node& node = graph.nodes[i];
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+            world[c] = world[i] * graph.nodes[c].transform;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world[i])));
+        for (uint32_t m = node.firstMesh; m < node.firstMesh + node.meshCount; ++m) {
+            const Mesh& mesh = meshes[graph.meshIndices[m]];
+            size_t vertexCount = input.vertexCount + mesh.positions.size();
+            size_t indexCount = input.indexCount + mesh.indices.size() / 3 * 3;
+            // indeksy i liczba trojkatow uint32; zmiana rozmiaru przesuwa data - wskazniki dopiero potem
+            if (vertexCount > UINT32_MAX || indexCount / 3 > UINT32_MAX
+                || !ensureCapacity(input.positions, vertexCount * sizeof(glm::vec3))
+                || !ensureCapacity(input.normals, vertexCount * sizeof(glm::vec3))
+                || !ensureCapacity(input.indices, indexCount * sizeof(uint32_t))) {
+                std::cerr << "ERROR::LOD_SCENE::INPUT_TOO_LARGE " << input.outputPath << std::endl;
+                abortLodBuild(input);
+                return false;
+            }
+            glm::vec3* positions = (glm::vec3*)input.positions.data;
+            glm::vec3* normals = (glm::vec3*)input.normals.data;
+            uint32_t* indices = (uint32_t*)input.indices.data + input.indexCount;
+            uint32_t base = (uint32_t)input.vertexCount;
+            for (size_t v = 0; v < mesh.positions.size(); ++v) {
+                positions[base + v] = glm::vec3(world[i] * glm::vec4(mesh.positions[v], 1.0f));
+                normals[base + v] = mesh.normals.empty() ? glm::vec3(0.0f) : normalMatrix * mesh.normals[v];
+            }
+            for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+                uint32_t a = base + mesh.indices[t], b = base + mesh.indices[t + 1], c = base + mesh.indices[t + 2];
+                *indices++ = a;
+                *indices++ = b;
+                *indices++ = c;
+                // siatka bez normalnych - suma normalnych scian
+                if (mesh.normals.empty()) {
+                    glm::vec3 face = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+                    normals[a] += face;
+                    normals[b] += face;
+                    normals[c] += face;
+                }
+            }
+            input.vertexCount = vertexCount;
+            input.indexCount = indexCount;
+        }
+    }
+    return true;
+}
+
+// podzial po srodkach trojkatow w polowie zakresu na osiach nie krotszych niz polowa najdluzszej (2-8 dzieci),
+// wezly wszerz - dzieci zawsze obok siebie i za rodzicem
+static void buildHierarchy(const LodInputArrays& input, const LodBuildConfig& config, std::vector<uint32_t>& order,
+    std::vector<LodBuildNode>& nodes) {
+    PROFILE_FUNCTION();
+    uint32_t triangleCount = (uint32_t)(input.indexCount / 3);
+    std::vector<glm::vec3> centroids(triangleCount);
+    parallelFor(0, triangleCount, [&](size_t t) {
+        centroids[t] = (input.positions[input.indices[3 * t]] + input.positions[input.indices[3 * t + 1]]
+            + input.positions[input.indices[3 * t + 2]]) / 3.0f;
+    }, 4096);
+    order.resize(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+        order[t] = t;
+    std::vector<uint32_t> scratch(triangleCount);
+
+    nodes.clear();
+    nodes.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), 0, triangleCount, 0, 0, 0.0f });
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        uint32_t first = nodes[n].firstTriangle, count = nodes[n].triangleCount;
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX), centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t t = order[i];
+            for (int k = 0; k < 3; ++k) {
+                boundsMin = glm::min(boundsMin, input.positions[input.indices[3 * t + k]]);
+                boundsMax = glm::max(boundsMax, input.positions[input.indices[3 * t + k]]);
+            }
+            centroidMin = glm::min(centroidMin, centroids[t]);
+            centroidMax = glm::max(centroidMax, centroids[t]);
+        }
+        nodes[n].boundsMin = boundsMin;
+        nodes[n].boundsMax = boundsMax;
+        glm::vec3 extent = centroidMax - centroidMin;
+        float longest = std::max(extent.x, std::max(extent.y, extent.z));
+        if (count <= config.leafTriangles || longest <= 0.0f)
+            continue;
+
+        glm::vec3 middle = centroidMin + 0.5f * extent;
+        uint32_t bucketCounts[8] = {};
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t t = order[i], bucket = 0;
+            for (int a = 0; a < 3; ++a) {
+                if (extent[a] >= 0.5f * longest && centroids[t][a] > middle[a])
+                    bucket |= 1u << a;
+            }
+            scratch[i] = bucket;
+            bucketCounts[bucket]++;
+        }
+        uint32_t bucketStart[8], offset = first;
+        nodes[n].firstChild = (uint32_t)nodes.size();
+        for (uint32_t b = 0; b < 8; ++b) {
+            bucketStart[b] = offset;
+            if (bucketCounts[b]) {
+                nodes.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), offset, bucketCounts[b], 0, 0, 0.0f });
+                nodes[n].childCount++;
+            }
+            offset += bucketCounts[b];
+        }
+        // stabilne rozlozenie zakresu wg kubelkow (scratch - kubelek kazdego trojkata)
+        std::vector<uint32_t> sorted(count);
+        for (uint32_t i = first; i < first + count; ++i)
+            sorted[bucketStart[scratch[i]]++ - first] = order[i];
+        std::memcpy(&order[first], sorted.data(), count * sizeof(uint32_t));
+    }
+
+    // blad wezla: przesuniecie wierzcholka w komorce laczenia, nie mniejszy niz u dzieci (od lisci w gore)
+    for (size_t n = nodes.size(); n-- > 0;) {
+        LodBuildNode& node = nodes[n];
+        if (!node.childCount)
+            continue;
+        glm::vec3 extent = node.boundsMax - node.boundsMin;
+        float cell = std::max(extent.x, std::max(extent.y, extent.z)) / config.clusterGrid;
+        node.geometricError = cell * std::sqrt(3.0f);
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+            node.geometricError = std::max(node.geometricError, nodes[c].geometricError);
+    }
+}
+
+// liscie: oryginalne trojkaty; wyzej wierzcholki w tej samej komorce siatki laczone w jeden (srednia),
+// trojkaty zdegenerowane i powtorzone odrzucane
+static void buildTileGeometry(const LodInputArrays& input, const std::vector<uint32_t>& order, const LodBuildNode& node,
+    const LodBuildConfig& config, LodTileGeometry& tile) {
+    bool leaf = node.childCount == 0;
+    glm::vec3 extent = node.boundsMax - node.boundsMin;
+    float cell = std::max(extent.x, std::max(extent.y, extent.z)) / config.clusterGrid;
+    float inverseCell = cell > 0.0f ? 1.0f / cell : 0.0f;
+    uint32_t maxCell = (1u << CLUSTER_AXIS_BITS) - 1;
+    // (klucz klastra, wierzcholek) dla kazdego rogu
+    std::vector<std::pair<uint64_t, uint32_t>> corners;
+    corners.reserve((size_t)node.triangleCount * 3);
+    for (uint32_t i = node.firstTriangle; i < node.firstTriangle + node.triangleCount; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = input.indices[3 * order[i] + k];
+            uint64_t key = v;
+            if (!leaf) {
+                glm::vec3 p = (input.positions[v] - node.boundsMin) * inverseCell;
+                key = 0;
+                for (int a = 0; a < 3; ++a)
+                    key |= (uint64_t)std::min(maxCell, (uint32_t)std::max(0.0f, p[a])) << (a * CLUSTER_AXIS_BITS);
+            }
+            corners.push_back(std::make_pair(key, v));
+        }
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> sorted = corners;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<uint64_t> keys;
+    std::vector<glm::vec3> positionSums, normalSums;
+    std::vector<uint32_t> weights;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (keys.empty() || keys.back() != sorted[i].first) {
+            keys.push_back(sorted[i].first);
+            positionSums.push_back(glm::vec3(0.0f));
+            normalSums.push_back(glm::vec3(0.0f));
+            weights.push_back(0);
+        }
+        positionSums.back() += input.positions[sorted[i].second];
+        normalSums.back() += input.normals[sorted[i].second];
+        weights.back()++;
+    }
+
+    std::vector<uint32_t> triangles;
+    triangles.reserve(corners.size());
+    for (size_t i = 0; i < corners.size(); i += 3) {
+        uint32_t c[3];
+        for (int k = 0; k < 3; ++k)
+            c[k] = (uint32_t)(std::lower_bound(keys.begin(), keys.end(), corners[i + k].first) - keys.begin());
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2])
+            continue;
+        // obrot do najmniejszego indeksu - ten sam trojkat z tym samym nawinieciem ma jeden zapis
+        int first = c[0] < c[1] ? (c[0] < c[2] ? 0 : 2) : (c[1] < c[2] ? 1 : 2);
+        for (int k = 0; k < 3; ++k)
+            triangles.push_back(c[(first + k) % 3]);
+    }
+    if (!leaf) {
+        std::vector<glm::uvec3> unique(triangles.size() / 3);
+        std::memcpy(unique.data(), triangles.data(), triangles.size() * sizeof(uint32_t));
+        std::sort(unique.begin(), unique.end(), [](const glm::uvec3& a, const glm::uvec3& b) {
+            return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+        });
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+        triangles.resize(unique.size() * 3);
+        std::memcpy(triangles.data(), unique.data(), triangles.size() * sizeof(uint32_t));
+    }
+
+    // tylko klastry uzyte przez pozostale trojkaty
+    std::vector<uint32_t> remap(keys.size(), UINT32_MAX);
+    tile.positions.clear();
+    tile.normals.clear();
+    tile.indices.resize(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        uint32_t cluster = triangles[i];
+        if (remap[cluster] == UINT32_MAX) {
+            remap[cluster] = (uint32_t)tile.positions.size();
+            tile.positions.push_back(glm::clamp(positionSums[cluster] / (float)weights[cluster], node.boundsMin, node.boundsMax));
+            float length = glm::length(normalSums[cluster]);
+            tile.normals.push_back(length > 0.0f ? normalSums[cluster] / length : glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        tile.indices[i] = remap[cluster];
+    }
+}
+
+static void encodeTile(const LodTileGeometry& tile, const LodBuildNode& node, unsigned char* out) {
+    glm::vec3 extent = node.boundsMax - node.boundsMin, scale;
+    for (int a = 0; a < 3; ++a)
+        scale[a] = extent[a] > 0.0f ? 65535.0f / extent[a] : 0.0f;
+    size_t vertexCount = tile.positions.size();
+    for (size_t v = 0; v < vertexCount; ++v) {
+        glm::vec3 q = glm::clamp(glm::round((tile.positions[v] - node.boundsMin) * scale), glm::vec3(0.0f), glm::vec3(65535.0f));
+        uint16_t quantized[3] = { (uint16_t)q.x, (uint16_t)q.y, (uint16_t)q.z };
+        std::memcpy(out + v * sizeof(quantized), quantized, sizeof(quantized));
+    }
+    unsigned char* normals = out + ((vertexCount * 3 * sizeof(uint16_t) + 3) & ~(size_t)3);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        for (int a = 0; a < 3; ++a)
+            normals[4 * v + a] = (unsigned char)(signed char)std::lround(glm::clamp(tile.normals[v][a], -1.0f, 1.0f) * 127.0f);
+        normals[4 * v + 3] = 0;
+    }
+    std::memcpy(normals + vertexCount * 4, tile.indices.data(), tile.indices.size() * sizeof(uint32_t));
+}
+
+static bool writeLodScene(const std::string& outputPath, const LodInputArrays& input, const LodBuildConfig& config) {
+    std::vector<uint32_t> order;
+    std::vector<LodBuildNode> nodes;
+    buildHierarchy(input, config, order, nodes);
+
+    MappedFile output;
+    if (!createMappedFile(output, outputPath, 1u << 20)) {
+        std::cerr << "ERROR::LOD_SCENE::CANNOT_CREATE " << outputPath << std::endl;
+        return false;
+    }
+    LodSceneHeader header = {};
+    std::memcpy(header.magic, "DLOD", 4);
+    header.version = LOD_SCENE_VERSION;
+    header.nodeCount = (uint32_t)nodes.size();
+    std::vector<LodNodeRecord> records(nodes.size());
+    uint64_t offset = TILE_DATA_OFFSET;
+
+    // partia kafli rownolegle, zapis po kolei - w pamieci geometria tylko jednej partii
+    std::vector<LodTileGeometry> batch(NODE_BATCH);
+    for (size_t first = 0; first < nodes.size(); first += NODE_BATCH) {
+        size_t count = std::min(NODE_BATCH, nodes.size() - first);
+        parallelFor(0, count, [&](size_t i) {
+            buildTileGeometry(input, order, nodes[first + i], config, batch[i]);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            const LodBuildNode& node = nodes[first + i];
+            const LodTileGeometry& tile = batch[i];
+            LodNodeRecord& record = records[first + i];
+            record = LodNodeRecord();
+            for (int a = 0; a < 3; ++a) {
+                record.boundsMin[a] = node.boundsMin[a];
+                record.boundsMax[a] = node.boundsMax[a];
+            }
+            record.geometricError = node.geometricError;
+            record.firstChild = node.firstChild;
+            record.childCount = node.childCount;
+            record.vertexCount = (uint32_t)tile.positions.size();
+            record.indexCount = (uint32_t)tile.indices.size();
+            record.dataOffset = offset;
+            size_t size = lodTileDataSize(record);
+            if (!ensureCapacity(output, (size_t)offset + size)) {
+                std::cerr << "ERROR::LOD_SCENE::RESIZE_FAILED " << outputPath << std::endl;
+                closeMappedFile(output, 0);
+                std::remove(outputPath.c_str());
+                return false;
+            }
+            encodeTile(tile, node, output.data + offset);
+            offset = (offset + size + 3) & ~(uint64_t)3;
+            header.maxVertices = std::max(header.maxVertices, record.vertexCount);
+            header.maxIndices = std::max(header.maxIndices, record.indexCount);
+        }
+    }
+    header.nodeOffset = (offset + 7) & ~(uint64_t)7;
+    size_t total = (size_t)header.nodeOffset + records.size() * sizeof(LodNodeRecord);
+    if (!ensureCapacity(output, total)) {
+        std::cerr << "ERROR::LOD_SCENE::RESIZE_FAILED " << outputPath << std::endl;
+        closeMappedFile(output, 0);
+        std::remove(outputPath.c_str());
+        return false;
+    }
+    std::memcpy(output.data + header.nodeOffset, records.data(), records.size() * sizeof(LodNodeRecord));
+    std::memcpy(output.data, &header, sizeof(header));
+    closeMappedFile(output, total);
+    return true;
+}
+
+bool finishLodBuild(LodBuildInput& input, const LodBuildConfig& config) {
+    PROFILE_FUNCTION();
+    bool built = false;
+    if (config.leafTriangles == 0 || config.clusterGrid == 0)
+        std::cerr << "ERROR::LOD_SCENE::INVALID_BUILD_CONFIG" << std::endl;
+    else if (!input.positions.data || input.indexCount == 0)
+        std::cerr << "ERROR::LOD_SCENE::NO_TRIANGLES" << std::endl;
+    else {
+        LodInputArrays arrays = { (const glm::vec3*)input.positions.data, (const glm::vec3*)input.normals.data,
+            (const uint32_t*)input.indices.data, input.indexCount };
+        built = writeLodScene(input.outputPath, arrays, config);
+    }
+    abortLodBuild(input);
+    return built;
+}
+
+bool buildLodScene(const std::string& outputPath, const SceneGraph& graph, const std::vector<Mesh>& meshes,
+    const LodBuildConfig& config) {
+    LodBuildInput input;
+    return beginLodBuild(input, outputPath) && addLodBuildGeometry(input, graph, meshes) && finishLodBuild(input, config);
+}
@@ -0,0 +1,203 @@
+#include "MappedFile.h"
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static bool mapView(MappedFile& file, size_t size) {
+    DWORD protect = file.writable ? PAGE_READWRITE : PAGE_READONLY;
+    DWORD access = file.writable ? FILE_MAP_WRITE : FILE_MAP_READ;
+    file.mappingHandle = CreateFileMappingA(file.fileHandle, nullptr, protect,
+        (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+    if (!file.mappingHandle)
+        return false;
+    file.data = (unsigned char*)MapViewOfFile(file.mappingHandle, access, 0, 0, size);
+    if (!file.data) {
+        CloseHandle(file.mappingHandle);
+        file.mappingHandle = nullptr;
+        return false;
+    }
+    file.size = size;
+    return true;
+}
+
+static void unmapView(MappedFile& file) {
+    if (file.data)
+        UnmapViewOfFile(file.data);
+    if (file.mappingHandle)
+        CloseHandle(file.mappingHandle);
+    file.data = nullptr;
+    file.mappingHandle = nullptr;
+    file.size = 0;
+}
+
+bool mapFileForRead(MappedFile& file, const std::string& path) {
+    file.writable = false;
+    file.fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file.fileHandle == INVALID_HANDLE_VALUE) {
+        file.fileHandle = nullptr;
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(file.fileHandle, &size);
+    if (size.QuadPart == 0) {
+        file.size = 0;
+        return true;
+    }
+    if (!mapView(file, (size_t)size.QuadPart)) {
+        closeMappedFile(file);
+        return false;
+    }
+    return true;
+}
+
+bool createMappedFile(MappedFile& file, const std::string& path, size_t capacity) {
+    file.writable = true;
+    file.fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file.fileHandle == INVALID_HANDLE_VALUE) {
+        file.fileHandle = nullptr;
+        return false;
+    }
+    // mapowanie wiekszego rozmiaru niz plik wydluza plik
+    if (!mapView(file, capacity)) {
+        closeMappedFile(file);
+        return false;
+    }
+    return true;
+}
+
+bool resizeMappedFile(MappedFile& file, size_t capacity) {
+    unmapView(file);
+    return mapView(file, capacity);
+}
+
+void closeMappedFile(MappedFile& file, size_t finalSize) {
+    unmapView(file);
+    if (file.fileHandle) {
+        if (file.writable && finalSize != SIZE_MAX) {
+            LARGE_INTEGER end;
+            end.QuadPart = (LONGLONG)finalSize;
+            SetFilePointerEx(file.fileHandle, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(file.fileHandle);
+        }
+        CloseHandle(file.fileHandle);
+    }
+    file.fileHandle = nullptr;
+    file.size = 0;
+}
+
+void adviseSequential(const MappedFile&) {
+    // brak odpowiednika madvise dla widokow - wystarcza prefetchRange
+}
+
+void prefetchRange(const MappedFile& file, size_t offset, size_t length) {
+#if _WIN32_WINNT >= 0x0602
+    if (!file.data || offset >= file.size)
+        return;
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = file.data + offset;
+    range.NumberOfBytes = offset + length > file.size ? file.size - offset : length;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    (void)file; (void)offset; (void)length;
+#endif
+}
+
+#else
+
+static bool mapView(MappedFile& file, size_t size) {
+    int protect = file.writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* data = mmap(nullptr, size, protect, MAP_SHARED, file.fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    file.data = (unsigned char*)data;
+    file.size = size;
+    return true;
+}
+
+static void unmapView(MappedFile& file) {
+    if (file.data)
+        munmap(file.data, file.size);
+    file.data = nullptr;
+    file.size = 0;
+}
+
+bool mapFileForRead(MappedFile& file, const std::string& path) {
+    file.writable = false;
+    file.fd = open(path.c_str(), O_RDONLY);
+    if (file.fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(file.fd, &info) != 0) {
+        closeMappedFile(file);
+        return false;
+    }
+    if (info.st_size == 0) {
+        file.size = 0;
+        return true;
+    }
+    if (!mapView(file, (size_t)info.st_size)) {
+        closeMappedFile(file);
+        return false;
+    }
+    return true;
+}
+
+bool createMappedFile(MappedFile& file, const std::string& path, size_t capacity) {
+    file.writable = true;
+    file.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file.fd < 0)
+        return false;
+    if (ftruncate(file.fd, (off_t)capacity) != 0 || !mapView(file, capacity)) {
+        closeMappedFile(file);
+        return false;
+    }
+    return true;
+}
+
+bool resizeMappedFile(MappedFile& file, size_t capacity) {
+    unmapView(file);
+    if (ftruncate(file.fd, (off_t)capacity) != 0)
+        return false;
+    return mapView(file, capacity);
+}
+
+void closeMappedFile(MappedFile& file, size_t finalSize) {
+    unmapView(file);
+    if (file.fd >= 0) {
+        if (file.writable && finalSize != SIZE_MAX && ftruncate(file.fd, (off_t)finalSize) != 0)
+            std::cerr << "ERROR::MAPPED_FILE::TRUNCATE_FAILED" << std::endl;
+        close(file.fd);
+    }
+    file.fd = -1;
+    file.size = 0;
+}
+
+void adviseSequential(const MappedFile& file) {
+    if (file.data)
+        madvise(file.data, file.size, MADV_SEQUENTIAL);
+}
+
+void prefetchRange(const MappedFile& file, size_t offset, size_t length) {
+    if (!file.data || offset >= file.size)
+        return;
+    // madvise wymaga adresu wyrownanego do strony
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page - 1);
+    size_t end = offset + length > file.size ? file.size : offset + length;
+    madvise(file.data + start, end - start, MADV_WILLNEED);
+}
+
+#endif
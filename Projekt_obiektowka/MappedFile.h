@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// plik zmapowany w pamiec (Windows: CreateFileMapping, reszta: mmap)
+struct MappedFile {
+    unsigned char* data = nullptr;
+    size_t size = 0;
+    bool writable = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+bool mapFileForRead(MappedFile& file, const std::string& path);
+// tworzy (nadpisuje) plik o rozmiarze capacity i mapuje go do zapisu
+bool createMappedFile(MappedFile& file, const std::string& path, size_t capacity);
+// zmienia rozmiar pliku otwartego do zapisu i mapuje go ponownie (data moze sie zmienic);
+// po bledzie data == nullptr i size == 0
+bool resizeMappedFile(MappedFile& file, size_t capacity);
+// finalSize != SIZE_MAX - przycina plik do faktycznie zapisanej dlugosci
+void closeMappedFile(MappedFile& file, size_t finalSize = SIZE_MAX);
+
+// podpowiedzi dla systemu co do sposobu czytania
+void adviseSequential(const MappedFile& file);
+void prefetchRange(const MappedFile& file, size_t offset, size_t length);
@@ -0,0 +1,114 @@
+#include "MeshRegistry.h"
+#include "Profiler.h"
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+MeshRegistryStats meshRegistryStats;
+// skrot -> indeks w meshes; wpisy po meshes.clear() albo releaseMesh sa usuwane przy nastepnym trafieniu
+static std::unordered_multimap<uint64_t, unsigned int> registry;
+
+template <typename T>
+static void hashVector(uint64_t& hash, const std::vector<T>& data) {
+    // FNV-1a po slowach 32-bitowych, dlugosc na poczatku oddziela strumienie
+    hash = (hash ^ (uint64_t)data.size()) * 0x100000001B3ULL;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    size_t size = data.size() * sizeof(T);
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        uint32_t word;
+        std::memcpy(&word, bytes + i, 4);
+        hash = (hash ^ word) * 0x100000001B3ULL;
+    }
+}
+
+uint64_t meshContentHash(const Mesh& mesh) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hashVector(hash, mesh.positions);
+    hashVector(hash, mesh.normals);
+    hashVector(hash, mesh.texcoords);
+    hashVector(hash, mesh.indices);
+    return hash;
+}
+
+template <typename T>
+static bool sameBytes(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+static bool sameContent(const Mesh& a, const Mesh& b) {
+    return a.texture == b.texture && sameBytes(a.positions, b.positions) && sameBytes(a.normals, b.normals)
+        && sameBytes(a.texcoords, b.texcoords) && sameBytes(a.indices, b.indices);
+}
+
+static uint64_t gpuBytes(const Mesh& mesh) {
+    return (mesh.positions.size() + mesh.normals.size()) * sizeof(glm::vec3) + mesh.texcoords.size() * sizeof(glm::vec2)
+        + mesh.indices.size() * sizeof(unsigned int);
+}
+
+unsigned int acquireMesh(Mesh& mesh, bool upload) {
+    PROFILE_FUNCTION();
+    meshRegistryStats.acquired++;
+    auto range = registry.equal_range(mesh.contentHash);
+    for (auto entry = range.first; entry != range.second;) {
+        unsigned int index = entry->second;
+        bool live = index < meshes.size() && meshes[index].references > 0 && meshes[index].contentHash == mesh.contentHash;
+        if (!live) {
+            entry = registry.erase(entry);
+            continue;
+        }
+        // rowny skrot to jeszcze nie ta sama siatka - porownanie calej zawartosci
+        if (sameContent(meshes[index], mesh)) {
+            meshes[index].references++;
+            meshRegistryStats.shared++;
+            meshRegistryStats.savedBytes += gpuBytes(mesh);
+            return index;
+        }
+        ++entry;
+    }
+
+    unsigned int index = (unsigned int)meshes.size();
+    meshes.push_back(std::move(mesh));
+    meshes[index].references = 1;
+    if (upload)
+        uploadMesh(meshes[index]);
+    registry.insert(std::make_pair(meshes[index].contentHash, index));
+    return index;
+}
+
+void releaseMesh(unsigned int index) {
+    Mesh& mesh = meshes[index];
+    if (mesh.references == 0 || --mesh.references > 0)
+        return;
+    glDeleteVertexArrays(MESH_LAYOUT_COUNT, mesh.VAO);
+    glDeleteBuffers(VERTEX_STREAM_COUNT, mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh = Mesh();
+}
+
+void releaseSceneGraph(SceneGraph& graph) {
+    std::vector<char> held(meshes.size(), 0);
+    for (unsigned int index : graph.meshIndices) {
+        if (index < held.size() && !held[index]) {
+            held[index] = 1;
+            releaseMesh(index);
+        }
+    }
+    graph = SceneGraph();
+}
+
+void retainSceneGraph(const SceneGraph& graph) {
+    std::vector<char> held(meshes.size(), 0);
+    for (unsigned int index : graph.meshIndices) {
+        if (index < held.size() && !held[index] && meshes[index].references > 0) {
+            held[index] = 1;
+            meshes[index].references++;
+        }
+    }
+}
+
+void printMeshRegistryReport() {
+    if (meshRegistryStats.acquired == 0)
+        return;
+    std::cout << "Mesh registry: " << meshRegistryStats.acquired << " meshes, " << meshRegistryStats.shared
+        << " shared with identical ones, " << meshRegistryStats.savedBytes / 1024 << " KB not uploaded" << std::endl;
+}
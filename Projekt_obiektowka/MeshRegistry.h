@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ModelLoader.h"
+
+struct MeshRegistryStats {
+    unsigned int acquired = 0;   // wszystkie zgloszone siatki
+    unsigned int shared = 0;     // z tego trafienia w juz wczytana siatke
+    uint64_t savedBytes = 0;     // pamiec GPU, ktorej nie trzeba bylo wysylac
+};
+
+extern MeshRegistryStats meshRegistryStats;
+
+// skrot zawartosci: pozycje, normalne, UV i indeksy (bajt w bajt); tekstura porownywana dopiero przy trafieniu
+uint64_t meshContentHash(const Mesh& mesh);
+
+// indeks w meshes: siatka o tej samej zawartosci (licznik referencji + 1) albo nowa - wtedy mesh jest
+// przenoszony do meshes i wysylany do GL (upload); mesh.contentHash musi byc juz policzony
+unsigned int acquireMesh(Mesh& mesh, bool upload);
+// licznik - 1, przy zerze zwalnia bufory GL i dane CPU; indeks zostaje zajety, zeby inne grafy sie nie przesunely
+void releaseMesh(unsigned int index);
+// graf trzyma jedna referencje na kazda rozna siatke z meshIndices (loadModel/loadGltf zwalniaja powtorzenia w pliku);
+// oddaje je i czysci graf
+void releaseSceneGraph(SceneGraph& graph);
+// kopia grafu (benchmarki, wypiekanie na kopii) dostaje wlasne referencje - potem zwalniana jak kazdy graf
+void retainSceneGraph(const SceneGraph& graph);
+
+void printMeshRegistryReport();
@@ -1,87 +1,325 @@
 #include "ModelLoader.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "MeshRegistry.h"
+#include "GltfLoader.h"
+#include "AssetIO.h"
+#include <algorithm>
+#include <cstring>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <unordered_set>
 
 std::vector<Mesh> meshes;
-Node rootNode;
+SceneGraph sceneGraph;
 
 glm::mat4 aiMatrix4x4ToGlm(const aiMatrix4x4& mat) {
     return glm::transpose(glm::make_mat4(&mat.a1));
 }
 
-Node processNode(aiNode* ainode) {
-    Node node;
-    node.transform = aiMatrix4x4ToGlm(ainode->mTransformation);
-    for (unsigned int i = 0; i < ainode->mNumMeshes; i++)
-        node.meshIndices.push_back(ainode->mMeshes[i]);
-    for (unsigned int i = 0; i < ainode->mNumChildren; i++)
-        node.children.push_back(processNode(ainode->mChildren[i]));
-    return node;
+void buildSceneGraph(const aiNode* root, unsigned int meshOffset, SceneGraph& graph) {
+    PROFILE_FUNCTION();
+    // 1. przejscie: liczba wezlow i odwolan do siatek, zeby zaalokowac wszystko raz
+    size_t nodeCount = 0, meshCount = 0;
+    std::vector<const aiNode*> pending(1, root);
+    while (!pending.empty()) {
+        const aiNode* ainode = pending.back();
+        pending.pop_back();
+        nodeCount++;
+        meshCount += ainode->mNumMeshes;
+        pending.insert(pending.end(), ainode->mChildren, ainode->mChildren + ainode->mNumChildren);
+    }
+
+    // 2. przejscie wszerz: nodes jest jednoczesnie kolejka, dzieci kazdego wezla dostaja kolejne indeksy
+    graph.nodes.resize(nodeCount);
+    graph.meshIndices.resize(meshCount);
+    pending.resize(nodeCount);
+    pending[0] = root;
+    uint32_t nextNode = 1, nextMesh = 0;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const aiNode* ainode = pending[i];
+        Node& node = graph.nodes[i];
+        node = Node();
+        node.transform = aiMatrix4x4ToGlm(ainode->mTransformation);
+        node.firstMesh = nextMesh;
+        node.meshCount = ainode->mNumMeshes;
+        for (unsigned int m = 0; m < ainode->mNumMeshes; ++m)
+            graph.meshIndices[nextMesh++] = meshOffset + ainode->mMeshes[m];
+        node.firstChild = nextNode;
+        node.childCount = ainode->mNumChildren;
+        for (unsigned int c = 0; c < ainode->mNumChildren; ++c)
+            pending[nextNode++] = ainode->mChildren[c];
+    }
+}
+
+void convertMesh(const aiMesh* mesh, Mesh& myMesh) {
+    PROFILE_FUNCTION();
+    myMesh.positions.resize(mesh->mNumVertices);
+    myMesh.normals.resize(mesh->mNumVertices);
+    myMesh.indices.reserve(mesh->mNumFaces * 3);
+    // aiProcess_FlipUVs - v od gory obrazu, jak w glTF i w danych z TextureManager
+    if (mesh->HasTextureCoords(0)) {
+        myMesh.texcoords.resize(mesh->mNumVertices);
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+            myMesh.texcoords[i] = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+    }
+    // wczytaj wierzchoki
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+        myMesh.positions[i] = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+        myMesh.normals[i] = { mesh->mNormals[i].x,  mesh->mNormals[i].y,  mesh->mNormals[i].z };
+    }
+    // wczytaj indeksy
+    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+        const aiFace& face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; ++j)
+            myMesh.indices.push_back(face.mIndices[j]);
+    }
+}
+
+void uploadMesh(Mesh& myMesh) {
+    uploadMeshData(myMesh, myMesh.positions.data(), myMesh.normals.empty() ? nullptr : myMesh.normals.data(),
+        myMesh.texcoords.empty() ? nullptr : myMesh.texcoords.data(), myMesh.positions.size(),
+        myMesh.indices.data(), myMesh.indices.size());
 }
 
-bool loadModel(const std::string& path) {
+void uploadMeshData(Mesh& myMesh, const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* texcoords,
+    size_t vertexCount, const unsigned int* indices, size_t indexCount) {
+    PROFILE_FUNCTION();
+    // VAO na kazdy layout, VBO na kazdy strumien, wspolny EBO
+    glGenVertexArrays(MESH_LAYOUT_COUNT, myMesh.VAO);
+    glGenBuffers(VERTEX_STREAM_COUNT, myMesh.VBO);
+    glGenBuffers(1, &myMesh.EBO);
+
+    uploadVertexStream<PositionStream>(myMesh.VBO, positions, vertexCount);
+    uploadVertexStream<NormalStream>(myMesh.VBO, normals, vertexCount);
+    if (texcoords)
+        uploadVertexStream<TexCoordStream>(myMesh.VBO, texcoords, vertexCount);
+    myMesh.indexCount = (GLsizei)indexCount;
+
+    glBindVertexArray(myMesh.VAO[LAYOUT_SHADED]);
+    ShadedLayout::bind(myMesh.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myMesh.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+
+    // EBO jest stanem VAO - trzeba go podpiac do kazdego
+    glBindVertexArray(myMesh.VAO[LAYOUT_POSITION_ONLY]);
+    PositionOnlyLayout::bind(myMesh.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myMesh.EBO);
+
+    // bez UV atrybut zostaje wylaczony - shader dostaje stala (0, 0), czyli jeden teksel (biala tekstura)
+    glBindVertexArray(myMesh.VAO[LAYOUT_TEXTURED]);
+    if (texcoords)
+        TexturedLayout::bind(myMesh.VBO);
+    else
+        ShadedLayout::bind(myMesh.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myMesh.EBO);
+    glBindVertexArray(0);
+}
+
+// kolor bazowy materialu (glTF/PBR) albo diffuse; osadzona skompresowana ("*N") - prosto z pamieci importera
+static uint32_t materialTexture(const aiScene* scene, const aiMesh* mesh, const std::string& path, const std::string& directory) {
+    if (mesh->mMaterialIndex >= scene->mNumMaterials || !mesh->HasTextureCoords(0))
+        return NO_TEXTURE;
+    const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+    aiString file;
+    if (material->GetTexture(aiTextureType_BASE_COLOR, 0, &file) != AI_SUCCESS
+        && material->GetTexture(aiTextureType_DIFFUSE, 0, &file) != AI_SUCCESS)
+        return NO_TEXTURE;
+    if (const aiTexture* embedded = scene->GetEmbeddedTexture(file.C_Str())) {
+        // mHeight != 0 - rozpakowane teksele aiTexel (rzadkie), pomijane
+        if (embedded->mHeight != 0)
+            return NO_TEXTURE;
+        return requestTextureFromMemory(path + "#" + file.C_Str(), (const unsigned char*)embedded->pcData, embedded->mWidth);
+    }
+    return requestTexture(directory + file.C_Str());
+}
+
+bool loadModel(const std::string& path, bool retainCpuData) {
+    PROFILE_FUNCTION();
+    if (isGltfPath(path)) {
+        if (loadGltf(path, sceneGraph, retainCpuData))
+            return true;
+        std::cerr << "glTF loader failed, trying Assimp: " << path << std::endl;
+    }
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path,
-        aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_JoinIdenticalVertices);
+    // mmap zamiast stdio, pliki moga tez pochodzic z zamontowanej paczki
+    importer.SetIOHandler(createAssetIOSystem());
+    const aiScene* scene;
+    {
+        PROFILE_SCOPE("Assimp::ReadFile");
+        scene = importer.ReadFile(path,
+            aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs);
+    }
     if (!scene || !scene->HasMeshes()) {
         std::cerr << "Assimp error: " << importer.GetErrorString() << std::endl;
         return false;
     }
 
+    // konwersja aiMesh -> Mesh i skrot zawartosci rownolegle, rejestr i upload do GL tylko z watku kontekstu
+    std::vector<Mesh> loaded(scene->mNumMeshes);
+    parallelFor(0, scene->mNumMeshes, [&](size_t m) {
+        convertMesh(scene->mMeshes[m], loaded[m]);
+        loaded[m].contentHash = meshContentHash(loaded[m]);
+    });
+    // ta sama geometria z inna tekstura to dla MeshRegistry inna siatka
+    size_t slash = path.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+        loaded[m].texture = materialTexture(scene, scene->mMeshes[m], path, directory);
+    // identyczne siatki (tez z wczesniej wczytanych modeli) dostaja ten sam indeks; powtorzenie w tym samym
+    // pliku oddaje dodatkowa referencje - graf trzyma jedna na siatke (releaseSceneGraph)
+    std::vector<unsigned int> meshIndex(scene->mNumMeshes);
+    std::unordered_set<unsigned int> held;
     for (unsigned int m = 0; m < scene->mNumMeshes; ++m) {
-        const aiMesh* mesh = scene->mMeshes[m];
-        Mesh myMesh;
-        // wczytaj wierzchoki
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            Vertex vertex;
-            vertex.position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
-            vertex.normal = { mesh->mNormals[i].x,  mesh->mNormals[i].y,  mesh->mNormals[i].z };
-            myMesh.vertices.push_back(vertex);
-        }
-        // wczytaj indeksy
-        for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-            const aiFace& face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; ++j)
-                myMesh.indices.push_back(face.mIndices[j]);
-        }
-        // VAO/VBO/EBO
-        glGenVertexArrays(1, &myMesh.VAO);
-        glGenBuffers(1, &myMesh.VBO);
-        glGenBuffers(1, &myMesh.EBO);
-
-        glBindVertexArray(myMesh.VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, myMesh.VBO);
-        glBufferData(GL_ARRAY_BUFFER,
-            myMesh.vertices.size() * sizeof(Vertex),
-            myMesh.vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myMesh.EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            myMesh.indices.size() * sizeof(unsigned int),
-            myMesh.indices.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        glEnableVertexAttribArray(0);
-        glBindVertexArray(0);
-
-        meshes.push_back(myMesh);
+        meshIndex[m] = acquireMesh(loaded[m], true);
+        if (!held.insert(meshIndex[m]).second)
+            releaseMesh(meshIndex[m]);
     }
 
-    rootNode = processNode(scene->mRootNode);
+    buildSceneGraph(scene->mRootNode, 0, sceneGraph);
+    for (unsigned int& index : sceneGraph.meshIndices)
+        index = meshIndex[index];
     return true;
 }
 
-void drawNode(const Node& node, const glm::mat4& parentTransform, GLuint shaderProgram) {
-    glm::mat4 globalTransform = parentTransform * node.transform;
-    for (unsigned int i : node.meshIndices) {
-        const Mesh& mesh = meshes[i];
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"),
-            1, GL_FALSE, glm::value_ptr(globalTransform));
-        glBindVertexArray(mesh.VAO);
-        glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
+// pakiet rysowania zebrany podczas przejscia drzewa (macierz w osobnej tablicy, wspolna dla siatek wezla)
+struct DrawPacket {
+    GLuint VAO;
+    GLsizei indexCount;
+    uint32_t transform;
+    GLuint texture;  // tylko LAYOUT_TEXTURED, inaczej 0
+};
+
+// przejscie bez rekurencji dla drawNodeInstanced: stos, macierze i lista rysowania na arenie klatki
+// (zero alokacji na stercie), pakiety w kolejnosci rodzic przed dziecmi
+static void collectDrawPackets(const SceneGraph& graph, uint32_t node, const glm::mat4& parentTransform,
+    MeshLayout layout, FrameVector<glm::mat4>& transforms, FrameVector<DrawPacket>& packets) {
+    struct PendingNode {
+        uint32_t node;
+        uint32_t parent;
+    };
+    FrameVector<PendingNode> stack;
+    stack.reserve(64);
+
+    stack.push_back({ node, (uint32_t)transforms.size() });
+    transforms.push_back(parentTransform);
+    while (!stack.empty()) {
+        PendingNode pending = stack.back();
+        stack.pop_back();
+        uint32_t index = (uint32_t)transforms.size();
+        const Node& current = graph.nodes[pending.node];
+        transforms.push_back(transforms[pending.parent] * current.transform);
+        for (uint32_t m = current.firstMesh; m < current.firstMesh + current.meshCount; ++m) {
+            const Mesh& mesh = meshes[graph.meshIndices[m]];
+            GLuint texture = layout == LAYOUT_TEXTURED ? textureId(mesh.texture) : 0;
+            packets.push_back({ mesh.VAO[layout], mesh.indexCount, index, texture });
+        }
+        for (uint32_t c = current.childCount; c-- > 0;)
+            stack.push_back({ current.firstChild + c, index });
+    }
+}
+
+void drawNode(const SceneGraph& graph, uint32_t node, const glm::mat4& parentTransform, GLuint shaderProgram,
+    MeshLayout layout) {
+    PROFILE_FUNCTION();
+    // jedno przejscie z rysowaniem od razu (lista pakietow potrzebna tylko do sortowania przy instancjach).
+    // Stos w glab i macierze swiata po glebokosci na arenie klatki przez surowe wskazniki - push_back
+    // wektora sprawdzal pojemnosc i przeladowywal wskazniki po kazdym wywolaniu GL
+    struct PendingNode {
+        uint32_t node;
+        uint32_t depth;
+    };
+    LinearArena& arena = frameArena();
+    // kazdy wezel poddrzewa trafia na stos najwyzej raz
+    PendingNode* stack = static_cast<PendingNode*>(
+        arenaAllocate(arena, (graph.nodes.size() - node) * sizeof(PendingNode)));
+    size_t stackSize = 0;
+    // rodzenstwo nadpisuje swoj poziom dopiero po calym poddrzewie poprzednika
+    size_t depthCapacity = 16;
+    glm::mat4* levels = static_cast<glm::mat4*>(arenaAllocate(arena, depthCapacity * sizeof(glm::mat4)));
+    levels[0] = parentTransform;
+
+    GLint modelLocation = glGetUniformLocation(shaderProgram, "model");
+    GLuint boundVAO = 0, boundTexture = 0;
+    stack[stackSize++] = { node, 1 };
+    while (stackSize) {
+        PendingNode pending = stack[--stackSize];
+        const Node& current = graph.nodes[pending.node];
+        if (pending.depth == depthCapacity) {
+            glm::mat4* grown = static_cast<glm::mat4*>(arenaAllocate(arena, 2 * depthCapacity * sizeof(glm::mat4)));
+            std::memcpy(grown, levels, depthCapacity * sizeof(glm::mat4));
+            levels = grown;
+            depthCapacity *= 2;
+        }
+        levels[pending.depth] = levels[pending.depth - 1] * current.transform;
+
+        if (current.meshCount)
+            glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(levels[pending.depth]));
+        for (uint32_t m = current.firstMesh; m < current.firstMesh + current.meshCount; ++m) {
+            const Mesh& mesh = meshes[graph.meshIndices[m]];
+            if (mesh.VAO[layout] != boundVAO) {
+                glBindVertexArray(mesh.VAO[layout]);
+                boundVAO = mesh.VAO[layout];
+            }
+            if (layout == LAYOUT_TEXTURED) {
+                GLuint texture = textureId(mesh.texture);
+                if (texture != boundTexture) {
+                    glBindTexture(GL_TEXTURE_2D, texture);
+                    boundTexture = texture;
+                }
+            }
+            glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+        }
+        for (uint32_t c = current.childCount; c-- > 0;)
+            stack[stackSize++] = { current.firstChild + c, pending.depth + 1 };
+    }
+}
+
+// wspolny bufor macierzy instancji, co wywolanie wypelniany od nowa (stara zawartosc porzucana - bez czekania na GPU)
+static GLuint instanceBuffer = 0;
+
+void drawNodeInstanced(const SceneGraph& graph, uint32_t node, const glm::mat4* parentTransforms, size_t count,
+    MeshLayout layout) {
+    PROFILE_FUNCTION();
+    static thread_local size_t lastNodeCount = 0, lastPacketCount = 0;
+    FrameVector<glm::mat4> transforms;
+    FrameVector<DrawPacket> packets;
+    transforms.reserve(lastNodeCount + count);
+    packets.reserve(lastPacketCount);
+    for (size_t i = 0; i < count; ++i)
+        collectDrawPackets(graph, node, parentTransforms[i], layout, transforms, packets);
+    lastNodeCount = transforms.size();
+    lastPacketCount = packets.size();
+    if (packets.empty())
+        return;
+
+    // ta sama siatka = ten sam VAO; po sortowaniu kazda seria to jedno rysowanie
+    std::sort(packets.begin(), packets.end(),
+        [](const DrawPacket& a, const DrawPacket& b) { return a.VAO < b.VAO; });
+    FrameVector<glm::mat4> instances;
+    instances.reserve(packets.size());
+    for (const DrawPacket& packet : packets)
+        instances.push_back(transforms[packet.transform]);
+
+    if (!instanceBuffer)
+        glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::mat4), instances.data(), GL_STREAM_DRAW);
+
+    // GL 3.3 nie ma baseInstance - przesuniecie serii w buforze idzie w glVertexAttribPointer
+    for (size_t first = 0; first < packets.size();) {
+        size_t last = first + 1;
+        while (last < packets.size() && packets[last].VAO == packets[first].VAO)
+            ++last;
+        glBindVertexArray(packets[first].VAO);
+        if (layout == LAYOUT_TEXTURED)
+            glBindTexture(GL_TEXTURE_2D, packets[first].texture);
+        bindInstanceMatrix(ATTRIBUTE_INSTANCE_MODEL, first * sizeof(glm::mat4));
+        glDrawElementsInstanced(GL_TRIANGLES, packets[first].indexCount, GL_UNSIGNED_INT, 0, (GLsizei)(last - first));
+        first = last;
     }
-    for (const Node& child : node.children)
-        drawNode(child, globalTransform, shaderProgram);
+    glBindVertexArray(0);
 }
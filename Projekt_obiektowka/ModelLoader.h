@@ -2,33 +2,65 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <cstdint>
 #include <string>
 #include <glad/glad.h>
 #include <assimp/scene.h>
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 normal;
-};
+#include "VertexLayout.h"
+#include "TextureManager.h"
 
+// atrybuty w osobnych strumieniach (VertexLayout.h) - przebieg glebokosci czyta tylko pozycje
 struct Mesh {
-    std::vector<Vertex> vertices;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texcoords;  // puste - siatka bez UV
     std::vector<unsigned int> indices;
-    GLuint VAO, VBO, EBO;
+    GLuint VAO[MESH_LAYOUT_COUNT] = {};
+    GLuint VBO[VERTEX_STREAM_COUNT] = {};
+    GLuint EBO = 0;
+    GLsizei indexCount = 0;       // ustawiane przy uploadzie - indices moze byc puste (upload bez kopii CPU)
+    uint64_t contentHash = 0;     // MeshRegistry - wspolne bufory dla identycznych siatek
+    uint32_t references = 0;
+    uint32_t texture = NO_TEXTURE;  // TextureManager.h, wspolna dla wszystkich instancji siatki
 };
 
+// wezel w plaskiej tablicy: siatki i dzieci to zakresy indeksow, bez wlasnych wektorow
 struct Node {
-    glm::mat4 transform;
+    glm::mat4 transform = glm::mat4(1.0f);
+    uint32_t firstMesh = 0, meshCount = 0;    // zakres w SceneGraph::meshIndices
+    uint32_t firstChild = 0, childCount = 0;  // dzieci leza w nodes jedno za drugim
+    bool dynamic = false;  // transformacja moze sie zmieniac w czasie (nie do statycznych paczek)
+};
+
+// nodes[0] - korzen, rodzic zawsze przed dziecmi
+struct SceneGraph {
+    std::vector<Node> nodes;
     std::vector<unsigned int> meshIndices;
-    std::vector<Node> children;
 };
 
 // globalne kontenery
 extern std::vector<Mesh> meshes;
-extern Node rootNode;
+extern SceneGraph sceneGraph;
+
+// adowanie modelu z pliku: .gltf/.glb wlasnym loaderem (GltfLoader.h), reszta i nieobslugiwane glTF przez Assimp;
+// retainCpuData == false pozwala glTF wyslac bufory do GL bez kopii w Mesh (bez MeshRegistry i statycznych paczek)
+bool loadModel(const std::string& path, bool retainCpuData = true);
+
+// wyslanie strumieni i indeksow siatki do GL, po jednym VAO na MeshLayout
+void uploadMesh(Mesh& myMesh);
+// to samo z dowolnej pamieci (np. zmapowanego pliku), bez wypelniania wektorow Mesh
+// texcoords moze byc nullptr
+void uploadMeshData(Mesh& myMesh, const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* texcoords,
+    size_t vertexCount, const unsigned int* indices, size_t indexCount);
 
-// adowanie modelu z pliku
-bool loadModel(const std::string& path);
+// hierarchia Assimp -> plaska tablica wezlow (wszerz, bez rekurencji); meshOffset - indeks pierwszej siatki modelu w meshes
+void buildSceneGraph(const aiNode* root, unsigned int meshOffset, SceneGraph& graph);
 
-// rysowanie caego drzewa sceny
-void drawNode(const Node& node, const glm::mat4& parentTransform, GLuint shaderProgram);
+// rysowanie caego drzewa sceny; layout - strumienie, ktore czyta shader
+void drawNode(const SceneGraph& graph, uint32_t node, const glm::mat4& parentTransform, GLuint shaderProgram,
+    MeshLayout layout = LAYOUT_SHADED);
+// drzewo dla kazdej z count macierzy rodzica naraz; wezly z ta sama siatka (takze u roznych rodzicow)
+// ida jednym glDrawElementsInstanced - shader z wariantem SHADER_INSTANCING
+void drawNodeInstanced(const SceneGraph& graph, uint32_t node, const glm::mat4* parentTransforms, size_t count,
+    MeshLayout layout = LAYOUT_SHADED);
@@ -0,0 +1,116 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+const size_t PROFILE_RING_CAPACITY = 1 << 17;
+
+// pierscien jednego watku: pisze tylko wlasciciel, eksport czyta
+struct ProfileThread {
+    uint32_t id = 0;
+    const char* name = nullptr;
+    std::atomic<uint64_t> head{ 0 };
+    std::unique_ptr<ProfileEvent[]> events{ new ProfileEvent[PROFILE_RING_CAPACITY] };
+};
+
+static std::mutex profileMutex;
+static std::vector<std::unique_ptr<ProfileThread>> profileThreads;
+static std::unordered_set<std::string> profileNames;
+static thread_local ProfileThread* currentThread = nullptr;
+static const std::chrono::steady_clock::time_point profileStart = std::chrono::steady_clock::now();
+
+static ProfileThread& profileThread() {
+    if (!currentThread) {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        profileThreads.emplace_back(new ProfileThread());
+        currentThread = profileThreads.back().get();
+        currentThread->id = (uint32_t)profileThreads.size();
+    }
+    return *currentThread;
+}
+
+uint64_t profileNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - profileStart).count();
+}
+
+void recordProfileEvent(const char* name, uint64_t startNs, uint64_t endNs) {
+    ProfileThread& thread = profileThread();
+    uint64_t head = thread.head.load(std::memory_order_relaxed);
+    thread.events[head & (PROFILE_RING_CAPACITY - 1)] = { name, startNs, endNs };
+    thread.head.store(head + 1, std::memory_order_release);
+}
+
+void setProfileThreadName(const char* name) {
+    profileThread().name = name;
+}
+
+const char* internProfileName(const std::string& name) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return profileNames.insert(name).first->c_str();
+}
+
+static void writeJsonString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "ERROR::PROFILER::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    bool first = true;
+    size_t eventCount = 0;
+    std::vector<ProfileEvent> events;
+    for (const std::unique_ptr<ProfileThread>& thread : profileThreads) {
+        if (thread->name) {
+            out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread->id
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, thread->name);
+            out << "}}";
+            first = false;
+        }
+
+        // watek moze dalej pisac - odrzucamy to, co mogl w miedzyczasie nadpisac
+        uint64_t head = thread->head.load(std::memory_order_acquire);
+        uint64_t begin = head > PROFILE_RING_CAPACITY ? head - PROFILE_RING_CAPACITY : 0;
+        events.clear();
+        for (uint64_t i = begin; i < head; ++i)
+            events.push_back(thread->events[i & (PROFILE_RING_CAPACITY - 1)]);
+        uint64_t headAfter = thread->head.load(std::memory_order_acquire);
+        uint64_t safeBegin = headAfter > PROFILE_RING_CAPACITY ? headAfter - PROFILE_RING_CAPACITY : 0;
+        size_t overwritten = (size_t)std::min<uint64_t>(events.size(), safeBegin > begin ? safeBegin - begin : 0);
+
+        for (size_t i = overwritten; i < events.size(); ++i) {
+            const ProfileEvent& event = events[i];
+            out << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"pid\":1,\"tid\":" << thread->id << ",\"ts\":" << event.startNs / 1000.0
+                << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << "}";
+            first = false;
+            eventCount++;
+        }
+    }
+    out << "\n]}\n";
+    std::cout << "Trace: " << eventCount << " events from " << profileThreads.size()
+        << " threads written to " << path << std::endl;
+    return true;
+}
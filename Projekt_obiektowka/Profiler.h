@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// PROFILE_ENABLED=0 usuwa wszystkie pomiary z kompilacji (makra rozwijaja sie do niczego)
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+uint64_t profileNow();
+// zdarzenie idzie do pierscienia biezacego watku - bez blokad, najstarsze sa nadpisywane
+void recordProfileEvent(const char* name, uint64_t startNs, uint64_t endNs);
+void setProfileThreadName(const char* name);
+// nazwy zdarzen musza zyc do eksportu; dla napisow budowanych w locie - trwala kopia
+const char* internProfileName(const std::string& name);
+// format Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+bool writeChromeTrace(const std::string& path);
+
+struct ProfileScope {
+    const char* name;
+    uint64_t startNs;
+
+    explicit ProfileScope(const char* scopeName) : name(scopeName), startNs(profileNow()) {}
+    ~ProfileScope() { recordProfileEvent(name, startNs, profileNow()); }
+};
+
+#if PROFILE_ENABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD(name) setProfileThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
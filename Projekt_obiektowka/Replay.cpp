@@ -0,0 +1,282 @@
+#include "Replay.h"
+#include "Snapshot.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+const uint32_t REPLAY_MAGIC = 0x50525244; // "DRRP"
+const uint32_t REPLAY_VERSION = 2;
+const uint32_t CHUNK_KEYFRAME = 1;
+const uint32_t CHUNK_INPUTS = 2;
+
+struct ReplayFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t keyframeInterval;
+};
+
+struct ReplayChunkHeader {
+    uint32_t type;
+    uint32_t size;
+    uint64_t step;
+};
+
+struct ReplayFooter {
+    uint64_t indexOffset;
+    uint64_t keyframeCount;
+    uint64_t lastStep;
+    uint32_t magic;
+    uint32_t reserved;
+};
+
+static uint64_t stepTimeNs(uint64_t step) {
+    return step * NANOSECONDS_PER_SECOND / PHYSICS_RATE;
+}
+
+// klatka kluczowa w pliku: naglowek porcji, czas harmonogramu, migawka stanu
+const size_t KEYFRAME_TIME_BYTES = sizeof(uint64_t);
+
+static void writeChunk(ReplayRecorder& recorder, uint32_t type, uint64_t step, const void* data, size_t size) {
+    ReplayChunkHeader header = { type, (uint32_t)size, step };
+    recorder.out.write((const char*)&header, sizeof(header));
+    recorder.out.write((const char*)data, size);
+    recorder.offset += sizeof(header) + size;
+}
+
+static void writeKeyframe(ReplayRecorder& recorder, const SimState& state, uint64_t timeNs) {
+    recorder.scratch.resize(KEYFRAME_TIME_BYTES + snapshotSize(state.drones.size()));
+    std::memcpy(recorder.scratch.data(), &timeNs, KEYFRAME_TIME_BYTES);
+    storeSnapshot(state, recorder.scratch.data() + KEYFRAME_TIME_BYTES);
+
+    recorder.keyframes.push_back({ state.step, recorder.offset, timeNs });
+    writeChunk(recorder, CHUNK_KEYFRAME, state.step, recorder.scratch.data(), recorder.scratch.size());
+    // po awarii tracimy najwyzej ostatni odcinek miedzy klatkami
+    recorder.out.flush();
+}
+
+bool openReplayRecorder(ReplayRecorder& recorder, const std::string& path, const SimState& state, uint64_t keyframeInterval) {
+    recorder.out.open(path, std::ios::binary | std::ios::trunc);
+    if (!recorder.out) {
+        std::cerr << "ERROR::REPLAY::CANNOT_CREATE " << path << std::endl;
+        return false;
+    }
+    recorder.keyframeInterval = keyframeInterval;
+    ReplayFileHeader header = { REPLAY_MAGIC, REPLAY_VERSION, keyframeInterval };
+    recorder.out.write((const char*)&header, sizeof(header));
+    recorder.offset = sizeof(header);
+    // harmonogram symulacji startuje od zera
+    writeKeyframe(recorder, state, 0);
+    return true;
+}
+
+void recordReplayInputs(ReplayRecorder& recorder, uint64_t step, const std::vector<DroneCommand>& commands) {
+    if (!commands.empty())
+        writeChunk(recorder, CHUNK_INPUTS, step, commands.data(), commands.size() * sizeof(DroneCommand));
+}
+
+void recordReplayKeyframe(ReplayRecorder& recorder, const SimState& state, uint64_t timeNs) {
+    if (state.step % recorder.keyframeInterval == 0 && state.step != recorder.keyframes.back().step)
+        writeKeyframe(recorder, state, timeNs);
+}
+
+void closeReplayRecorder(ReplayRecorder& recorder) {
+    if (!recorder.out.is_open())
+        return;
+    ReplayFooter footer = { recorder.offset, recorder.keyframes.size(),
+        recorder.keyframes.empty() ? 0 : recorder.keyframes.back().step, REPLAY_MAGIC, 0 };
+    recorder.out.write((const char*)recorder.keyframes.data(), recorder.keyframes.size() * sizeof(ReplayKeyframe));
+    recorder.out.write((const char*)&footer, sizeof(footer));
+    recorder.out.close();
+    std::cout << "Replay: " << recorder.keyframes.size() << " keyframes, "
+        << recorder.offset << " bytes" << std::endl;
+}
+
+// --- odtwarzanie ---
+
+static bool readChunk(const ReplayPlayer& player, size_t offset, ReplayChunkHeader& header) {
+    if (offset + sizeof(header) > player.dataEnd)
+        return false;
+    std::memcpy(&header, player.file.data + offset, sizeof(header));
+    return offset + sizeof(header) + header.size <= player.dataEnd;
+}
+
+// porcja klatki w danych, z migawka pelnej dlugosci
+static bool validKeyframe(const ReplayPlayer& player, const ReplayKeyframe& keyframe) {
+    ReplayChunkHeader header;
+    if (keyframe.offset > player.dataEnd || !readChunk(player, (size_t)keyframe.offset, header))
+        return false;
+    SimSnapshotHeader snapshot;
+    if (header.type != CHUNK_KEYFRAME || header.step != keyframe.step
+        || header.size < KEYFRAME_TIME_BYTES + sizeof(snapshot))
+        return false;
+    std::memcpy(&snapshot, player.file.data + keyframe.offset + sizeof(header) + KEYFRAME_TIME_BYTES, sizeof(snapshot));
+    return snapshot.droneCount <= (header.size - KEYFRAME_TIME_BYTES) / sizeof(DroneState)
+        && snapshotSize((size_t)snapshot.droneCount) == header.size - KEYFRAME_TIME_BYTES;
+}
+
+static void loadKeyframe(ReplayPlayer& player, const ReplayKeyframe& keyframe) {
+    loadSnapshot(player.file.data + keyframe.offset + sizeof(ReplayChunkHeader) + KEYFRAME_TIME_BYTES, player.state);
+    player.cursor = (size_t)keyframe.offset;
+}
+
+// komendy z biezacego kroku + kontrola zgodnosci z zapisanymi klatkami
+static void applyReplayInputs(ReplayPlayer& player) {
+    ReplayChunkHeader header;
+    while (readChunk(player, player.cursor, header) && header.step <= player.state.step) {
+        const unsigned char* payload = player.file.data + player.cursor + sizeof(header);
+        if (header.step == player.state.step) {
+            if (header.type == CHUNK_INPUTS) {
+                size_t count = header.size / sizeof(DroneCommand);
+                for (size_t i = 0; i < count; ++i) {
+                    DroneCommand command;
+                    std::memcpy(&command, payload + i * sizeof(DroneCommand), sizeof(command));
+                    applyDroneCommand(player.state, command);
+                }
+            } else if (header.type == CHUNK_KEYFRAME) {
+                size_t stateBytes = player.state.drones.size() * sizeof(DroneState);
+                bool same = header.size == KEYFRAME_TIME_BYTES + sizeof(SimSnapshotHeader) + stateBytes
+                    && std::memcmp(payload + KEYFRAME_TIME_BYTES + sizeof(SimSnapshotHeader), player.state.drones.data(),
+                        stateBytes) == 0;
+                player.verifiedKeyframes++;
+                if (!same) {
+                    player.divergentKeyframes++;
+                    std::cerr << "Replay diverged at step " << header.step << std::endl;
+                }
+            }
+        }
+        player.cursor += sizeof(header) + header.size;
+    }
+}
+
+static bool scanChunks(ReplayPlayer& player) {
+    size_t offset = sizeof(ReplayFileHeader);
+    ReplayChunkHeader header;
+    while (readChunk(player, offset, header)) {
+        if (header.type == CHUNK_KEYFRAME && header.size >= KEYFRAME_TIME_BYTES) {
+            uint64_t timeNs;
+            std::memcpy(&timeNs, player.file.data + offset + sizeof(header), KEYFRAME_TIME_BYTES);
+            player.keyframes.push_back({ header.step, offset, timeNs });
+        }
+        player.lastStep = std::max(player.lastStep, header.step);
+        offset += sizeof(header) + header.size;
+    }
+    player.dataEnd = offset;
+    return !player.keyframes.empty();
+}
+
+bool openReplayPlayer(ReplayPlayer& player, const std::string& path) {
+    if (!mapFileForRead(player.file, path)) {
+        std::cerr << "ERROR::REPLAY::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    ReplayFileHeader header;
+    if (player.file.size < sizeof(header)) {
+        closeMappedFile(player.file);
+        return false;
+    }
+    std::memcpy(&header, player.file.data, sizeof(header));
+    if (header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION) {
+        std::cerr << "ERROR::REPLAY::BAD_FILE " << path << std::endl;
+        closeMappedFile(player.file);
+        return false;
+    }
+    player.keyframeInterval = header.keyframeInterval;
+
+    // stopka tylko, gdy indeks wypelnia dokladnie miejsce miedzy danymi a nia
+    ReplayFooter footer = {};
+    size_t indexEnd = 0;
+    if (player.file.size >= sizeof(header) + sizeof(footer)) {
+        std::memcpy(&footer, player.file.data + player.file.size - sizeof(footer), sizeof(footer));
+        indexEnd = player.file.size - sizeof(footer);
+    }
+    bool indexed = footer.magic == REPLAY_MAGIC && footer.indexOffset >= sizeof(header) && footer.indexOffset <= indexEnd
+        && footer.keyframeCount == (indexEnd - footer.indexOffset) / sizeof(ReplayKeyframe)
+        && footer.keyframeCount * sizeof(ReplayKeyframe) == indexEnd - footer.indexOffset;
+    if (indexed) {
+        player.dataEnd = (size_t)footer.indexOffset;
+        player.lastStep = footer.lastStep;
+        player.keyframes.resize((size_t)footer.keyframeCount);
+        std::memcpy(player.keyframes.data(), player.file.data + footer.indexOffset,
+            player.keyframes.size() * sizeof(ReplayKeyframe));
+    } else {
+        std::cout << "Replay: no index (unfinished recording), scanning" << std::endl;
+        player.dataEnd = player.file.size;
+        if (!scanChunks(player)) {
+            closeMappedFile(player.file);
+            return false;
+        }
+    }
+    for (const ReplayKeyframe& keyframe : player.keyframes) {
+        if (!validKeyframe(player, keyframe)) {
+            std::cerr << "ERROR::REPLAY::BAD_KEYFRAME step " << keyframe.step << " in " << path << std::endl;
+            closeMappedFile(player.file);
+            return false;
+        }
+    }
+    adviseSequential(player.file);
+
+    // nagranie powstalo bez porzucania tickow - odtwarzanie tez, inaczej kolejnosc podsystemow sie rozjedzie
+    player.scheduler.maxLagNs = SCHEDULER_NO_LAG_LIMIT;
+
+    addSubsystem(player.scheduler, "replay", PHYSICS_RATE, [&player](float) { applyReplayInputs(player); });
+    registerSimulationSubsystems(player.scheduler, player.state);
+    return seekReplay(player, 0);
+}
+
+bool seekReplay(ReplayPlayer& player, uint64_t step) {
+    PROFILE_FUNCTION();
+    step = std::min(step, player.lastStep);
+    auto next = std::upper_bound(player.keyframes.begin(), player.keyframes.end(), step,
+        [](uint64_t s, const ReplayKeyframe& keyframe) { return s < keyframe.step; });
+    if (next == player.keyframes.begin())
+        return false;
+
+    // czas klatki z nagrania (tick fizyki, w ktorym powstala), dalej tyle tickow ile brakuje do step
+    const ReplayKeyframe& keyframe = *(next - 1);
+    loadKeyframe(player, keyframe);
+    uint64_t keyframeTick = (keyframe.timeNs * PHYSICS_RATE + NANOSECONDS_PER_SECOND - 1) / NANOSECONDS_PER_SECOND;
+    resetScheduler(player.scheduler, keyframe.timeNs);
+    runSchedulerUntil(player.scheduler, stepTimeNs(keyframeTick + step - keyframe.step));
+    return true;
+}
+
+void closeReplayPlayer(ReplayPlayer& player) {
+    std::cout << "Replay: " << player.verifiedKeyframes << " keyframes verified, "
+        << player.divergentKeyframes << " diverged" << std::endl;
+    closeMappedFile(player.file);
+}
+
+void runReplayThread(ReplayPlayer& player, TripleBuffer<RenderSnapshot>& snapshots, SimControl& control) {
+    PROFILE_THREAD("replay");
+    using clock = std::chrono::steady_clock;
+
+    auto publish = [&]() {
+        buildSnapshot(player.state, snapshots.writeBuffer());
+        snapshots.publish();
+    };
+    addSubsystem(player.scheduler, "publish", PUBLISH_RATE, [&](float) { publish(); });
+
+    auto last = clock::now();
+    while (control.running.load(std::memory_order_relaxed)) {
+        auto now = clock::now();
+        double wallSeconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        float seek = control.seekSeconds.exchange(0.0f);
+        if (seek != 0.0f) {
+            int64_t target = (int64_t)player.state.step + (int64_t)(seek * PHYSICS_RATE);
+            seekReplay(player, (uint64_t)std::max<int64_t>(target, 0));
+            publish();
+        }
+
+        // koniec nagrania - stoimy na ostatnim kroku
+        player.scheduler.paused = control.paused.load(std::memory_order_relaxed) || player.state.step >= player.lastStep;
+        player.scheduler.timeScale = control.timeScale.load(std::memory_order_relaxed);
+        advanceScheduler(player.scheduler, wallSeconds);
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(secondsUntilNextTick(player.scheduler)));
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "Simulation.h"
+#include "Scheduler.h"
+
+// nagranie = co keyframeInterval krokow pelny stan + wszystkie komendy z numerem kroku;
+// szum czujnikow zalezy tylko od (seed, krok), wiec wystarcza seed z klatki kluczowej.
+// Czas harmonogramu zapisany osobno - krok nie musi byc rowny czasowi / okres fizyki
+struct ReplayKeyframe {
+    uint64_t step;
+    uint64_t offset;
+    uint64_t timeNs;
+};
+
+struct ReplayRecorder {
+    std::ofstream out;
+    uint64_t offset = 0;
+    uint64_t keyframeInterval = 1000;
+    std::vector<ReplayKeyframe> keyframes;
+    std::vector<unsigned char> scratch;
+};
+
+bool openReplayRecorder(ReplayRecorder& recorder, const std::string& path, const SimState& state, uint64_t keyframeInterval);
+void recordReplayInputs(ReplayRecorder& recorder, uint64_t step, const std::vector<DroneCommand>& commands);
+// zapisuje klatke tylko gdy step jest wielokrotnoscia keyframeInterval; timeNs - czas harmonogramu
+// (nagrywajacy harmonogram nie moze porzucac tickow, inaczej powtorka sie rozjedzie)
+void recordReplayKeyframe(ReplayRecorder& recorder, const SimState& state, uint64_t timeNs);
+void closeReplayRecorder(ReplayRecorder& recorder);
+
+struct ReplayPlayer {
+    MappedFile file;
+    uint64_t keyframeInterval = 0;
+    uint64_t lastStep = 0;
+    size_t dataEnd = 0;
+    size_t cursor = 0;
+    std::vector<ReplayKeyframe> keyframes;
+
+    SimState state;
+    SimScheduler scheduler;
+    uint64_t verifiedKeyframes = 0;
+    uint64_t divergentKeyframes = 0;
+};
+
+// nagranie bez stopki (np. po awarii) jest odczytywane przez przeskanowanie porcji
+bool openReplayPlayer(ReplayPlayer& player, const std::string& path);
+// klatka kluczowa <= step (wyszukiwanie binarne) + dosymulowanie najwyzej keyframeInterval krokow
+bool seekReplay(ReplayPlayer& player, uint64_t step);
+void closeReplayPlayer(ReplayPlayer& player);
+
+void runReplayThread(ReplayPlayer& player, TripleBuffer<RenderSnapshot>& snapshots, SimControl& control);
@@ -0,0 +1,131 @@
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+#include <algorithm>
+#include <iostream>
+
+static uint64_t tickTime(const ScheduledSubsystem& subsystem, uint64_t tickIndex) {
+    return tickIndex * NANOSECONDS_PER_SECOND / subsystem.rateHz;
+}
+
+// kopiec minimalny po (czas ticku, kolejnosc rejestracji)
+struct LaterTick {
+    const std::vector<ScheduledSubsystem>* subsystems;
+    bool operator()(unsigned int a, unsigned int b) const {
+        const ScheduledSubsystem& sa = (*subsystems)[a];
+        const ScheduledSubsystem& sb = (*subsystems)[b];
+        if (sa.nextTickNs != sb.nextTickNs)
+            return sa.nextTickNs > sb.nextTickNs;
+        return a > b;
+    }
+};
+
+static void rebuildHeap(SimScheduler& scheduler) {
+    std::make_heap(scheduler.heap.begin(), scheduler.heap.end(), LaterTick{ &scheduler.subsystems });
+}
+
+unsigned int addSubsystem(SimScheduler& scheduler, const std::string& name, unsigned int rateHz,
+    std::function<void(float dt)> update) {
+    ScheduledSubsystem subsystem;
+    subsystem.name = name;
+    subsystem.profileName = internProfileName(name);
+    subsystem.allocSubsystem = registerAllocSubsystem(subsystem.profileName);
+    subsystem.rateHz = rateHz;
+    // pierwszy tick to pierwszy pelny okres po aktualnym czasie
+    subsystem.tickIndex = scheduler.timeNs * rateHz / NANOSECONDS_PER_SECOND + 1;
+    subsystem.nextTickNs = tickTime(subsystem, subsystem.tickIndex);
+    subsystem.update = std::move(update);
+    subsystem.ticks = 0;
+    subsystem.missedTicks = 0;
+
+    unsigned int index = (unsigned int)scheduler.subsystems.size();
+    scheduler.subsystems.push_back(std::move(subsystem));
+    scheduler.heap.push_back(index);
+    rebuildHeap(scheduler);
+    return index;
+}
+
+void resetScheduler(SimScheduler& scheduler, uint64_t timeNs) {
+    scheduler.timeNs = timeNs;
+    for (ScheduledSubsystem& subsystem : scheduler.subsystems) {
+        subsystem.tickIndex = timeNs * subsystem.rateHz / NANOSECONDS_PER_SECOND + 1;
+        subsystem.nextTickNs = tickTime(subsystem, subsystem.tickIndex);
+    }
+    rebuildHeap(scheduler);
+}
+
+void runSchedulerUntil(SimScheduler& scheduler, uint64_t targetNs) {
+    LaterTick later{ &scheduler.subsystems };
+    while (!scheduler.heap.empty()) {
+        unsigned int index = scheduler.heap.front();
+        ScheduledSubsystem& subsystem = scheduler.subsystems[index];
+        if (subsystem.nextTickNs > targetNs)
+            break;
+
+        std::pop_heap(scheduler.heap.begin(), scheduler.heap.end(), later);
+        scheduler.timeNs = subsystem.nextTickNs;
+        {
+            PROFILE_SCOPE(subsystem.profileName);
+            ALLOC_SUBSYSTEM_SCOPE(subsystem.allocSubsystem, true);
+            subsystem.update(1.0f / subsystem.rateHz);
+        }
+        subsystem.ticks++;
+        subsystem.tickIndex++;
+        subsystem.nextTickNs = tickTime(subsystem, subsystem.tickIndex);
+        std::push_heap(scheduler.heap.begin(), scheduler.heap.end(), later);
+    }
+    scheduler.timeNs = targetNs;
+}
+
+// timeScale ustawiany z zewnatrz (watek okna, powtorka) - przed rzutowaniem na uint64 zawsze w zakresie (tez NaN)
+static double clampedTimeScale(const SimScheduler& scheduler) {
+    if (!(scheduler.timeScale >= SCHEDULER_MIN_TIME_SCALE))
+        return SCHEDULER_MIN_TIME_SCALE;
+    return std::min(scheduler.timeScale, SCHEDULER_MAX_TIME_SCALE);
+}
+
+void advanceScheduler(SimScheduler& scheduler, double wallSeconds) {
+    if (scheduler.paused || !(wallSeconds > 0.0) || scheduler.timeScale <= 0.0)
+        return;
+
+    double timeScale = clampedTimeScale(scheduler);
+    wallSeconds = std::min(wallSeconds, SCHEDULER_MAX_WALL_STEP);
+    uint64_t targetNs = scheduler.timeNs + (uint64_t)(wallSeconds * timeScale * NANOSECONDS_PER_SECOND);
+
+    // nie nadazamy - zaleglosc liczona w czasie sciennym (czas symulacji / timeScale), wiec przyspieszenie samo
+    // w sobie nie porzuca tickow; ponad maxLagNs porzucamy reszte i liczymy pominiete ticki
+    double lagNs = (targetNs - scheduler.timeNs) / timeScale;
+    if (lagNs > (double)scheduler.maxLagNs) {
+        uint64_t resumeNs = targetNs - (uint64_t)(scheduler.maxLagNs * timeScale);
+        for (ScheduledSubsystem& subsystem : scheduler.subsystems) {
+            uint64_t resumeTick = resumeNs * subsystem.rateHz / NANOSECONDS_PER_SECOND + 1;
+            if (resumeTick > subsystem.tickIndex) {
+                subsystem.missedTicks += resumeTick - subsystem.tickIndex;
+                subsystem.tickIndex = resumeTick;
+                subsystem.nextTickNs = tickTime(subsystem, resumeTick);
+            }
+        }
+        scheduler.timeNs = resumeNs;
+        rebuildHeap(scheduler);
+    }
+
+    runSchedulerUntil(scheduler, targetNs);
+}
+
+double secondsUntilNextTick(const SimScheduler& scheduler) {
+    if (scheduler.paused || scheduler.heap.empty() || scheduler.timeScale <= 0.0)
+        return SCHEDULER_MAX_SLEEP;
+    const ScheduledSubsystem& next = scheduler.subsystems[scheduler.heap.front()];
+    uint64_t remainingNs = next.nextTickNs > scheduler.timeNs ? next.nextTickNs - scheduler.timeNs : 0;
+    double seconds = remainingNs / (clampedTimeScale(scheduler) * NANOSECONDS_PER_SECOND);
+    // przy bardzo malym timeScale nastepny tick moze byc za wiele minut - watek musi dalej widziec zatrzymanie
+    return seconds < SCHEDULER_MAX_SLEEP ? seconds : SCHEDULER_MAX_SLEEP;
+}
+
+void printSchedulerReport(const SimScheduler& scheduler) {
+    std::cout << "Scheduler: " << scheduler.timeNs / 1e9 << " s simulated" << std::endl;
+    for (const ScheduledSubsystem& subsystem : scheduler.subsystems) {
+        std::cout << "  " << subsystem.name << " @" << subsystem.rateHz << " Hz: "
+            << subsystem.ticks << " ticks, " << subsystem.missedTicks << " missed" << std::endl;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+const uint64_t NANOSECONDS_PER_SECOND = 1000000000ULL;
+// najdluzsza drzemka petli symulacji (pauza, bardzo wolny czas)
+const double SCHEDULER_MAX_SLEEP = 0.01;
+// maxLagNs bez limitu - zaden tick nie jest porzucany (nagrywanie i odtwarzanie powtorki)
+const uint64_t SCHEDULER_NO_LAG_LIMIT = UINT64_MAX;
+// zakres timeScale - wieksze przyspieszenie przepelnia czas w ns, a z zera polowieniem nie da sie wrocic
+const double SCHEDULER_MIN_TIME_SCALE = 1.0 / 1024.0;
+const double SCHEDULER_MAX_TIME_SCALE = 1024.0;
+// najdluzszy krok zegara sciennego naraz (debugger, uspienie) - reszta i tak bylaby porzucona przez maxLagNs
+const double SCHEDULER_MAX_WALL_STEP = 3600.0;
+
+struct ScheduledSubsystem {
+    std::string name;
+    const char* profileName;  // trwala kopia nazwy dla profilera
+    unsigned int allocSubsystem;  // licznik alokacji, tick nie moze alokowac w stanie ustalonym
+    unsigned int rateHz;
+    uint64_t tickIndex;   // ktory tick wykona sie nastepny
+    uint64_t nextTickNs;  // tickIndex * 1e9 / rateHz - liczone w calkowitych, bez dryfu
+    std::function<void(float dt)> update;
+    uint64_t ticks;
+    uint64_t missedTicks;
+};
+
+// podsystemy odpalane kazdy z wlasna czestotliwoscia; przy rownym czasie
+// decyduje kolejnosc rejestracji, wiec przebieg jest deterministyczny
+struct SimScheduler {
+    uint64_t timeNs = 0;
+    double timeScale = 1.0;
+    bool paused = false;
+    // wieksze opoznienie wzgledem zegara sciennego (ns czasu sciennego) jest porzucane (liczone jako missed)
+    uint64_t maxLagNs = 100 * 1000000ULL;
+    std::vector<ScheduledSubsystem> subsystems;
+    std::vector<unsigned int> heap;
+};
+
+unsigned int addSubsystem(SimScheduler& scheduler, const std::string& name, unsigned int rateHz,
+    std::function<void(float dt)> update);
+
+// ustawia czas i przelicza nastepne ticki wszystkich podsystemow (np. po wczytaniu klatki kluczowej)
+void resetScheduler(SimScheduler& scheduler, uint64_t timeNs);
+
+// tryb czasu rzeczywistego: przesuwa czas symulacji o wallSeconds * timeScale
+void advanceScheduler(SimScheduler& scheduler, double wallSeconds);
+// bez zegara sciennego - wykonuje wszystkie ticki az do targetNs (nic nie jest pomijane)
+void runSchedulerUntil(SimScheduler& scheduler, uint64_t targetNs);
+
+// ile sekund zegara sciennego do najblizszego ticku, najwyzej SCHEDULER_MAX_SLEEP
+double secondsUntilNextTick(const SimScheduler& scheduler);
+
+void printSchedulerReport(const SimScheduler& scheduler);
@@ -1,15 +1,33 @@
 #include "Shader.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <chrono>
 #include <iostream>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 
 Shader::Shader(const char* vertexSource, const char* fragmentSource) {
+    PROFILE_SCOPE("Shader::Shader");
+    // najpierw gotowa binarka z cache, kompilacja ze zrodel tylko przy braku/odrzuceniu
+    uint64_t cacheKey = shaderCacheKey(vertexSource, fragmentSource, "");
+    ID = loadCachedProgram(cacheKey);
+    if (ID) {
+        cacheUniforms();
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
     GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
     ID = glCreateProgram();
     glAttachShader(ID, vertexShader);
     glAttachShader(ID, fragmentShader);
-    glLinkProgram(ID);
+    prepareProgramForCache(ID);
+    {
+        PROFILE_SCOPE("glLinkProgram");
+        glLinkProgram(ID);
+    }
 
     int success;
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
@@ -17,10 +35,17 @@ Shader::Shader(const char* vertexSource, const char* fragmentSource) {
         char infoLog[512];
         glGetProgramInfoLog(ID, 512, nullptr, infoLog);
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    } else {
+        storeCachedProgram(ID, cacheKey, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
     }
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    cacheUniforms();
+}
+
+Shader::Shader(GLuint linkedProgram) : ID(linkedProgram) {
+    cacheUniforms();
 }
 
 Shader::~Shader() {
@@ -31,11 +56,39 @@ void Shader::use() const {
     glUseProgram(ID);
 }
 
+void Shader::cacheUniforms() {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(maxLength + 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+        uniforms.push_back({ std::string(name.data(), length), glGetUniformLocation(ID, name.data()) });
+    }
+}
+
+GLint Shader::uniformLocation(const char* name) const {
+    for (const Uniform& uniform : uniforms) {
+        if (std::strcmp(uniform.name.c_str(), name) == 0)
+            return uniform.location;
+    }
+    // nieaktywny (wyciety przez kompilator) albo spoza tablicy
+    return glGetUniformLocation(ID, name);
+}
+
+void Shader::setMat4(const char* name, const glm::mat4& mat) const {
+    glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    setMat4(name.c_str(), mat);
 }
 
 GLuint Shader::compileShader(GLenum type, const char* source) {
+    PROFILE_SCOPE("Shader::compileShader");
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, nullptr);
     glCompileShader(shader);
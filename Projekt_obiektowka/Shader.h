@@ -5,19 +5,34 @@
 #include <glad/glad.h>
 #include <string>
 #include <glm/glm.hpp>
+#include <vector>
 
 class Shader {
 public:
     GLuint ID;
 
     Shader(const char* vertexSource, const char* fragmentSource);
+    // przejmuje gotowy, zlinkowany program (np. z ShaderLibrary)
+    explicit Shader(GLuint linkedProgram);
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
     ~Shader();
 
     void use() const;
+    // lokalizacje z tablicy zbudowanej po linkowaniu - bez std::string i bez pytania sterownika co klatke
+    GLint uniformLocation(const char* name) const;
+    void setMat4(const char* name, const glm::mat4& mat) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
 private:
+    struct Uniform {
+        std::string name;
+        GLint location;
+    };
+    std::vector<Uniform> uniforms;
+
     GLuint compileShader(GLenum type, const char* source);
+    void cacheUniforms();
 };
 
 #endif
@@ -0,0 +1,169 @@
+#include "ShaderCache.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const uint32_t SHADER_CACHE_MAGIC = 0x43485344;  // "DSHC"
+const uint32_t SHADER_CACHE_VERSION = 1;
+
+struct ShaderCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+    double compileMs;
+};
+
+ShaderCacheStats shaderCacheStats;
+static std::string cacheDirectory;
+
+static void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+static bool binariesSupported() {
+    if (!glProgramBinary || !glGetProgramBinary || !glProgramParameteri)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+void setShaderCacheDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+    if (!directory.empty())
+        makeDirectory(directory);
+}
+
+bool shaderCacheEnabled() {
+    return !cacheDirectory.empty() && binariesSupported();
+}
+
+static void hashBytes(uint64_t& hash, const char* text) {
+    // FNV-1a, zero na koncu oddziela kolejne napisy
+    for (const char* c = text ? text : ""; ; ++c) {
+        hash = (hash ^ (unsigned char)*c) * 0x100000001B3ULL;
+        if (!*c)
+            break;
+    }
+}
+
+uint64_t shaderCacheKey(const char* vertexSource, const char* fragmentSource, const std::string& defines) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hashBytes(hash, vertexSource);
+    hashBytes(hash, fragmentSource);
+    hashBytes(hash, defines.c_str());
+    hashBytes(hash, (const char*)glGetString(GL_VENDOR));
+    hashBytes(hash, (const char*)glGetString(GL_RENDERER));
+    hashBytes(hash, (const char*)glGetString(GL_VERSION));
+    return hash;
+}
+
+static std::string cachePath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return cacheDirectory + "/" + name;
+}
+
+GLuint loadCachedProgram(uint64_t key) {
+    if (!shaderCacheEnabled())
+        return 0;
+    PROFILE_FUNCTION();
+    auto start = std::chrono::steady_clock::now();
+
+    std::string path = cachePath(key);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::streamoff fileSize = in ? (std::streamoff)in.tellg() : 0;
+    in.seekg(0);
+    ShaderCacheHeader header;
+    // dlugosc z naglowka najwyzej do konca pliku - uszkodzony wpis nie alokuje gigabajtow
+    if (!in || fileSize < (std::streamoff)sizeof(header) || !in.read((char*)&header, sizeof(header))
+        || header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION || header.key != key
+        || header.length == 0 || header.length > (uint64_t)(fileSize - (std::streamoff)sizeof(header))) {
+        shaderCacheStats.misses++;
+        return 0;
+    }
+    std::vector<char> binary(header.length);
+    if (!in.read(binary.data(), binary.size())) {
+        shaderCacheStats.misses++;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // nieaktualna binarka (np. aktualizacja sterownika bez zmiany napisu wersji) - kompilacja ze zrodel
+        glDeleteProgram(program);
+        in.close();
+        std::remove(path.c_str());
+        shaderCacheStats.misses++;
+        shaderCacheStats.rejected++;
+        return 0;
+    }
+
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    shaderCacheStats.hits++;
+    shaderCacheStats.loadMs += loadMs;
+    shaderCacheStats.savedMs += header.compileMs - loadMs;
+    return program;
+}
+
+void prepareProgramForCache(GLuint program) {
+    if (shaderCacheEnabled())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void storeCachedProgram(GLuint program, uint64_t key, double compileMs) {
+    shaderCacheStats.compileMs += compileMs;
+    if (!shaderCacheEnabled())
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    ShaderCacheHeader header = { SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, key, format, (uint32_t)length, compileMs };
+    // zapis do pliku tymczasowego i podmiana - przerwany zapis nie zostawia polowy wpisu pod wlasciwa nazwa
+    std::string path = cachePath(key);
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+    bool written = out.write((const char*)&header, sizeof(header)) && out.write(binary.data(), binary.size());
+    out.close();
+    // rename na Windows nie nadpisuje istniejacego pliku
+    std::remove(path.c_str());
+    if (!written || out.fail() || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "ERROR::SHADER_CACHE::CANNOT_WRITE " << path << std::endl;
+        std::remove(temporaryPath.c_str());
+    }
+}
+
+void printShaderCacheReport() {
+    unsigned int total = shaderCacheStats.hits + shaderCacheStats.misses;
+    if (total == 0)
+        return;
+    std::cout << "Shader cache: " << shaderCacheStats.hits << "/" << total << " hits ("
+        << 100.0 * shaderCacheStats.hits / total << "%), " << shaderCacheStats.rejected << " rejected, load "
+        << shaderCacheStats.loadMs << " ms, compile " << shaderCacheStats.compileMs << " ms, saved "
+        << shaderCacheStats.savedMs << " ms" << std::endl;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <cstdint>
+
+// binarki zlinkowanych programow (glGetProgramBinary) w katalogu cache, plik = klucz.bin;
+// klucz to hash zrodel, definicji i sterownika (vendor/renderer/version) - zmiana sterownika = nowy plik
+struct ShaderCacheStats {
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    unsigned int rejected = 0;  // binarka odrzucona przez sterownik, skompilowano od nowa
+    double loadMs = 0.0;
+    double compileMs = 0.0;
+    double savedMs = 0.0;  // zapisany czas kompilacji trafionych programow minus czas wczytania
+};
+
+extern ShaderCacheStats shaderCacheStats;
+
+// puste - cache wylaczony; katalog jest tworzony
+void setShaderCacheDirectory(const std::string& directory);
+bool shaderCacheEnabled();
+
+uint64_t shaderCacheKey(const char* vertexSource, const char* fragmentSource, const std::string& defines);
+// nowy program z binarki albo 0 (brak pliku, brak wsparcia, odrzucona binarka)
+GLuint loadCachedProgram(uint64_t key);
+// przed glLinkProgram - sterownik ma zachowac binarke
+void prepareProgramForCache(GLuint program);
+void storeCachedProgram(GLuint program, uint64_t key, double compileMs);
+
+void printShaderCacheReport();
@@ -0,0 +1,260 @@
+#include "ShaderLibrary.h"
+#include "ShaderCache.h"
+#include "Profiler.h"
+#include "AssetIO.h"
+#include <iostream>
+
+static const char* const FEATURE_DEFINES[SHADER_FEATURE_COUNT] = { "LIGHTING", "INSTANCING", "DEPTH_ONLY", "TEXTURED",
+    "VIRTUAL_TEXTURE", "FEEDBACK" };
+
+// przez openAsset - zrodla moga lezec w zamontowanej paczce
+static bool readTextFile(const std::string& path, std::string& text) {
+    AssetData asset;
+    if (!openAsset(path, asset)) {
+        std::cerr << "ERROR::SHADER_LIBRARY::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    text.assign((const char*)asset.data, asset.size);
+    closeAsset(asset);
+    return true;
+}
+
+bool loadShaderLibrary(ShaderLibrary& library, const std::string& directory) {
+    return readTextFile(directory + "/vertex.glsl", library.vertexSource)
+        && readTextFile(directory + "/fragment.glsl", library.fragmentSource);
+}
+
+static std::string featureDefines(uint32_t features) {
+    std::string defines;
+    for (unsigned int i = 0; i < SHADER_FEATURE_COUNT; ++i) {
+        if (features & (1u << i))
+            defines += std::string("#define ") + FEATURE_DEFINES[i] + " 1\n";
+    }
+    return defines;
+}
+
+// definicje musza byc za #version; #line przywraca numeracje linii pliku w bledach kompilacji
+static std::string withDefines(const std::string& source, const std::string& defines) {
+    size_t versionEnd = source.find('\n');
+    if (versionEnd == std::string::npos || defines.empty())
+        return source;
+    return source.substr(0, versionEnd + 1) + defines + "#line 2\n" + source.substr(versionEnd + 1);
+}
+
+static GLuint submitShader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// kompilacja + link bez sprawdzania statusu - przy KHR_parallel_shader_compile te wywolania nie czekaja
+static void submitVariant(ShaderVariant& variant) {
+    auto start = std::chrono::steady_clock::now();
+    variant.vertexShader = submitShader(GL_VERTEX_SHADER, variant.vertexSource);
+    variant.fragmentShader = submitShader(GL_FRAGMENT_SHADER, variant.fragmentSource);
+    variant.program = glCreateProgram();
+    glAttachShader(variant.program, variant.vertexShader);
+    glAttachShader(variant.program, variant.fragmentShader);
+    prepareProgramForCache(variant.program);
+    glLinkProgram(variant.program);
+    variant.compileMs += millisecondsSince(start);
+}
+
+static bool shaderCompiled(GLuint shader, const char* stage, uint32_t features) {
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cerr << "ERROR::SHADER_LIBRARY::" << stage << "::COMPILATION_FAILED features=" << features << "\n" << infoLog << std::endl;
+    }
+    return success != 0;
+}
+
+// tylko watek renderu: sprawdzenie statusu, zapis do cache, tablica uniformow
+static void finishVariant(ShaderVariant& variant) {
+    PROFILE_FUNCTION();
+    // bez watku kompilatora odczyt statusu czeka na koniec kompilacji - to tez jej czas
+    auto start = std::chrono::steady_clock::now();
+    bool compiled = shaderCompiled(variant.vertexShader, "VERTEX", variant.features);
+    compiled = shaderCompiled(variant.fragmentShader, "FRAGMENT", variant.features) && compiled;
+    GLint linked = 0;
+    glGetProgramiv(variant.program, GL_LINK_STATUS, &linked);
+    variant.compileMs += millisecondsSince(start);
+    if (compiled && !linked) {
+        char infoLog[512];
+        glGetProgramInfoLog(variant.program, 512, nullptr, infoLog);
+        std::cerr << "ERROR::SHADER_LIBRARY::PROGRAM::LINKING_FAILED features=" << variant.features << "\n" << infoLog << std::endl;
+    }
+
+    glDetachShader(variant.program, variant.vertexShader);
+    glDetachShader(variant.program, variant.fragmentShader);
+    glDeleteShader(variant.vertexShader);
+    glDeleteShader(variant.fragmentShader);
+    variant.vertexShader = variant.fragmentShader = 0;
+    if (!compiled || !linked) {
+        glDeleteProgram(variant.program);
+        variant.program = 0;
+        variant.state = VARIANT_FAILED;
+        return;
+    }
+
+    // przy KHR_parallel_shader_compile czas watkow sterownika jest niewidoczny - liczy sie tylko to, co czekalismy
+    storeCachedProgram(variant.program, variant.cacheKey, variant.compileMs);
+    variant.shader.reset(new Shader(variant.program));
+    variant.state = VARIANT_READY;
+}
+
+static void compileThreadLoop(ShaderLibrary& library) {
+    PROFILE_THREAD("shader compiler");
+    glfwMakeContextCurrent(library.compileContext);
+    while (true) {
+        ShaderVariant* variant;
+        {
+            std::unique_lock<std::mutex> lock(library.queueMutex);
+            library.queueReady.wait(lock, [&] { return !library.running || !library.queue.empty(); });
+            if (!library.running)
+                break;
+            variant = library.queue.front();
+            library.queue.pop_front();
+        }
+        {
+            PROFILE_SCOPE("compile variant");
+            submitVariant(*variant);
+            // obiekty sa wspoldzielone, ale kontekst renderu zobaczy je kompletne dopiero po glFinish
+            auto start = std::chrono::steady_clock::now();
+            glFinish();
+            variant->compileMs += millisecondsSince(start);
+        }
+        variant->state.store(VARIANT_COMPILED, std::memory_order_release);
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void startShaderCompiler(ShaderLibrary& library, GLFWwindow* window) {
+    if (GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile) {
+        // 0xFFFFFFFF - liczbe watkow wybiera sterownik
+        if (GLAD_GL_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        library.parallelCompile = true;
+        return;
+    }
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    library.compileContext = glfwCreateWindow(1, 1, "shader compiler", nullptr, window);
+    // wskazowki sa globalne - kolejne okna nie moga dziedziczyc ukrycia
+    glfwDefaultWindowHints();
+    if (!library.compileContext) {
+        std::cerr << "ERROR::SHADER_LIBRARY::NO_SHARED_CONTEXT - variants compile on the render thread" << std::endl;
+        return;
+    }
+    library.running = true;
+    library.compileThread = std::thread(compileThreadLoop, std::ref(library));
+}
+
+static ShaderVariant* findVariant(ShaderLibrary& library, uint32_t features) {
+    for (const std::unique_ptr<ShaderVariant>& variant : library.variants) {
+        if (variant->features == features)
+            return variant.get();
+    }
+    return nullptr;
+}
+
+static ShaderVariant& createVariant(ShaderLibrary& library, uint32_t features) {
+    PROFILE_FUNCTION();
+    library.variants.emplace_back(new ShaderVariant());
+    ShaderVariant& variant = *library.variants.back();
+    std::string defines = featureDefines(features);
+    variant.features = features;
+    variant.vertexSource = withDefines(library.vertexSource, defines);
+    variant.fragmentSource = withDefines(library.fragmentSource, defines);
+    variant.cacheKey = shaderCacheKey(variant.vertexSource.c_str(), variant.fragmentSource.c_str(), defines);
+
+    // binarka z cache - gotowe od razu
+    if (GLuint program = loadCachedProgram(variant.cacheKey)) {
+        variant.program = program;
+        variant.shader.reset(new Shader(program));
+        variant.state = VARIANT_READY;
+        return variant;
+    }
+
+    if (library.parallelCompile) {
+        submitVariant(variant);
+    } else if (library.running) {
+        std::lock_guard<std::mutex> lock(library.queueMutex);
+        library.queue.push_back(&variant);
+        library.queueReady.notify_one();
+    } else {
+        submitVariant(variant);
+        finishVariant(variant);
+    }
+    return variant;
+}
+
+const Shader* requestShaderVariant(ShaderLibrary& library, uint32_t features) {
+    ShaderVariant* variant = findVariant(library, features);
+    if (!variant)
+        variant = &createVariant(library, features);
+    return variant->state.load(std::memory_order_acquire) == VARIANT_READY ? variant->shader.get() : nullptr;
+}
+
+const Shader* waitShaderVariant(ShaderLibrary& library, uint32_t features) {
+    requestShaderVariant(library, features);
+    ShaderVariant& variant = *findVariant(library, features);
+    while (variant.state.load(std::memory_order_acquire) == VARIANT_COMPILING) {
+        // przy KHR odczyt statusu linkowania po prostu poczeka na sterownik
+        if (library.parallelCompile)
+            finishVariant(variant);
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (variant.state.load(std::memory_order_acquire) == VARIANT_COMPILED)
+        finishVariant(variant);
+    return variant.shader.get();
+}
+
+void updateShaderLibrary(ShaderLibrary& library) {
+    for (const std::unique_ptr<ShaderVariant>& variant : library.variants) {
+        int state = variant->state.load(std::memory_order_acquire);
+        if (state == VARIANT_COMPILED) {
+            finishVariant(*variant);
+        } else if (state == VARIANT_COMPILING && library.parallelCompile) {
+            GLint done = GL_FALSE;
+            glGetProgramiv(variant->program, GL_COMPLETION_STATUS_KHR, &done);
+            if (done)
+                finishVariant(*variant);
+        }
+    }
+}
+
+void shutdownShaderLibrary(ShaderLibrary& library) {
+    if (library.running) {
+        {
+            std::lock_guard<std::mutex> lock(library.queueMutex);
+            library.running = false;
+        }
+        library.queueReady.notify_all();
+        library.compileThread.join();
+    }
+    if (library.compileContext)
+        glfwDestroyWindow(library.compileContext);
+    library.compileContext = nullptr;
+
+    for (const std::unique_ptr<ShaderVariant>& variant : library.variants) {
+        int state = variant->state.load();
+        if (state == VARIANT_COMPILING || state == VARIANT_COMPILED) {
+            glDeleteShader(variant->vertexShader);
+            glDeleteShader(variant->fragmentShader);
+            glDeleteProgram(variant->program);
+        }
+    }
+    library.variants.clear();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Shader.h"
+
+// cechy wariantu = bity, kazdy bit to jeden #define w shaders/vertex.glsl i fragment.glsl
+enum ShaderFeature : uint32_t {
+    SHADER_LIGHTING = 1 << 0,
+    SHADER_INSTANCING = 1 << 1,
+    SHADER_DEPTH_ONLY = 1 << 2,
+    SHADER_TEXTURED = 1 << 3,  // UV w atrybucie 2 (LAYOUT_TEXTURED), tekstura na jednostce 0
+    SHADER_VIRTUAL_TEXTURE = 1 << 4,  // UV jak wyzej, kolor z atlasu kafli przez indirekcje (VirtualTexture.h)
+    SHADER_VT_FEEDBACK = 1 << 5,      // zamiast koloru strona i poziom piramidy (RGBA16UI), razem z VIRTUAL_TEXTURE
+};
+const unsigned int SHADER_FEATURE_COUNT = 6;
+
+enum ShaderVariantState {
+    VARIANT_COMPILING,
+    VARIANT_COMPILED,  // watek kompilatora skonczyl, watek renderu jeszcze nie odebral
+    VARIANT_READY,
+    VARIANT_FAILED
+};
+
+struct ShaderVariant {
+    uint32_t features = 0;
+    std::string vertexSource, fragmentSource;
+    uint64_t cacheKey = 0;
+    std::atomic<int> state{ VARIANT_COMPILING };
+    GLuint program = 0, vertexShader = 0, fragmentShader = 0;
+    double compileMs = 0.0;  // sama kompilacja i linkowanie - bez czekania w kolejce i na odbior przez watek renderu
+    std::unique_ptr<Shader> shader;
+};
+
+// kompilacja w tle: GL_KHR_parallel_shader_compile (sterownik kompiluje sam, pytamy o GL_COMPLETION_STATUS_KHR),
+// inaczej watek z ukrytym oknem o wspoldzielonym kontekscie; bez obu - kompilacja od razu (przycina klatke)
+struct ShaderLibrary {
+    std::string vertexSource, fragmentSource;
+    std::vector<std::unique_ptr<ShaderVariant>> variants;
+    bool parallelCompile = false;
+
+    GLFWwindow* compileContext = nullptr;
+    std::thread compileThread;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<ShaderVariant*> queue;
+    bool running = false;
+};
+
+// shaders/vertex.glsl + fragment.glsl z katalogu directory
+bool loadShaderLibrary(ShaderLibrary& library, const std::string& directory);
+// window - okno z biezacym kontekstem (do wspoldzielenia przez watek kompilatora)
+void startShaderCompiler(ShaderLibrary& library, GLFWwindow* window);
+
+// gotowy wariant albo nullptr - pierwsze wywolanie zleca kompilacje i nigdy nie czeka
+const Shader* requestShaderVariant(ShaderLibrary& library, uint32_t features);
+// blokujaco, do uzycia przy starcie
+const Shader* waitShaderVariant(ShaderLibrary& library, uint32_t features);
+// raz na klatke: odbiera skonczone kompilacje
+void updateShaderLibrary(ShaderLibrary& library);
+// przed zniszczeniem kontekstu
+void shutdownShaderLibrary(ShaderLibrary& library);
@@ -0,0 +1,200 @@
+#include "Simulation.h"
+#include "JobSystem.h"
+#include "Telemetry.h"
+#include "Replay.h"
+#include "Profiler.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <thread>
+#include <cmath>
+
+const float DRONE_SPACING = 3.0f;
+const float DRONE_MASS = 1.0f;
+const float DRONE_INERTIA = 1.0f;
+const float DRAG = 0.3f;
+const glm::vec3 GRAVITY(0.0f, -9.81f, 0.0f);
+
+const float POSITION_KP = 4.0f;
+const float POSITION_KD = 3.0f;
+const float ATTITUDE_KP = 60.0f;
+const float ATTITUDE_KD = 12.0f;
+const float YAW_KP = 2.0f;
+
+const float HOVER_AMPLITUDE = 0.1f;
+const float YAW_RATE = 0.3f;
+const float IMU_ACCEL_NOISE = 0.05f;
+const float IMU_GYRO_NOISE = 0.01f;
+const float GPS_NOISE = 0.5f;
+const size_t DRONES_PER_JOB = 256;
+
+// szum zalezny tylko od (seed, krok, dron, kanal) - powtarzalny niezaleznie od watkow
+static float noise(uint64_t seed, uint64_t step, size_t drone, unsigned int channel) {
+    uint64_t x = seed ^ (step * 0x9E3779B97F4A7C15ULL) ^ (drone * 0xC2B2AE3D27D4EB4FULL) ^ ((uint64_t)channel << 56);
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return (float)(x >> 40) / (float)(1ULL << 23) - 1.0f;
+}
+
+static glm::vec3 noise3(uint64_t seed, uint64_t step, size_t drone, unsigned int channel) {
+    return glm::vec3(noise(seed, step, drone, channel), noise(seed, step, drone, channel + 1), noise(seed, step, drone, channel + 2));
+}
+
+void initSimulation(SimState& state, unsigned int droneCount) {
+    state.step = 0;
+    state.time = 0.0;
+    state.drones.resize(droneCount);
+
+    unsigned int side = (unsigned int)std::ceil(std::sqrt((float)droneCount));
+    for (unsigned int i = 0; i < droneCount; ++i) {
+        DroneState& drone = state.drones[i];
+        drone.home = glm::vec3((float)(i % side), 0.0f, (float)(i / side)) * DRONE_SPACING;
+        drone.position = drone.home;
+        drone.velocity = glm::vec3(0.0f);
+        drone.orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        drone.angularVelocity = glm::vec3(0.0f);
+        drone.thrust = -GRAVITY.y * DRONE_MASS;
+        drone.torque = glm::vec3(0.0f);
+        drone.imuAccel = glm::vec3(0.0f);
+        drone.imuGyro = glm::vec3(0.0f);
+        drone.gpsPosition = drone.position;
+    }
+}
+
+void applyDroneCommand(SimState& state, const DroneCommand& command) {
+    for (size_t i = 0; i < state.drones.size(); ++i) {
+        if (command.drone == ALL_DRONES || command.drone == i)
+            state.drones[i].home += command.offset;
+    }
+}
+
+void pushDroneCommand(SimControl& control, const DroneCommand& command) {
+    std::lock_guard<std::mutex> lock(control.commandsMutex);
+    control.commands.push_back(command);
+    control.hasCommands = true;
+}
+
+void stepSimulation(SimState& state, float dt) {
+    parallelFor(0, state.drones.size(), [&](size_t i) {
+        DroneState& drone = state.drones[i];
+        glm::vec3 up = drone.orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 accel = up * (drone.thrust / DRONE_MASS) + GRAVITY - DRAG * drone.velocity;
+        drone.velocity += accel * dt;
+        drone.position += drone.velocity * dt;
+
+        drone.angularVelocity += drone.torque * (dt / DRONE_INERTIA);
+        glm::quat spin(0.0f, drone.angularVelocity.x, drone.angularVelocity.y, drone.angularVelocity.z);
+        drone.orientation = glm::normalize(drone.orientation + 0.5f * dt * spin * drone.orientation);
+    }, DRONES_PER_JOB);
+    state.step++;
+    state.time = state.step * (double)dt;
+}
+
+void updateAttitudeControl(SimState& state, float) {
+    float bob = HOVER_AMPLITUDE * std::sin((float)state.time);
+    parallelFor(0, state.drones.size(), [&](size_t i) {
+        DroneState& drone = state.drones[i];
+        glm::vec3 target = drone.home + glm::vec3(0.0f, bob, 0.0f);
+        glm::vec3 desired = POSITION_KP * (target - drone.position) - POSITION_KD * drone.velocity - GRAVITY;
+
+        glm::vec3 up = drone.orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+        drone.thrust = glm::max(glm::dot(desired, up) * DRONE_MASS, 0.0f);
+
+        // przechyl w strone zadanego przyspieszenia, stale obroty wokol osi pionowej
+        glm::vec3 tiltError = glm::cross(up, glm::normalize(desired));
+        float yawRate = glm::dot(drone.angularVelocity, up);
+        glm::vec3 tiltRate = drone.angularVelocity - up * yawRate;
+        drone.torque = ATTITUDE_KP * tiltError - ATTITUDE_KD * tiltRate + up * (YAW_KP * (YAW_RATE - yawRate));
+    }, DRONES_PER_JOB);
+}
+
+void sampleImu(SimState& state) {
+    parallelFor(0, state.drones.size(), [&](size_t i) {
+        DroneState& drone = state.drones[i];
+        glm::quat toBody = glm::conjugate(drone.orientation);
+        glm::vec3 drag = -DRAG * drone.velocity / DRONE_MASS;
+        drone.imuAccel = glm::vec3(0.0f, drone.thrust / DRONE_MASS, 0.0f) + toBody * drag
+            + IMU_ACCEL_NOISE * noise3(state.seed, state.step, i, 0);
+        drone.imuGyro = toBody * drone.angularVelocity + IMU_GYRO_NOISE * noise3(state.seed, state.step, i, 3);
+    }, DRONES_PER_JOB);
+}
+
+void sampleGps(SimState& state) {
+    for (size_t i = 0; i < state.drones.size(); ++i) {
+        DroneState& drone = state.drones[i];
+        drone.gpsPosition = drone.position + GPS_NOISE * noise3(state.seed, state.step, i, 6);
+    }
+}
+
+void registerSimulationSubsystems(SimScheduler& scheduler, SimState& state) {
+    // kolejnosc rejestracji = kolejnosc przy tym samym czasie
+    addSubsystem(scheduler, "physics", PHYSICS_RATE, [&state](float dt) { stepSimulation(state, dt); });
+    addSubsystem(scheduler, "attitude", ATTITUDE_RATE, [&state](float dt) { updateAttitudeControl(state, dt); });
+    addSubsystem(scheduler, "imu", IMU_RATE, [&state](float) { sampleImu(state); });
+    addSubsystem(scheduler, "gps", GPS_RATE, [&state](float) { sampleGps(state); });
+}
+
+void buildSnapshot(const SimState& state, RenderSnapshot& snapshot) {
+    snapshot.step = state.step;
+    snapshot.time = state.time;
+    snapshot.droneTransforms.resize(state.drones.size());
+    for (size_t i = 0; i < state.drones.size(); ++i) {
+        const DroneState& drone = state.drones[i];
+        snapshot.droneTransforms[i] = glm::translate(glm::mat4(1.0f), drone.position) * glm::mat4_cast(drone.orientation);
+    }
+}
+
+static void runRealTimeLoop(SimScheduler& scheduler, SimControl& control) {
+    using clock = std::chrono::steady_clock;
+    auto last = clock::now();
+    while (control.running.load(std::memory_order_relaxed)) {
+        auto now = clock::now();
+        double wallSeconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        scheduler.paused = control.paused.load(std::memory_order_relaxed);
+        scheduler.timeScale = control.timeScale.load(std::memory_order_relaxed);
+        advanceScheduler(scheduler, wallSeconds);
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(secondsUntilNextTick(scheduler)));
+    }
+    printSchedulerReport(scheduler);
+}
+
+void runSimulationThread(SimState& state, TripleBuffer<RenderSnapshot>& snapshots, SimControl& control,
+    TelemetryRecorder* recorder, ReplayRecorder* replay) {
+    PROFILE_THREAD("simulation");
+    SimScheduler scheduler;
+
+    // komendy wchodza przed fizyka, zapisane do powtorki z numerem kroku
+    std::vector<DroneCommand> commands;
+    addSubsystem(scheduler, "commands", PHYSICS_RATE, [&](float) {
+        if (!control.hasCommands.load(std::memory_order_acquire))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(control.commandsMutex);
+            commands.swap(control.commands);
+            control.hasCommands = false;
+        }
+        for (const DroneCommand& command : commands)
+            applyDroneCommand(state, command);
+        if (replay)
+            recordReplayInputs(*replay, state.step, commands);
+        commands.clear();
+    });
+
+    registerSimulationSubsystems(scheduler, state);
+    if (recorder)
+        addSubsystem(scheduler, "telemetry", PHYSICS_RATE, [&](float) { recordDroneTelemetry(*recorder, state); });
+    if (replay)
+        addSubsystem(scheduler, "keyframes", PHYSICS_RATE, [&](float) { recordReplayKeyframe(*replay, state, scheduler.timeNs); });
+    addSubsystem(scheduler, "publish", PUBLISH_RATE, [&](float) {
+        buildSnapshot(state, snapshots.writeBuffer());
+        snapshots.publish();
+    });
+
+    // powtorka odtwarza ticki jeden w jeden - przy nagrywaniu nic nie jest porzucane, najwyzej symulacja zwolni
+    if (replay)
+        scheduler.maxLagNs = SCHEDULER_NO_LAG_LIMIT;
+    runRealTimeLoop(scheduler, control);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+#include "TripleBuffer.h"
+#include "Scheduler.h"
+
+struct DroneState {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::quat orientation;
+    glm::vec3 angularVelocity;
+    glm::vec3 home;
+
+    // wyjscie regulatora (500 Hz), wejscie fizyki (1 kHz)
+    float thrust;
+    glm::vec3 torque;
+
+    // ostatnie probki czujnikow
+    glm::vec3 imuAccel;
+    glm::vec3 imuGyro;
+    glm::vec3 gpsPosition;
+};
+
+struct SimState {
+    uint64_t step = 0;
+    double time = 0.0;
+    uint64_t seed = 1;
+    std::vector<DroneState> drones;
+};
+
+// wejscie z zewnatrz: nowy punkt docelowy drona (drone == ALL_DRONES - wszystkie)
+struct DroneCommand {
+    uint32_t drone;
+    glm::vec3 offset;
+};
+
+const uint32_t ALL_DRONES = 0xFFFFFFFF;
+
+// to co render potrzebuje z jednego kroku symulacji
+struct RenderSnapshot {
+    uint64_t step = 0;
+    double time = 0.0;
+    std::vector<glm::mat4> droneTransforms;
+};
+
+// sterowanie z watku renderu (klawiatura)
+struct SimControl {
+    std::atomic<bool> running{ true };
+    std::atomic<bool> paused{ false };
+    std::atomic<float> timeScale{ 1.0f };
+    // przewijanie powtorki o tyle sekund (0 - brak zadania)
+    std::atomic<float> seekSeconds{ 0.0f };
+
+    std::mutex commandsMutex;
+    std::vector<DroneCommand> commands;
+    std::atomic<bool> hasCommands{ false };
+};
+
+const float SIM_TIMESTEP = 0.001f;
+const unsigned int PHYSICS_RATE = 1000;
+const unsigned int ATTITUDE_RATE = 500;
+const unsigned int IMU_RATE = 400;
+const unsigned int GPS_RATE = 10;
+const unsigned int PUBLISH_RATE = 60;
+
+void initSimulation(SimState& state, unsigned int droneCount);
+void applyDroneCommand(SimState& state, const DroneCommand& command);
+void pushDroneCommand(SimControl& control, const DroneCommand& command);
+
+// etapy symulacji, kazdy odpalany przez scheduler z wlasna czestotliwoscia
+void stepSimulation(SimState& state, float dt);
+void updateAttitudeControl(SimState& state, float dt);
+void sampleImu(SimState& state);
+void sampleGps(SimState& state);
+
+void registerSimulationSubsystems(SimScheduler& scheduler, SimState& state);
+void buildSnapshot(const SimState& state, RenderSnapshot& snapshot);
+
+struct TelemetryRecorder;
+struct ReplayRecorder;
+
+// petla watku symulacji - scheduler napedzany zegarem sciennym, publikacja przez bufor potrojny;
+// recorder (opcjonalny) dostaje stan kazdego drona po kazdym kroku fizyki,
+// replay (opcjonalny) zapisuje klatki kluczowe i wszystkie komendy
+void runSimulationThread(SimState& state, TripleBuffer<RenderSnapshot>& snapshots, SimControl& control,
+    TelemetryRecorder* recorder = nullptr, ReplayRecorder* replay = nullptr);
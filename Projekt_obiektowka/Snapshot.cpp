@@ -0,0 +1,78 @@
+#include "Snapshot.h"
+#include "Scheduler.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <cstring>
+
+const size_t SNAPSHOT_ALIGNMENT = 64;
+
+size_t snapshotSize(size_t droneCount) {
+    return sizeof(SimSnapshotHeader) + droneCount * sizeof(DroneState);
+}
+
+void storeSnapshot(const SimState& state, unsigned char* destination) {
+    SimSnapshotHeader header = { state.step, state.time, state.seed, state.drones.size() };
+    std::memcpy(destination, &header, sizeof(header));
+    std::memcpy(destination + sizeof(header), state.drones.data(), state.drones.size() * sizeof(DroneState));
+}
+
+void loadSnapshot(const unsigned char* source, SimState& state) {
+    SimSnapshotHeader header;
+    std::memcpy(&header, source, sizeof(header));
+    state.step = header.step;
+    state.time = header.time;
+    state.seed = header.seed;
+    state.drones.resize((size_t)header.droneCount);
+    std::memcpy(state.drones.data(), source + sizeof(header), (size_t)header.droneCount * sizeof(DroneState));
+}
+
+void initSnapshotArena(SnapshotArena& arena, size_t droneCount, size_t capacity) {
+    arena.droneCount = droneCount;
+    arena.slotSize = (snapshotSize(droneCount) + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    arena.used = 0;
+    arena.memory.resize(arena.slotSize * capacity);
+}
+
+unsigned char* snapshotSlot(SnapshotArena& arena, size_t slot) {
+    return arena.memory.data() + slot * arena.slotSize;
+}
+
+const unsigned char* snapshotSlot(const SnapshotArena& arena, size_t slot) {
+    return arena.memory.data() + slot * arena.slotSize;
+}
+
+size_t takeSnapshot(SnapshotArena& arena, const SimState& state) {
+    size_t slot = arena.used++;
+    if (arena.memory.size() < arena.used * arena.slotSize)
+        arena.memory.resize(arena.memory.size() * 2 + arena.slotSize);
+    storeSnapshot(state, snapshotSlot(arena, slot));
+    return slot;
+}
+
+void restoreSnapshot(const SnapshotArena& arena, size_t slot, SimState& state) {
+    loadSnapshot(snapshotSlot(arena, slot), state);
+}
+
+void runRollouts(const SnapshotArena& arena, size_t baseSlot, size_t rolloutCount, double seconds,
+    const std::function<void(SimState& state, size_t rollout)>& setup, SnapshotArena& results) {
+    if (results.slotSize != arena.slotSize || results.memory.size() < rolloutCount * results.slotSize)
+        initSnapshotArena(results, arena.droneCount, rolloutCount);
+    results.used = rolloutCount;
+
+    // kazde rozgalezienie ma wlasny stan i scheduler - nic wspolnego poza arena tylko do odczytu
+    parallelFor(0, rolloutCount, [&](size_t rollout) {
+        PROFILE_SCOPE("rollout");
+        SimState state;
+        restoreSnapshot(arena, baseSlot, state);
+        if (setup)
+            setup(state, rollout);
+
+        SimScheduler scheduler;
+        registerSimulationSubsystems(scheduler, state);
+        uint64_t startNs = state.step * NANOSECONDS_PER_SECOND / PHYSICS_RATE;
+        resetScheduler(scheduler, startNs);
+        runSchedulerUntil(scheduler, startNs + (uint64_t)(seconds * NANOSECONDS_PER_SECOND));
+
+        storeSnapshot(state, snapshotSlot(results, rollout));
+    });
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "Simulation.h"
+
+// caly stan symulacji jako jeden ciagly blok: naglowek + tablica DroneState (same POD),
+// wiec zapis i odtworzenie to pojedynczy memcpy
+struct SimSnapshotHeader {
+    uint64_t step;
+    double time;
+    uint64_t seed;
+    uint64_t droneCount;
+};
+
+size_t snapshotSize(size_t droneCount);
+void storeSnapshot(const SimState& state, unsigned char* destination);
+// bez alokacji, jesli state.drones ma juz odpowiednia pojemnosc
+void loadSnapshot(const unsigned char* source, SimState& state);
+
+// wiele snapshotow o tej samej liczbie dronow w jednym buforze, slot co 64 B
+struct SnapshotArena {
+    size_t droneCount = 0;
+    size_t slotSize = 0;
+    size_t used = 0;
+    std::vector<unsigned char> memory;
+};
+
+void initSnapshotArena(SnapshotArena& arena, size_t droneCount, size_t capacity);
+unsigned char* snapshotSlot(SnapshotArena& arena, size_t slot);
+const unsigned char* snapshotSlot(const SnapshotArena& arena, size_t slot);
+// dopisuje snapshot na koncu areny i zwraca numer slotu
+size_t takeSnapshot(SnapshotArena& arena, const SimState& state);
+void restoreSnapshot(const SnapshotArena& arena, size_t slot, SimState& state);
+
+// rozgalezienie snapshotu baseSlot na rolloutCount niezaleznych przebiegow po seconds sekund,
+// rownolegle na puli watkow; setup zmienia stan przed startem (komenda, seed...),
+// stan koncowy rozgalezienia i trafia do slotu i w results
+void runRollouts(const SnapshotArena& arena, size_t baseSlot, size_t rolloutCount, double seconds,
+    const std::function<void(SimState& state, size_t rollout)>& setup, SnapshotArena& results);
@@ -0,0 +1,248 @@
+#include "StaticBatch.h"
+#include "Culling.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MeshRegistry.h"
+#include "Profiler.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+
+// jedno wystapienie siatki w statycznej czesci grafu
+struct StaticInstance {
+    uint32_t mesh;
+    uint32_t node;
+    glm::vec3 center;  // srodek siatki w ukladzie korzenia - klucz podzialu
+};
+
+struct MeshBounds {
+    glm::vec3 center;
+    float radius;
+};
+
+static MeshBounds meshBounds(const std::vector<glm::vec3>& positions) {
+    if (positions.empty())
+        return { glm::vec3(0.0f), 0.0f };
+    glm::vec3 low = positions[0], high = positions[0];
+    for (const glm::vec3& p : positions) {
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+    }
+    MeshBounds bounds = { 0.5f * (low + high), 0.0f };
+    for (const glm::vec3& p : positions)
+        bounds.radius = std::max(bounds.radius, glm::length(p - bounds.center));
+    return bounds;
+}
+
+// siatka wyslana do GL bez kopii CPU (loadModel z retainCpuData == false) nie da sie wypiec
+static bool hasCpuData(const Mesh& mesh) {
+    return mesh.indexCount == 0 || !mesh.indices.empty();
+}
+
+// statyczni = !dynamic i statyczny rodzic; baked = statyczny i wszystkie siatki maja dane CPU;
+// keep = niewypieczony albo ma niewypieczonego potomka
+static void classifyNodes(const SceneGraph& graph, std::vector<char>& baked, std::vector<char>& keep) {
+    size_t count = graph.nodes.size();
+    std::vector<char> isStatic(count, 0);
+    baked.assign(count, 0);
+    keep.assign(count, 0);
+    isStatic[0] = !graph.nodes[0].dynamic;
+    for (size_t i = 0; i < count; ++i) {
+        const Node& node = graph.nodes[i];
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+            isStatic[c] = isStatic[i] && !graph.nodes[c].dynamic;
+        baked[i] = isStatic[i];
+        for (uint32_t m = node.firstMesh; m < node.firstMesh + node.meshCount && baked[i]; ++m)
+            baked[i] = hasCpuData(meshes[graph.meshIndices[m]]);
+    }
+    // rodzic zawsze przed dziecmi - od konca dzieci sa juz policzone
+    for (size_t i = count; i-- > 0;) {
+        const Node& node = graph.nodes[i];
+        keep[i] = !baked[i];
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount && !keep[i]; ++c)
+            keep[i] = keep[c];
+    }
+    keep[0] = 1;
+}
+
+// graf z samymi zachowanymi wezlami, znowu wszerz (dzieci kazdego wezla obok siebie)
+static void buildResidualGraph(const SceneGraph& graph, const std::vector<char>& baked,
+    const std::vector<char>& keep, SceneGraph& residual) {
+    std::vector<uint32_t> order(1, 0);  // stare indeksy w nowej kolejnosci
+    residual.nodes.clear();
+    residual.meshIndices.clear();
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Node& source = graph.nodes[order[i]];
+        Node node = source;
+        node.firstMesh = (uint32_t)residual.meshIndices.size();
+        node.meshCount = baked[order[i]] ? 0 : source.meshCount;
+        residual.meshIndices.insert(residual.meshIndices.end(), graph.meshIndices.begin() + source.firstMesh,
+            graph.meshIndices.begin() + source.firstMesh + node.meshCount);
+        node.firstChild = (uint32_t)order.size();
+        for (uint32_t c = source.firstChild; c < source.firstChild + source.childCount; ++c) {
+            if (keep[c])
+                order.push_back(c);
+        }
+        node.childCount = (uint32_t)order.size() - node.firstChild;
+        residual.nodes.push_back(node);
+    }
+}
+
+// podzial wzdluz najdluzszej osi srodkow (mediana), az grupa zmiesci sie w maxTriangles; kazdy zakres
+// z pending dzielony osobno (jedna tekstura na zakres)
+static void splitInstances(std::vector<StaticInstance>& instances, const std::vector<size_t>& triangles,
+    uint32_t maxTriangles, std::vector<std::pair<size_t, size_t>> pending, std::vector<std::pair<size_t, size_t>>& groups) {
+    while (!pending.empty()) {
+        std::pair<size_t, size_t> range = pending.back();
+        pending.pop_back();
+        size_t total = 0;
+        glm::vec3 low(instances[range.first].center), high(low);
+        for (size_t i = range.first; i < range.second; ++i) {
+            total += triangles[instances[i].mesh];
+            low = glm::min(low, instances[i].center);
+            high = glm::max(high, instances[i].center);
+        }
+        if (total <= maxTriangles || range.second - range.first == 1) {
+            groups.push_back(range);
+            continue;
+        }
+        glm::vec3 extent = high - low;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        size_t middle = range.first + (range.second - range.first) / 2;
+        std::nth_element(instances.begin() + range.first, instances.begin() + middle, instances.begin() + range.second,
+            [axis](const StaticInstance& a, const StaticInstance& b) { return a.center[axis] < b.center[axis]; });
+        pending.push_back(std::make_pair(middle, range.second));
+        pending.push_back(std::make_pair(range.first, middle));
+    }
+}
+
+// pozycje i normalne przeliczone do ukladu korzenia, indeksy przesuniete o poczatek kazdej siatki;
+// UV bez zmian - wystarczy, ze choc jedna siatka je ma, reszta dostaje zera
+static void bakeBatch(const StaticInstance* instances, size_t count, const std::vector<glm::mat4>& world, Mesh& batch) {
+    size_t vertexCount = 0, indexCount = 0;
+    bool textured = false;
+    for (size_t i = 0; i < count; ++i) {
+        vertexCount += meshes[instances[i].mesh].positions.size();
+        indexCount += meshes[instances[i].mesh].indices.size();
+        textured = textured || !meshes[instances[i].mesh].texcoords.empty();
+    }
+    batch.texture = meshes[instances[0].mesh].texture;
+    batch.positions.reserve(vertexCount);
+    batch.normals.reserve(vertexCount);
+    batch.indices.reserve(indexCount);
+    if (textured)
+        batch.texcoords.reserve(vertexCount);
+    for (size_t i = 0; i < count; ++i) {
+        const Mesh& mesh = meshes[instances[i].mesh];
+        const glm::mat4& transform = world[instances[i].node];
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+        unsigned int base = (unsigned int)batch.positions.size();
+        for (size_t v = 0; v < mesh.positions.size(); ++v) {
+            batch.positions.push_back(glm::vec3(transform * glm::vec4(mesh.positions[v], 1.0f)));
+            // siatka bez normalnych - zera, zeby strumienie mialy ta sama dlugosc
+            glm::vec3 normal = v < mesh.normals.size() ? normalMatrix * mesh.normals[v] : glm::vec3(0.0f);
+            batch.normals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : normal);
+            if (textured)
+                batch.texcoords.push_back(v < mesh.texcoords.size() ? mesh.texcoords[v] : glm::vec2(0.0f));
+        }
+        for (unsigned int index : mesh.indices)
+            batch.indices.push_back(base + index);
+    }
+}
+
+void buildStaticBatches(SceneGraph& graph, StaticBatches& batches, const StaticBatchConfig& config) {
+    PROFILE_FUNCTION();
+    batches.meshes.clear();
+    batches.bounds.clear();
+    batches.sourceDraws = 0;
+    if (graph.nodes.empty())
+        return;
+
+    std::vector<char> baked, keep;
+    classifyNodes(graph, baked, keep);
+
+    // macierze wzgledem korzenia (drawNode dokleja z przodu parentTransform)
+    std::vector<glm::mat4> world(graph.nodes.size());
+    world[0] = graph.nodes[0].transform;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        const Node& node = graph.nodes[i];
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+            world[c] = world[i] * graph.nodes[c].transform;
+    }
+
+    std::vector<MeshBounds> localBounds(meshes.size());
+    std::vector<size_t> triangles(meshes.size());
+    parallelFor(0, meshes.size(), [&](size_t m) {
+        localBounds[m] = meshBounds(meshes[m].positions);
+        triangles[m] = meshes[m].indices.size() / 3;
+    });
+
+    std::vector<StaticInstance> instances;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        if (!baked[i])
+            continue;
+        const Node& node = graph.nodes[i];
+        for (uint32_t m = node.firstMesh; m < node.firstMesh + node.meshCount; ++m) {
+            uint32_t mesh = graph.meshIndices[m];
+            instances.push_back({ mesh, (uint32_t)i, glm::vec3(world[i] * glm::vec4(localBounds[mesh].center, 1.0f)) });
+        }
+    }
+    batches.sourceDraws = instances.size();
+
+    if (!instances.empty()) {
+        // paczka rysowana z jedna tekstura - najpierw zakresy po teksturze, potem podzial przestrzenny w kazdym
+        std::stable_sort(instances.begin(), instances.end(), [](const StaticInstance& a, const StaticInstance& b) {
+            return meshes[a.mesh].texture < meshes[b.mesh].texture;
+        });
+        std::vector<std::pair<size_t, size_t>> textureRanges, groups;
+        for (size_t first = 0, i = 1; i <= instances.size(); ++i) {
+            if (i == instances.size() || meshes[instances[i].mesh].texture != meshes[instances[first].mesh].texture) {
+                textureRanges.push_back(std::make_pair(first, i));
+                first = i;
+            }
+        }
+        splitInstances(instances, triangles, config.maxTriangles, textureRanges, groups);
+        batches.meshes.resize(groups.size());
+        batches.bounds.resize(groups.size());
+        parallelFor(0, groups.size(), [&](size_t g) {
+            Mesh& batch = batches.meshes[g];
+            bakeBatch(&instances[groups[g].first], groups[g].second - groups[g].first, world, batch);
+            MeshBounds bounds = meshBounds(batch.positions);
+            batches.bounds[g] = glm::vec4(bounds.center, bounds.radius);
+        });
+        if (config.upload) {
+            for (Mesh& batch : batches.meshes)
+                uploadMesh(batch);
+        }
+    }
+
+    SceneGraph residual;
+    buildResidualGraph(graph, baked, keep, residual);
+    // siatki juz tylko w paczkach - referencja grafu oddana, przy zerze bufory GL i dane CPU zwolnione
+    std::vector<char> used(meshes.size(), 0);
+    for (unsigned int mesh : residual.meshIndices)
+        used[mesh] = 1;
+    graph.meshIndices.erase(std::remove_if(graph.meshIndices.begin(), graph.meshIndices.end(),
+        [&](unsigned int mesh) { return used[mesh] != 0; }), graph.meshIndices.end());
+    releaseSceneGraph(graph);
+    graph = std::move(residual);
+}
+
+void drawStaticBatches(const StaticBatches& batches, const glm::mat4& transform, const glm::mat4& viewProjection,
+    GLuint shaderProgram, MeshLayout layout) {
+    PROFILE_FUNCTION();
+    if (batches.meshes.empty())
+        return;
+    // frustum w ukladzie paczek - sfery bez przeliczania
+    Frustum frustum = extractFrustum(viewProjection * transform);
+    FrameVector<uint32_t> visible(batches.bounds.size());
+    size_t visibleCount = cullSpheres(frustum, batches.bounds.data(), batches.bounds.size(), visible.data());
+
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(transform));
+    for (size_t i = 0; i < visibleCount; ++i) {
+        const Mesh& batch = batches.meshes[visible[i]];
+        if (layout == LAYOUT_TEXTURED)
+            glBindTexture(GL_TEXTURE_2D, textureId(batch.texture));
+        glBindVertexArray(batch.VAO[layout]);
+        glDrawElements(GL_TRIANGLES, batch.indexCount, GL_UNSIGNED_INT, 0);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "ModelLoader.h"
+
+struct StaticBatchConfig {
+    uint32_t maxTriangles = 65536;  // wieksza grupa jest dzielona wzdluz najdluzszej osi
+    bool upload = true;             // false - same dane CPU, bez wywolan GL
+};
+
+// geometria statycznych poddrzew wypieczona w ukladzie korzenia grafu, jedna paczka = jedno rysowanie z jedna tekstura
+struct StaticBatches {
+    std::vector<Mesh> meshes;
+    std::vector<glm::vec4> bounds;  // sfera (srodek, promien) na paczke - do cullSpheres
+    size_t sourceDraws = 0;         // ile rysowan drawNode zastapily
+};
+
+// wezel jest statyczny, gdy ani on, ani zaden przodek nie jest dynamic; ich siatki trafiaja do batches,
+// w graph zostaja tylko wezly ruchome (i statyczni przodkowie jako same transformacje); siatki, ktorych reszta
+// grafu juz nie uzywa, sa oddawane do MeshRegistry (releaseMesh) - geometria nie zostaje w pamieci dwa razy
+void buildStaticBatches(SceneGraph& graph, StaticBatches& batches, const StaticBatchConfig& config);
+
+// transform - ta sama macierz co parentTransform w drawNode; paczki poza frustum sa pomijane
+void drawStaticBatches(const StaticBatches& batches, const glm::mat4& transform, const glm::mat4& viewProjection,
+    GLuint shaderProgram, MeshLayout layout = LAYOUT_SHADED);
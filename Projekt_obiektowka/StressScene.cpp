@@ -0,0 +1,207 @@
+#include "StressScene.h"
+#include "JobSystem.h"
+#include "MeshRegistry.h"
+#include "Profiler.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+const float PI = 3.14159265f;
+
+// licznikowy generator: (seed, strumien) -> niezalezny ciag, bez wspolnego stanu miedzy dronami
+struct StressRandom {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t x = (state += 0x9E3779B97F4A7C15ULL);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+    float uniform() { return (float)(next() >> 40) / (float)(1ULL << 24); }
+};
+
+static StressRandom streamRandom(uint64_t seed, uint64_t stream) {
+    StressRandom random = { seed * 0xD1B54A32D192ED03ULL ^ stream };
+    random.next();
+    return random;
+}
+
+bool parseStressSceneArguments(int argc, char** argv, StressSceneConfig& config) {
+    bool stress = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+        if (std::strcmp(arg, "--stress") == 0) {
+            stress = true;
+            config.drones = (unsigned int)std::atoi(value);
+        }
+        else if (std::strcmp(arg, "--stress-depth") == 0) config.depth = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--stress-branching") == 0) config.branching = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--stress-meshes") == 0) config.meshCount = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--stress-triangles") == 0) config.trianglesPerMesh = (unsigned int)std::atoi(value);
+        else if (std::strcmp(arg, "--stress-dynamic") == 0) config.dynamicRatio = (float)std::atof(value);
+        else if (std::strcmp(arg, "--stress-extent") == 0) config.extent = (float)std::atof(value);
+        else if (std::strcmp(arg, "--stress-seed") == 0) config.seed = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(arg, "--stress-distribution") == 0) {
+            if (std::strcmp(value, "uniform") == 0) config.distribution = DISTRIBUTION_UNIFORM;
+            else if (std::strcmp(value, "clustered") == 0) config.distribution = DISTRIBUTION_CLUSTERED;
+            else config.distribution = DISTRIBUTION_GRID;
+        }
+    }
+    if (config.depth == 0) config.depth = 1;
+    if (config.meshCount == 0) config.meshCount = 1;
+    return stress;
+}
+
+size_t stressNodeCount(const StressSceneConfig& config) {
+    size_t perDrone = 0, level = 1;
+    for (unsigned int d = 0; d < config.depth; ++d) {
+        perDrone += level;
+        level *= config.branching;
+    }
+    return 1 + (size_t)config.drones * perDrone;
+}
+
+// kula z rings x segments czworokatow (2 trojkaty kazdy)
+static void generateSphereMesh(Mesh& mesh, unsigned int triangles, float radius) {
+    unsigned int segments = (unsigned int)std::max(3.0f, std::round(std::sqrt((float)triangles)));
+    unsigned int rings = std::max(2u, (triangles + 2 * segments - 1) / (2 * segments));
+
+    mesh.positions.clear();
+    mesh.normals.clear();
+    mesh.indices.clear();
+    mesh.positions.reserve((size_t)(rings + 1) * (segments + 1));
+    mesh.normals.reserve((size_t)(rings + 1) * (segments + 1));
+    mesh.indices.reserve((size_t)rings * segments * 6);
+    for (unsigned int r = 0; r <= rings; ++r) {
+        float theta = PI * r / rings;
+        for (unsigned int s = 0; s <= segments; ++s) {
+            float phi = 2.0f * PI * s / segments;
+            glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            mesh.positions.push_back(normal * radius);
+            mesh.normals.push_back(normal);
+        }
+    }
+    for (unsigned int r = 0; r < rings; ++r) {
+        for (unsigned int s = 0; s < segments; ++s) {
+            unsigned int a = r * (segments + 1) + s;
+            unsigned int b = a + segments + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+}
+
+static glm::vec3 dronePosition(const StressSceneConfig& config, unsigned int drone, StressRandom& random) {
+    float half = 0.5f * config.extent;
+    switch (config.distribution) {
+    case DISTRIBUTION_UNIFORM:
+        return glm::vec3(random.uniform() * config.extent - half, random.uniform() * 0.1f * config.extent,
+            random.uniform() * config.extent - half);
+    case DISTRIBUTION_CLUSTERED: {
+        // ~sqrt(N) skupisk, srodki z wlasnego strumienia, drony wokol nich
+        unsigned int clusters = std::max(1u, (unsigned int)std::sqrt((float)config.drones));
+        StressRandom center = streamRandom(config.seed, 0x10000000ULL + drone % clusters);
+        glm::vec3 origin(center.uniform() * config.extent - half, center.uniform() * 0.1f * config.extent,
+            center.uniform() * config.extent - half);
+        float spread = config.extent / (2.0f * clusters);
+        glm::vec3 offset(random.uniform() + random.uniform() - 1.0f, 0.5f * (random.uniform() - 0.5f),
+            random.uniform() + random.uniform() - 1.0f);
+        return origin + offset * spread;
+    }
+    default: {
+        unsigned int side = (unsigned int)std::ceil(std::sqrt((float)config.drones));
+        float spacing = config.extent / side;
+        return glm::vec3((drone % side) * spacing - half, 0.0f, (drone / side) * spacing - half);
+    }
+    }
+}
+
+static size_t perDroneNodeCount(const StressSceneConfig& config) {
+    return (stressNodeCount(config) - 1) / std::max(1u, config.drones);
+}
+
+// poddrzewo drona wszerz: korzen drona lezy w first, potomkowie w bloku [descendants, descendants + perDrone - 1)
+static void buildStressDrone(const StressSceneConfig& config, bool dynamic, StressRandom& random, SceneGraph& graph,
+    uint32_t first, uint32_t descendants) {
+    size_t perDrone = perDroneNodeCount(config);
+    uint32_t nextChild = descendants;
+    size_t levelEnd = 1;
+    size_t levelSize = 1;
+    unsigned int depth = 0;
+    for (size_t k = 0; k < perDrone; ++k) {
+        if (k == levelEnd) {
+            depth++;
+            levelSize *= config.branching;
+            levelEnd += levelSize;
+        }
+        uint32_t index = k == 0 ? first : descendants + (uint32_t)(k - 1);
+        Node& node = graph.nodes[index];
+        node.dynamic = dynamic;
+        node.firstMesh = index * config.meshesPerNode;
+        node.meshCount = config.meshesPerNode;
+        for (unsigned int m = 0; m < config.meshesPerNode; ++m)
+            graph.meshIndices[node.firstMesh + m] = (unsigned int)(random.next() % config.meshCount);
+        if (depth + 1 >= config.depth)
+            continue;
+
+        node.firstChild = nextChild;
+        node.childCount = config.branching;
+        for (unsigned int c = 0; c < config.branching; ++c) {
+            float angle = 2.0f * PI * c / config.branching;
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), 0.6f * glm::vec3(std::cos(angle), 0.3f, std::sin(angle)));
+            graph.nodes[nextChild++].transform = glm::scale(transform, glm::vec3(0.5f));
+        }
+    }
+}
+
+void generateStressScene(const StressSceneConfig& config, SceneGraph& graph) {
+    PROFILE_FUNCTION();
+    std::vector<Mesh> generated(config.meshCount);
+    parallelFor(0, generated.size(), [&](size_t m) {
+        StressRandom random = streamRandom(config.seed, 0x20000000ULL + m);
+        generateSphereMesh(generated[m], config.trianglesPerMesh, 0.2f + 0.3f * random.uniform());
+        generated[m].contentHash = meshContentHash(generated[m]);
+    });
+    // rejestr i upload tylko z watku kontekstu
+    std::vector<unsigned int> meshIndex(config.meshCount);
+    for (unsigned int m = 0; m < config.meshCount; ++m)
+        meshIndex[m] = acquireMesh(generated[m], config.upload);
+
+    // uklad: korzen, N korzeni dronow, potem bloki potomkow kazdego drona (niezalezne - wypelniane rownolegle)
+    size_t nodeCount = stressNodeCount(config);
+    size_t perDrone = perDroneNodeCount(config);
+    graph.nodes.assign(nodeCount, Node());
+    graph.meshIndices.assign(nodeCount * config.meshesPerNode, 0);
+    Node& root = graph.nodes[0];
+    root.transform = glm::mat4(1.0f);
+    root.firstChild = 1;
+    root.childCount = config.drones;
+    // dokladnie floor(N * ratio) ruchomych, rownomiernie rozlozonych po indeksach
+    parallelFor(0, config.drones, [&](size_t i) {
+        unsigned int drone = (unsigned int)i;
+        bool dynamic = std::floor((drone + 1) * config.dynamicRatio) > std::floor(drone * config.dynamicRatio);
+        StressRandom random = streamRandom(config.seed, drone);
+        uint32_t first = 1 + drone;
+        uint32_t descendants = (uint32_t)(1 + config.drones + i * (perDrone - 1));
+        glm::vec3 position = dronePosition(config, drone, random);
+        float yaw = 2.0f * PI * random.uniform();
+        graph.nodes[first].transform = glm::rotate(glm::translate(glm::mat4(1.0f), position), yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+        buildStressDrone(config, dynamic, random, graph, first, descendants);
+    }, 64);
+
+    // graf trzyma jedna referencje na kazda rozna uzyta siatke - nieuzyte i powtorzone (ta sama kula) oddawane
+    std::vector<char> used(config.meshCount, 0);
+    for (unsigned int& index : graph.meshIndices) {
+        used[index] = 1;
+        index = meshIndex[index];
+    }
+    std::unordered_set<unsigned int> held;
+    for (unsigned int m = 0; m < config.meshCount; ++m) {
+        if (!used[m] || !held.insert(meshIndex[m]).second)
+            releaseMesh(meshIndex[m]);
+    }
+}
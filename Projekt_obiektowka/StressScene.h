@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "ModelLoader.h"
+
+enum SceneDistribution {
+    DISTRIBUTION_GRID,
+    DISTRIBUTION_UNIFORM,
+    DISTRIBUTION_CLUSTERED
+};
+
+// scena testowa: drones poddrzew (pelne drzewa depth x branching) rozstawionych w extent,
+// meshCount kul po ~trianglesPerMesh trojkatow; ten sam seed = ta sama scena
+struct StressSceneConfig {
+    unsigned int drones = 100;
+    unsigned int depth = 3;
+    unsigned int branching = 2;
+    unsigned int meshesPerNode = 1;
+    unsigned int meshCount = 8;
+    unsigned int trianglesPerMesh = 500;
+    float dynamicRatio = 0.5f;  // czesc dronow oznaczona jako ruchoma
+    SceneDistribution distribution = DISTRIBUTION_GRID;
+    float extent = 20.0f;
+    uint64_t seed = 1;
+    bool upload = true;  // false - same dane CPU, bez wywolan GL
+};
+
+// --stress N [--stress-depth D --stress-branching B --stress-meshes M --stress-triangles T
+//  --stress-dynamic R --stress-distribution grid|uniform|clustered --stress-extent E --stress-seed S]
+bool parseStressSceneArguments(int argc, char** argv, StressSceneConfig& config);
+
+size_t stressNodeCount(const StressSceneConfig& config);
+// kule przez MeshRegistry (graf trzyma referencje jak po loadModel - poprzednia scena zwalniana releaseSceneGraph)
+// i graf; drony powstaja rownolegle, wynik nie zalezy od liczby watkow
+void generateStressScene(const StressSceneConfig& config, SceneGraph& graph);
@@ -0,0 +1,523 @@
+#include "Telemetry.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+const uint32_t TELEMETRY_MAGIC = 0x4C545244; // "DRTL"
+const uint32_t TELEMETRY_VERSION = 1;
+const size_t TELEMETRY_INITIAL_CAPACITY = 64u << 20;
+const unsigned int COLUMN_COUNT = TELEMETRY_FLOAT_COLUMNS + 2;
+
+const char* TELEMETRY_COLUMN_NAMES[TELEMETRY_FLOAT_COLUMNS] = {
+    "pos_x", "pos_y", "pos_z", "vel_x", "vel_y", "vel_z",
+    "quat_w", "quat_x", "quat_y", "quat_z",
+    "imu_ax", "imu_ay", "imu_az", "imu_gx", "imu_gy", "imu_gz",
+    "gps_x", "gps_y", "gps_z", "thrust"
+};
+
+struct TelemetryFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t columnCount;
+};
+
+struct TelemetryBlockHeader {
+    uint32_t recordCount;
+    uint32_t flags;
+    uint64_t firstStep;
+    uint64_t lastStep;
+};
+
+struct TelemetryFooter {
+    uint64_t indexOffset;
+    uint64_t blockCount;
+    uint32_t magic;
+    uint32_t reserved;
+};
+
+struct RingBinding {
+    uint64_t recorderId;
+    TelemetryRing* ring;
+};
+
+static std::atomic<uint64_t> nextRecorderId{ 1 };
+static thread_local std::vector<RingBinding> ringBindings;
+
+static size_t align8(size_t value) {
+    return (value + 7) & ~(size_t)7;
+}
+
+// --- kodowanie kolumn ---
+
+static void writeVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+// false gdy liczba wychodzi poza kolumne
+static bool readVarint(const unsigned char*& in, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        unsigned char byte = *in++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// XOR z poprzednia wartoscia, zapisujemy tylko niezerowe mlodsze bajty;
+// dlugosci (0-4) jako pol-bajty na poczatku kolumny
+static void encodeFloats(std::vector<unsigned char>& out, const float* values, size_t count) {
+    size_t headerStart = out.size();
+    out.resize(headerStart + (count + 1) / 2, 0);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t bits;
+        std::memcpy(&bits, &values[i], 4);
+        uint32_t x = bits ^ previous;
+        previous = bits;
+        unsigned int length = x == 0 ? 0 : x >> 24 ? 4 : x >> 16 ? 3 : x >> 8 ? 2 : 1;
+        out[headerStart + i / 2] |= (unsigned char)(length << ((i & 1) * 4));
+        for (unsigned int b = 0; b < length; ++b)
+            out.push_back((unsigned char)(x >> (b * 8)));
+    }
+}
+
+static bool decodeFloats(const unsigned char* in, size_t bytes, size_t count, float* values) {
+    if (bytes < (count + 1) / 2)
+        return false;
+    const unsigned char* payload = in + (count + 1) / 2;
+    const unsigned char* end = in + bytes;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        unsigned int length = (in[i / 2] >> ((i & 1) * 4)) & 0xF;
+        if (length > 4 || (size_t)(end - payload) < length)
+            return false;
+        uint32_t x = 0;
+        for (unsigned int b = 0; b < length; ++b)
+            x |= (uint32_t)*payload++ << (b * 8);
+        previous ^= x;
+        std::memcpy(&values[i], &previous, 4);
+    }
+    return true;
+}
+
+// --- zapis ---
+
+// po nieudanej zmianie rozmiaru mapowania juz nie ma (size == 0) - recorder.failed blokuje dalsze zapisy
+static bool ensureCapacity(TelemetryRecorder& recorder, size_t required) {
+    if (recorder.failed)
+        return false;
+    if (required <= recorder.file.size)
+        return true;
+    size_t capacity = recorder.file.size;
+    while (capacity < required)
+        capacity *= 2;
+    if (!resizeMappedFile(recorder.file, capacity)) {
+        std::cerr << "ERROR::TELEMETRY::RESIZE_FAILED " << recorder.path << std::endl;
+        recorder.failed = true;
+        return false;
+    }
+    return true;
+}
+
+static bool appendColumn(TelemetryRecorder& recorder, const void* data, size_t bytes) {
+    size_t offset = recorder.writeOffset;
+    if (!ensureCapacity(recorder, offset + 8 + align8(bytes)))
+        return false;
+    uint32_t header[2] = { (uint32_t)bytes, 0 };
+    std::memcpy(recorder.file.data + offset, header, 8);
+    std::memcpy(recorder.file.data + offset + 8, data, bytes);
+    std::memset(recorder.file.data + offset + 8 + bytes, 0, align8(bytes) - bytes);
+    recorder.writeOffset = offset + 8 + align8(bytes);
+    return true;
+}
+
+static void clearBlock(TelemetryRecorder& recorder) {
+    recorder.steps.clear();
+    recorder.drones.clear();
+    for (unsigned int c = 0; c < TELEMETRY_FLOAT_COLUMNS; ++c)
+        recorder.columns[c].clear();
+}
+
+// false gdy zabraklo miejsca - blok niekompletny
+static bool writeBlock(TelemetryRecorder& recorder, TelemetryIndexEntry& entry) {
+    size_t count = recorder.steps.size();
+    entry.offset = recorder.writeOffset;
+    entry.recordCount = (uint32_t)count;
+    entry.firstStep = recorder.steps[0];
+    entry.lastStep = recorder.steps[0];
+    for (uint64_t step : recorder.steps) {
+        entry.firstStep = step < entry.firstStep ? step : entry.firstStep;
+        entry.lastStep = step > entry.lastStep ? step : entry.lastStep;
+    }
+    entry.maxStep = recorder.index.empty() || entry.lastStep > recorder.index.back().maxStep
+        ? entry.lastStep : recorder.index.back().maxStep;
+
+    if (!ensureCapacity(recorder, recorder.writeOffset + sizeof(TelemetryBlockHeader)))
+        return false;
+    TelemetryBlockHeader header = { (uint32_t)count, recorder.flags, entry.firstStep, entry.lastStep };
+    std::memcpy(recorder.file.data + recorder.writeOffset, &header, sizeof(header));
+    recorder.writeOffset += sizeof(header);
+
+    if (recorder.flags & TELEMETRY_FLAG_COMPRESSED) {
+        std::vector<unsigned char>& scratch = recorder.scratch;
+        scratch.clear();
+        uint64_t previousStep = 0;
+        for (uint64_t step : recorder.steps) {
+            writeVarint(scratch, zigzag((int64_t)(step - previousStep)));
+            previousStep = step;
+        }
+        if (!appendColumn(recorder, scratch.data(), scratch.size()))
+            return false;
+
+        scratch.clear();
+        uint32_t previousDrone = 0;
+        for (uint32_t drone : recorder.drones) {
+            writeVarint(scratch, zigzag((int64_t)drone - (int64_t)previousDrone));
+            previousDrone = drone;
+        }
+        if (!appendColumn(recorder, scratch.data(), scratch.size()))
+            return false;
+
+        for (unsigned int c = 0; c < TELEMETRY_FLOAT_COLUMNS; ++c) {
+            scratch.clear();
+            encodeFloats(scratch, recorder.columns[c].data(), count);
+            if (!appendColumn(recorder, scratch.data(), scratch.size()))
+                return false;
+        }
+    } else {
+        if (!appendColumn(recorder, recorder.steps.data(), count * sizeof(uint64_t))
+            || !appendColumn(recorder, recorder.drones.data(), count * sizeof(uint32_t)))
+            return false;
+        for (unsigned int c = 0; c < TELEMETRY_FLOAT_COLUMNS; ++c) {
+            if (!appendColumn(recorder, recorder.columns[c].data(), count * sizeof(float)))
+                return false;
+        }
+    }
+
+    entry.byteSize = (uint32_t)(recorder.writeOffset - entry.offset);
+    return true;
+}
+
+// blok trafia do indeksu tylko gdy wszystkie kolumny sie zapisaly; biezacy blok czyszczony zawsze
+static void flushBlock(TelemetryRecorder& recorder) {
+    PROFILE_FUNCTION();
+    TelemetryIndexEntry entry;
+    if (!recorder.steps.empty() && writeBlock(recorder, entry))
+        recorder.index.push_back(entry);
+    clearBlock(recorder);
+}
+
+static bool drainRings(TelemetryRecorder& recorder) {
+    bool any = false;
+    std::lock_guard<std::mutex> lock(recorder.ringsMutex);
+    for (std::unique_ptr<TelemetryRing>& ring : recorder.rings) {
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        size_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            const TelemetryRecord& record = ring->records[tail & (TELEMETRY_RING_CAPACITY - 1)];
+            recorder.steps.push_back(record.step);
+            recorder.drones.push_back(record.drone);
+            for (unsigned int c = 0; c < TELEMETRY_FLOAT_COLUMNS; ++c)
+                recorder.columns[c].push_back(record.values[c]);
+            if (recorder.steps.size() == TELEMETRY_BLOCK_RECORDS)
+                flushBlock(recorder);
+            any = true;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    return any;
+}
+
+static void writerLoop(TelemetryRecorder* recorder) {
+    PROFILE_THREAD("telemetry writer");
+    while (recorder->running.load(std::memory_order_relaxed)) {
+        if (!drainRings(*recorder))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    drainRings(*recorder);
+}
+
+bool openTelemetryRecorder(TelemetryRecorder& recorder, const std::string& path, bool compress) {
+    if (!createMappedFile(recorder.file, path, TELEMETRY_INITIAL_CAPACITY)) {
+        std::cerr << "ERROR::TELEMETRY::CANNOT_CREATE " << path << std::endl;
+        return false;
+    }
+    recorder.id = nextRecorderId++;
+    recorder.path = path;
+    recorder.failed = false;
+    recorder.flags = compress ? TELEMETRY_FLAG_COMPRESSED : 0;
+    TelemetryFileHeader header = { TELEMETRY_MAGIC, TELEMETRY_VERSION, recorder.flags, COLUMN_COUNT };
+    std::memcpy(recorder.file.data, &header, sizeof(header));
+    recorder.writeOffset = sizeof(header);
+
+    recorder.steps.reserve(TELEMETRY_BLOCK_RECORDS);
+    recorder.drones.reserve(TELEMETRY_BLOCK_RECORDS);
+    for (unsigned int c = 0; c < TELEMETRY_FLOAT_COLUMNS; ++c)
+        recorder.columns[c].reserve(TELEMETRY_BLOCK_RECORDS);
+
+    recorder.running = true;
+    recorder.writer = std::thread(writerLoop, &recorder);
+    return true;
+}
+
+void* TelemetryRing::operator new(size_t size) {
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size, alignof(TelemetryRing));
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(TelemetryRing), size) != 0)
+        memory = nullptr;
+#endif
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void TelemetryRing::operator delete(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+static TelemetryRing* threadRing(TelemetryRecorder& recorder) {
+    for (const RingBinding& binding : ringBindings) {
+        if (binding.recorderId == recorder.id)
+            return binding.ring;
+    }
+    TelemetryRing* ring = new TelemetryRing();
+    {
+        std::lock_guard<std::mutex> lock(recorder.ringsMutex);
+        recorder.rings.emplace_back(ring);
+    }
+    ringBindings.push_back({ recorder.id, ring });
+    return ring;
+}
+
+void recordTelemetry(TelemetryRecorder& recorder, const TelemetryRecord& record) {
+    TelemetryRing* ring = threadRing(recorder);
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= TELEMETRY_RING_CAPACITY) {
+        recorder.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->records[head & (TELEMETRY_RING_CAPACITY - 1)] = record;
+    ring->head.store(head + 1, std::memory_order_release);
+    recorder.recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+void recordDroneTelemetry(TelemetryRecorder& recorder, const SimState& state) {
+    parallelFor(0, state.drones.size(), [&](size_t i) {
+        const DroneState& drone = state.drones[i];
+        TelemetryRecord record;
+        record.step = state.step;
+        record.drone = (uint32_t)i;
+        float* v = record.values;
+        v[0] = drone.position.x; v[1] = drone.position.y; v[2] = drone.position.z;
+        v[3] = drone.velocity.x; v[4] = drone.velocity.y; v[5] = drone.velocity.z;
+        v[6] = drone.orientation.w; v[7] = drone.orientation.x; v[8] = drone.orientation.y; v[9] = drone.orientation.z;
+        v[10] = drone.imuAccel.x; v[11] = drone.imuAccel.y; v[12] = drone.imuAccel.z;
+        v[13] = drone.imuGyro.x; v[14] = drone.imuGyro.y; v[15] = drone.imuGyro.z;
+        v[16] = drone.gpsPosition.x; v[17] = drone.gpsPosition.y; v[18] = drone.gpsPosition.z;
+        v[19] = drone.thrust;
+        recordTelemetry(recorder, record);
+    }, 256);
+}
+
+void closeTelemetryRecorder(TelemetryRecorder& recorder) {
+    if (!recorder.running)
+        return;
+    recorder.running = false;
+    recorder.writer.join();
+    flushBlock(recorder);
+    recorder.rings.clear();
+
+    // bez pelnego zapisu plik nie mialby stopki, ktorej wymaga czytnik - usuwany zamiast obcinania
+    if (recorder.failed) {
+        closeMappedFile(recorder.file);
+        std::remove(recorder.path.c_str());
+        std::cerr << "ERROR::TELEMETRY::WRITE_FAILED " << recorder.path << " removed" << std::endl;
+        return;
+    }
+
+    // indeks blokow + stopka na koncu pliku
+    size_t indexOffset = align8(recorder.writeOffset);
+    size_t indexBytes = recorder.index.size() * sizeof(TelemetryIndexEntry);
+    size_t finalSize = indexOffset + indexBytes + sizeof(TelemetryFooter);
+    if (!ensureCapacity(recorder, finalSize)) {
+        closeMappedFile(recorder.file);
+        std::remove(recorder.path.c_str());
+        std::cerr << "ERROR::TELEMETRY::WRITE_FAILED " << recorder.path << " removed" << std::endl;
+        return;
+    }
+    std::memset(recorder.file.data + recorder.writeOffset, 0, indexOffset - recorder.writeOffset);
+    if (indexBytes)
+        std::memcpy(recorder.file.data + indexOffset, recorder.index.data(), indexBytes);
+    TelemetryFooter footer = { indexOffset, recorder.index.size(), TELEMETRY_MAGIC, 0 };
+    std::memcpy(recorder.file.data + indexOffset + indexBytes, &footer, sizeof(footer));
+    closeMappedFile(recorder.file, finalSize);
+
+    std::cout << "Telemetry: " << recorder.recorded << " records in " << recorder.index.size()
+        << " blocks, " << finalSize << " bytes, " << recorder.dropped << " dropped" << std::endl;
+}
+
+// --- odczyt ---
+
+bool openTelemetryReader(TelemetryReader& reader, const std::string& path) {
+    if (!mapFileForRead(reader.file, path))
+        return false;
+    TelemetryFooter footer;
+    TelemetryFileHeader header;
+    if (reader.file.size < sizeof(header) + sizeof(footer)) {
+        closeMappedFile(reader.file);
+        return false;
+    }
+    std::memcpy(&header, reader.file.data, sizeof(header));
+    std::memcpy(&footer, reader.file.data + reader.file.size - sizeof(footer), sizeof(footer));
+    // indeks dokladnie miedzy blokami a stopka, wyrownany do 8
+    size_t indexEnd = reader.file.size - sizeof(footer);
+    bool valid = header.magic == TELEMETRY_MAGIC && footer.magic == TELEMETRY_MAGIC
+        && header.version == TELEMETRY_VERSION && header.columnCount == COLUMN_COUNT
+        && footer.indexOffset >= sizeof(header) && footer.indexOffset <= indexEnd && footer.indexOffset % 8 == 0
+        && footer.blockCount == (indexEnd - footer.indexOffset) / sizeof(TelemetryIndexEntry)
+        && footer.blockCount * sizeof(TelemetryIndexEntry) == indexEnd - footer.indexOffset;
+    const TelemetryIndexEntry* index = (const TelemetryIndexEntry*)(reader.file.data + footer.indexOffset);
+    for (uint64_t i = 0; valid && i < footer.blockCount; ++i) {
+        const TelemetryIndexEntry& entry = index[i];
+        valid = entry.offset >= sizeof(header) && entry.offset % 8 == 0 && entry.offset <= footer.indexOffset
+            && entry.byteSize >= sizeof(TelemetryBlockHeader) && entry.byteSize <= footer.indexOffset - entry.offset
+            && entry.recordCount <= TELEMETRY_BLOCK_RECORDS;
+    }
+    if (!valid) {
+        std::cerr << "ERROR::TELEMETRY::BAD_FILE " << path << std::endl;
+        closeMappedFile(reader.file);
+        return false;
+    }
+    reader.flags = header.flags;
+    reader.blockCount = footer.blockCount;
+    reader.index = index;
+    adviseSequential(reader.file);
+    return true;
+}
+
+size_t findTelemetryBlock(const TelemetryReader& reader, uint64_t step) {
+    size_t low = 0, high = (size_t)reader.blockCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (reader.index[middle].maxStep < step)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// wskazniki na kolejne kolumny bloku, nullptr gdy rozmiary kolumn wychodza poza blok
+static const unsigned char* columnAt(const TelemetryReader& reader, size_t block, unsigned int column, uint32_t* bytes) {
+    const TelemetryIndexEntry& entry = reader.index[block];
+    size_t offset = sizeof(TelemetryBlockHeader);
+    for (unsigned int c = 0; ; ++c) {
+        if (entry.byteSize - offset < 8)
+            return nullptr;
+        uint32_t size;
+        std::memcpy(&size, reader.file.data + entry.offset + offset, 4);
+        if (entry.byteSize - offset - 8 < align8(size))
+            return nullptr;
+        if (c == column) {
+            *bytes = size;
+            return reader.file.data + entry.offset + offset + 8;
+        }
+        offset += 8 + align8(size);
+    }
+}
+
+bool readTelemetryBlock(const TelemetryReader& reader, size_t block, std::vector<TelemetryRecord>& records) {
+    if (block >= reader.blockCount)
+        return false;
+    const TelemetryIndexEntry& entry = reader.index[block];
+    size_t count = entry.recordCount;
+    records.resize(count);
+    prefetchRange(reader.file, (size_t)entry.offset, entry.byteSize);
+
+    uint32_t stepBytes, droneBytes;
+    bool compressed = (reader.flags & TELEMETRY_FLAG_COMPRESSED) != 0;
+    const unsigned char* steps = columnAt(reader, block, 0, &stepBytes);
+    const unsigned char* drones = columnAt(reader, block, 1, &droneBytes);
+    if (!steps || !drones || (!compressed && (stepBytes != count * 8 || droneBytes != count * 4)))
+        return false;
+    const unsigned char* stepsEnd = steps + stepBytes;
+    const unsigned char* dronesEnd = drones + droneBytes;
+    uint64_t step = 0;
+    uint32_t drone = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (compressed) {
+            uint64_t stepDelta, droneDelta;
+            if (!readVarint(steps, stepsEnd, stepDelta) || !readVarint(drones, dronesEnd, droneDelta))
+                return false;
+            step += (uint64_t)unzigzag(stepDelta);
+            drone += (uint32_t)unzigzag(droneDelta);
+        } else {
+            std::memcpy(&step, steps + i * 8, 8);
+            std::memcpy(&drone, drones + i * 4, 4);
+        }
+        records[i].step = step;
+        records[i].drone = drone;
+    }
+
+    std::vector<float> column(count);
+    for (unsigned int c = 0; c < TELEMETRY_FLOAT_COLUMNS; ++c) {
+        uint32_t bytes;
+        const unsigned char* data = columnAt(reader, block, c + 2, &bytes);
+        if (!data)
+            return false;
+        if (compressed) {
+            if (!decodeFloats(data, bytes, count, column.data()))
+                return false;
+        } else {
+            if (bytes != count * sizeof(float))
+                return false;
+            std::memcpy(column.data(), data, count * sizeof(float));
+        }
+        for (size_t i = 0; i < count; ++i)
+            records[i].values[c] = column[i];
+    }
+    return true;
+}
+
+const float* telemetryColumn(const TelemetryReader& reader, size_t block, unsigned int column) {
+    if (block >= reader.blockCount || column >= TELEMETRY_FLOAT_COLUMNS || (reader.flags & TELEMETRY_FLAG_COMPRESSED))
+        return nullptr;
+    uint32_t bytes;
+    const unsigned char* data = columnAt(reader, block, column + 2, &bytes);
+    if (!data || bytes != reader.index[block].recordCount * sizeof(float))
+        return nullptr;
+    return (const float*)data;
+}
+
+void closeTelemetryReader(TelemetryReader& reader) {
+    closeMappedFile(reader.file);
+    reader.index = nullptr;
+    reader.blockCount = 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "MappedFile.h"
+
+struct SimState;
+
+// pozycja(3) predkosc(3) orientacja(4) imuAccel(3) imuGyro(3) gps(3) ciag(1)
+const unsigned int TELEMETRY_FLOAT_COLUMNS = 20;
+const unsigned int TELEMETRY_BLOCK_RECORDS = 8192;
+const uint32_t TELEMETRY_FLAG_COMPRESSED = 1;
+
+extern const char* TELEMETRY_COLUMN_NAMES[TELEMETRY_FLOAT_COLUMNS];
+
+struct TelemetryRecord {
+    uint64_t step;
+    uint32_t drone;
+    float values[TELEMETRY_FLOAT_COLUMNS];
+};
+
+// wpis indeksu na koncu pliku; maxStep to maksimum lastStep do tego bloku wlacznie,
+// po nim szukamy binarnie (rekordy z roznych watkow moga przyjsc lekko wymieszane)
+struct TelemetryIndexEntry {
+    uint64_t firstStep;
+    uint64_t lastStep;
+    uint64_t maxStep;
+    uint64_t offset;
+    uint32_t recordCount;
+    uint32_t byteSize;
+};
+
+const size_t TELEMETRY_RING_CAPACITY = 1 << 16;
+
+// pierscien SPSC jednego watku producenta
+struct TelemetryRing {
+    alignas(64) std::atomic<size_t> head{ 0 };  // pisze producent
+    alignas(64) std::atomic<size_t> tail{ 0 };  // pisze watek zapisu
+    std::unique_ptr<TelemetryRecord[]> records{ new TelemetryRecord[TELEMETRY_RING_CAPACITY] };
+
+    // alignas(64) - zwykly new przed C++17 nie gwarantuje wyrownania
+    static void* operator new(size_t size);
+    static void operator delete(void* memory);
+};
+
+struct TelemetryRecorder {
+    uint64_t id = 0;
+    std::string path;
+    MappedFile file;
+    size_t writeOffset = 0;
+    uint32_t flags = 0;
+    bool failed = false;  // pierwszy blad zmiany rozmiaru - dalej nic nie jest zapisywane, plik usuwany przy zamknieciu
+    std::vector<TelemetryIndexEntry> index;
+
+    // kazdy watek producenta ma swoj pierscien SPSC, zapisuje je jeden watek
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<TelemetryRing>> rings;
+    std::thread writer;
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> recorded{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+
+    // biezacy blok w ukladzie kolumnowym
+    std::vector<uint64_t> steps;
+    std::vector<uint32_t> drones;
+    std::vector<float> columns[TELEMETRY_FLOAT_COLUMNS];
+    std::vector<unsigned char> scratch;
+};
+
+bool openTelemetryRecorder(TelemetryRecorder& recorder, const std::string& path, bool compress);
+// bez blokad i bez czekania - gdy pierscien jest pelny rekord jest liczony jako dropped
+void recordTelemetry(TelemetryRecorder& recorder, const TelemetryRecord& record);
+void recordDroneTelemetry(TelemetryRecorder& recorder, const SimState& state);
+void closeTelemetryRecorder(TelemetryRecorder& recorder);
+
+struct TelemetryReader {
+    MappedFile file;
+    uint32_t flags = 0;
+    const TelemetryIndexEntry* index = nullptr;
+    uint64_t blockCount = 0;
+};
+
+bool openTelemetryReader(TelemetryReader& reader, const std::string& path);
+// pierwszy blok, ktory moze zawierac dany krok (O(log n))
+size_t findTelemetryBlock(const TelemetryReader& reader, uint64_t step);
+bool readTelemetryBlock(const TelemetryReader& reader, size_t block, std::vector<TelemetryRecord>& records);
+// bezposredni wskaznik na kolumne w pliku (tylko bez kompresji) - skanowanie z predkoscia pamieci
+const float* telemetryColumn(const TelemetryReader& reader, size_t block, unsigned int column);
+void closeTelemetryReader(TelemetryReader& reader);
@@ -0,0 +1,433 @@
+#include "TextureCodec.h"
+#include "ImageDecoder.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTURE_SSE2 1
+#endif
+
+const uint32_t TEXTURE_CACHE_MAGIC = 0x58455444;  // "DTEX"
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t levelCount;
+    uint64_t dataSize;
+};
+
+struct TextureCacheLevel {
+    uint32_t width, height;
+    uint64_t offset, size;
+};
+
+static size_t blockBytes(TextureFormat format) {
+    return format == TEXTURE_BC1 ? 8 : 16;
+}
+
+size_t textureRowSize(TextureFormat format, uint32_t width) {
+    if (format == TEXTURE_RGBA8)
+        return (size_t)width * 4;
+    return (size_t)((width + 3) / 4) * blockBytes(format);
+}
+
+uint32_t textureRowCount(TextureFormat format, uint32_t height) {
+    return format == TEXTURE_RGBA8 ? height : (height + 3) / 4;
+}
+
+size_t textureLevelSize(TextureFormat format, uint32_t width, uint32_t height) {
+    return textureRowSize(format, width) * textureRowCount(format, height);
+}
+
+bool decodeImage(const unsigned char* encoded, size_t size, TextureImage& image) {
+    PROFILE_FUNCTION();
+    uint32_t width = 0, height = 0;
+    if (!decodeImageRgba(encoded, size, width, height, image.data))
+        return false;
+    image.format = TEXTURE_RGBA8;
+    image.levels.assign(1, TextureLevel{ width, height, 0, image.data.size() });
+    return true;
+}
+
+// zaokraglona srednia 2x2; nieparzysty brzeg powtarza ostatni wiersz/kolumne
+void downsampleBox(const unsigned char* source, uint32_t sourceWidth, uint32_t sourceHeight,
+    unsigned char* target, uint32_t width, uint32_t height) {
+    for (uint32_t y = 0; y < height; ++y) {
+        const unsigned char* row0 = source + (size_t)std::min(2 * y, sourceHeight - 1) * sourceWidth * 4;
+        const unsigned char* row1 = source + (size_t)std::min(2 * y + 1, sourceHeight - 1) * sourceWidth * 4;
+        unsigned char* out = target + (size_t)y * width * 4;
+        uint32_t x = 0;
+#ifdef TEXTURE_SSE2
+        // 8 pikseli z kazdego wiersza -> 4 wyjsciowe, sumy w 16 bitach
+        const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+        for (; x + 4 <= width && 2 * x + 8 <= sourceWidth; x += 4) {
+            __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + 8 * x));
+            __m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + 8 * x + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + 8 * x));
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + 8 * x + 16));
+            __m128i p01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            __m128i p23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            __m128i p45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            __m128i p67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+            __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi64(p01, p23), _mm_unpackhi_epi64(p01, p23));
+            __m128i s23 = _mm_add_epi16(_mm_unpacklo_epi64(p45, p67), _mm_unpackhi_epi64(p45, p67));
+            s01 = _mm_srli_epi16(_mm_add_epi16(s01, two), 2);
+            s23 = _mm_srli_epi16(_mm_add_epi16(s23, two), 2);
+            _mm_storeu_si128((__m128i*)(out + 4 * x), _mm_packus_epi16(s01, s23));
+        }
+#endif
+        for (; x < width; ++x) {
+            uint32_t x0 = std::min(2 * x, sourceWidth - 1) * 4, x1 = std::min(2 * x + 1, sourceWidth - 1) * 4;
+            for (int c = 0; c < 4; ++c)
+                out[4 * x + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+        }
+    }
+}
+
+const int KAISER_TAPS = 8;
+
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 25; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// wagi dla zrodel 2x-3 .. 2x+4: sinc o promieniu 2 pikseli wyjscia w oknie Kaisera (alfa 4), suma 1
+static const float* kaiserWeights() {
+    struct Kernel {
+        float weights[KAISER_TAPS];
+        Kernel() {
+            const double pi = 3.14159265358979323846, alpha = 4.0;
+            double sum = 0.0;
+            double raw[KAISER_TAPS];
+            for (int k = 0; k < KAISER_TAPS; ++k) {
+                double t = (k - 3 - 0.5) / 2.0;
+                double r = t / 2.0;
+                double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+                raw[k] = std::fabs(r) >= 1.0 ? 0.0 : sinc * besselI0(alpha * std::sqrt(1.0 - r * r)) / besselI0(alpha);
+                sum += raw[k];
+            }
+            for (int k = 0; k < KAISER_TAPS; ++k)
+                weights[k] = (float)(raw[k] / sum);
+        }
+    };
+    static const Kernel kernel;
+    return kernel.weights;
+}
+
+// rozdzielnie: poziomo do bufora float, potem pionowo; ujemne listki sinc wymagaja obciecia do 0..255
+static void downsampleKaiser(const unsigned char* source, uint32_t sourceWidth, uint32_t sourceHeight,
+    unsigned char* target, uint32_t width, uint32_t height) {
+    const float* weights = kaiserWeights();
+    std::vector<float> horizontal((size_t)width * sourceHeight * 4);
+    for (uint32_t y = 0; y < sourceHeight; ++y) {
+        const unsigned char* row = source + (size_t)y * sourceWidth * 4;
+        float* out = &horizontal[(size_t)y * width * 4];
+        for (uint32_t x = 0; x < width; ++x) {
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int k = 0; k < KAISER_TAPS; ++k) {
+                int sx = std::min(std::max((int)(2 * x) + k - 3, 0), (int)sourceWidth - 1);
+                for (int c = 0; c < 4; ++c)
+                    sum[c] += weights[k] * row[sx * 4 + c];
+            }
+            std::memcpy(out + 4 * x, sum, sizeof(sum));
+        }
+    }
+    size_t stride = (size_t)width * 4;
+    for (uint32_t y = 0; y < height; ++y) {
+        unsigned char* out = target + (size_t)y * stride;
+        for (size_t i = 0; i < stride; ++i) {
+            float sum = 0.0f;
+            for (int k = 0; k < KAISER_TAPS; ++k) {
+                int sy = std::min(std::max((int)(2 * y) + k - 3, 0), (int)sourceHeight - 1);
+                sum += weights[k] * horizontal[(size_t)sy * stride + i];
+            }
+            out[i] = (unsigned char)std::min(std::max(sum + 0.5f, 0.0f), 255.0f);
+        }
+    }
+}
+
+void buildMipChain(TextureImage& image, MipFilter filter) {
+    PROFILE_FUNCTION();
+    if (image.format != TEXTURE_RGBA8 || image.levels.size() != 1)
+        return;
+    // wszystkie poziomy naraz - data nie przesuwa sie miedzy poziomami
+    size_t total = image.levels[0].size;
+    uint32_t width = image.levels[0].width, height = image.levels[0].height;
+    while (width > 1 || height > 1) {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        image.levels.push_back(TextureLevel{ width, height, total, (size_t)width * height * 4 });
+        total += image.levels.back().size;
+    }
+    image.data.resize(total);
+    for (size_t level = 1; level < image.levels.size(); ++level) {
+        const TextureLevel& from = image.levels[level - 1];
+        const TextureLevel& to = image.levels[level];
+        if (filter == MIP_FILTER_KAISER)
+            downsampleKaiser(&image.data[from.offset], from.width, from.height, &image.data[to.offset], to.width, to.height);
+        else
+            downsampleBox(&image.data[from.offset], from.width, from.height, &image.data[to.offset], to.width, to.height);
+    }
+}
+
+static uint16_t packColor565(const int* color) {
+    return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void unpackColor565(uint16_t value, int* color) {
+    int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// ramka kolorow bloku zwezona o 1/16 zakresu (van Waveren) i najblizszy z 4 kolorow palety;
+// kanaly rosna niezaleznie, wiec c0 >= c1 - zawsze tryb 4 kolorow
+static void encodeColorBlock(const unsigned char* block, unsigned char* out) {
+    int low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            low[c] = std::min(low[c], (int)block[4 * i + c]);
+            high[c] = std::max(high[c], (int)block[4 * i + c]);
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        int inset = (high[c] - low[c]) >> 4;
+        low[c] += inset;
+        high[c] -= inset;
+    }
+    uint16_t color0 = packColor565(high), color1 = packColor565(low);
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackColor565(color0, palette[0]);
+        unpackColor565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDistance = INT_MAX;
+            for (int p = 0; p < 4; ++p) {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[4 * i + c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+    std::memcpy(out, &color0, 2);
+    std::memcpy(out + 2, &color1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// alfa: skrajne wartosci bloku + 6 posrednich, 3 bity na piksel
+static void encodeAlphaBlock(const unsigned char* block, unsigned char* out) {
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; ++i) {
+        low = std::min(low, (int)block[4 * i + 3]);
+        high = std::max(high, (int)block[4 * i + 3]);
+    }
+    uint64_t indices = 0;
+    if (high != low) {
+        int palette[8] = { high, low };
+        for (int i = 1; i < 7; ++i)
+            palette[1 + i] = ((7 - i) * high + i * low) / 7;
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDistance = INT_MAX;
+            for (int p = 0; p < 8; ++p) {
+                int distance = std::abs(block[4 * i + 3] - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+    out[0] = (unsigned char)high;
+    out[1] = (unsigned char)low;
+    for (int b = 0; b < 6; ++b)
+        out[2 + b] = (unsigned char)(indices >> (8 * b));
+}
+
+void compressBlocks(const unsigned char* pixels, uint32_t width, uint32_t height, TextureFormat format, unsigned char* out) {
+    size_t rowSize = textureRowSize(format, width);
+    // wiersze blokow niezalezne - duze obrazy rownolegle tez w obrebie jednej tekstury
+    parallelFor(0, textureRowCount(format, height), [&](size_t by) {
+        unsigned char block[64];
+        unsigned char* target = out + by * rowSize;
+        for (uint32_t bx = 0; bx < (width + 3) / 4; ++bx) {
+            // brzegi niepelnych blokow powtarzaja ostatni piksel
+            for (uint32_t y = 0; y < 4; ++y) {
+                uint32_t py = std::min((uint32_t)by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; ++x) {
+                    uint32_t px = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, pixels + ((size_t)py * width + px) * 4, 4);
+                }
+            }
+            if (format == TEXTURE_BC3) {
+                encodeAlphaBlock(block, target);
+                encodeColorBlock(block, target + 8);
+                target += 16;
+            } else {
+                encodeColorBlock(block, target);
+                target += 8;
+            }
+        }
+    }, 16);
+}
+
+void decompressBlocks(const unsigned char* blocks, uint32_t width, uint32_t height, TextureFormat format, unsigned char* pixels) {
+    const unsigned char* in = blocks;
+    for (uint32_t by = 0; by < (height + 3) / 4; ++by) {
+        for (uint32_t bx = 0; bx < (width + 3) / 4; ++bx) {
+            unsigned char alpha[16];
+            std::fill(alpha, alpha + 16, (unsigned char)255);
+            if (format == TEXTURE_BC3) {
+                int palette[8] = { in[0], in[1] };
+                // high > low: 6 posrednich, inaczej 4 posrednie + 0 i 255
+                for (int i = 1; i < 7; ++i)
+                    palette[1 + i] = in[0] > in[1] ? ((7 - i) * in[0] + i * in[1]) / 7 : (i < 5 ? ((5 - i) * in[0] + i * in[1]) / 5 : (i == 5 ? 0 : 255));
+                uint64_t indices = 0;
+                for (int b = 0; b < 6; ++b)
+                    indices |= (uint64_t)in[2 + b] << (8 * b);
+                for (int i = 0; i < 16; ++i)
+                    alpha[i] = (unsigned char)palette[(indices >> (3 * i)) & 7];
+                in += 8;
+            }
+            uint16_t color0, color1;
+            uint32_t indices;
+            std::memcpy(&color0, in, 2);
+            std::memcpy(&color1, in + 2, 2);
+            std::memcpy(&indices, in + 4, 4);
+            in += 8;
+            int palette[4][4];
+            unpackColor565(color0, palette[0]);
+            unpackColor565(color1, palette[1]);
+            palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+            for (int c = 0; c < 3; ++c) {
+                // color0 <= color1 w BC1: 3 kolory + przezroczysta czern
+                if (color0 > color1 || format == TEXTURE_BC3) {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                } else {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+            if (color0 <= color1 && format == TEXTURE_BC1)
+                palette[3][3] = 0;
+            for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y) {
+                for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                    int i = y * 4 + x;
+                    const int* color = palette[(indices >> (2 * i)) & 3];
+                    unsigned char* out = pixels + (((size_t)by * 4 + y) * width + bx * 4 + x) * 4;
+                    out[0] = (unsigned char)color[0];
+                    out[1] = (unsigned char)color[1];
+                    out[2] = (unsigned char)color[2];
+                    out[3] = format == TEXTURE_BC3 ? alpha[i] : (unsigned char)color[3];
+                }
+            }
+        }
+    }
+}
+
+void compressImage(TextureImage& image) {
+    PROFILE_FUNCTION();
+    if (image.format != TEXTURE_RGBA8 || image.levels.empty())
+        return;
+    bool transparent = false;
+    for (size_t i = 3; i < image.data.size() && !transparent; i += 4)
+        transparent = image.data[i] != 255;
+    TextureFormat format = transparent ? TEXTURE_BC3 : TEXTURE_BC1;
+
+    std::vector<TextureLevel> levels(image.levels);
+    size_t total = 0;
+    for (TextureLevel& level : levels) {
+        level.offset = total;
+        level.size = textureLevelSize(format, level.width, level.height);
+        total += level.size;
+    }
+    std::vector<unsigned char> data(total);
+    for (size_t l = 0; l < levels.size(); ++l)
+        compressBlocks(&image.data[image.levels[l].offset], levels[l].width, levels[l].height, format, &data[levels[l].offset]);
+    image.format = format;
+    image.levels.swap(levels);
+    image.data.swap(data);
+}
+
+bool readTextureCache(const std::string& path, uint64_t key, TextureImage& image) {
+    PROFILE_FUNCTION();
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::streamoff fileSize = in ? (std::streamoff)in.tellg() : 0;
+    in.seekg(0);
+    TextureCacheHeader header;
+    // dane dokladnie do konca pliku - uszkodzony albo urwany wpis nie alokuje gigabajtow
+    if (!in || fileSize < (std::streamoff)sizeof(header) || !in.read((char*)&header, sizeof(header))
+        || header.magic != TEXTURE_CACHE_MAGIC || header.version != TEXTURE_CACHE_VERSION || header.key != key
+        || header.format > TEXTURE_BC3 || header.levelCount == 0 || header.levelCount > 32
+        || (uint64_t)fileSize < sizeof(header) + header.levelCount * sizeof(TextureCacheLevel)
+        || header.dataSize != (uint64_t)fileSize - sizeof(header) - header.levelCount * sizeof(TextureCacheLevel))
+        return false;
+    std::vector<TextureCacheLevel> levels(header.levelCount);
+    if (!in.read((char*)levels.data(), levels.size() * sizeof(TextureCacheLevel)))
+        return false;
+    image.format = (TextureFormat)header.format;
+    image.levels.resize(levels.size());
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const TextureCacheLevel& level = levels[l];
+        // uszkodzony plik nie moze wyprowadzic uploadu poza dane
+        if (level.size != textureLevelSize(image.format, level.width, level.height) || level.offset > header.dataSize
+            || level.size > header.dataSize - level.offset)
+            return false;
+        image.levels[l] = TextureLevel{ level.width, level.height, (size_t)level.offset, (size_t)level.size };
+    }
+    image.data.resize((size_t)header.dataSize);
+    return (bool)in.read((char*)image.data.data(), image.data.size());
+}
+
+bool writeTextureCache(const std::string& path, uint64_t key, const TextureImage& image) {
+    PROFILE_FUNCTION();
+    TextureCacheHeader header = { TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_VERSION, key, image.format,
+        (uint32_t)image.levels.size(), image.data.size() };
+    std::vector<TextureCacheLevel> levels;
+    for (const TextureLevel& level : image.levels)
+        levels.push_back(TextureCacheLevel{ level.width, level.height, level.offset, level.size });
+    // zapis do pliku tymczasowego i podmiana - przerwany zapis nie zostawia polowy wpisu pod wlasciwa nazwa
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+    bool written = out.write((const char*)&header, sizeof(header))
+        && out.write((const char*)levels.data(), levels.size() * sizeof(TextureCacheLevel))
+        && out.write((const char*)image.data.data(), image.data.size());
+    out.close();
+    // rename na Windows nie nadpisuje istniejacego pliku
+    std::remove(path.c_str());
+    if (!written || out.fail() || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "ERROR::TEXTURE_CACHE::CANNOT_WRITE " << path << std::endl;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
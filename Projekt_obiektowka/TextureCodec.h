@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// przetwarzanie obrazow na CPU, bez GL - wolane z watkow puli zadan (TextureManager.h)
+enum TextureFormat : uint32_t {
+    TEXTURE_RGBA8,
+    TEXTURE_BC1,  // 4 bity na piksel, bez przezroczystosci
+    TEXTURE_BC3,  // 8 bitow na piksel, z kanalem alfa
+};
+
+enum MipFilter : uint32_t {
+    MIP_FILTER_BOX,     // srednia 2x2 (SSE2)
+    MIP_FILTER_KAISER,  // sinc z oknem Kaisera - mniejsze poziomy ostrzejsze, bez rozmycia pudelka
+};
+
+struct TextureLevel {
+    uint32_t width, height;
+    size_t offset, size;  // zakres w TextureImage::data
+};
+
+// poziomy jeden za drugim w data, levels[0] - pelny rozmiar; pierwszy wiersz danych = v == 0 (gora obrazu)
+struct TextureImage {
+    TextureFormat format = TEXTURE_RGBA8;
+    std::vector<TextureLevel> levels;
+    std::vector<unsigned char> data;
+};
+
+size_t textureLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+// bajty jednego wiersza pikseli (RGBA8) albo wiersza blokow 4x4 (BC) i liczba takich wierszy
+size_t textureRowSize(TextureFormat format, uint32_t width);
+uint32_t textureRowCount(TextureFormat format, uint32_t height);
+
+// PNG/TGA/BMP (ImageDecoder.h), zawsze RGBA8 z jednym poziomem
+bool decodeImage(const unsigned char* encoded, size_t size, TextureImage& image);
+// dokleja mniejsze poziomy az do 1x1 (obraz RGBA8 z jednym poziomem)
+void buildMipChain(TextureImage& image, MipFilter filter);
+// RGBA8 -> BC1, albo BC3 gdy choc jeden piksel nie jest w pelni nieprzezroczysty; wszystkie poziomy
+void compressImage(TextureImage& image);
+
+// pojedyncze kroki do przetwarzania kafli poza TextureImage (VirtualTexture.h):
+// srednia 2x2 do rozmiaru width x height (polowa zrodla, w gore albo w dol) - mozna wolac na pasach wierszy
+void downsampleBox(const unsigned char* source, uint32_t sourceWidth, uint32_t sourceHeight,
+    unsigned char* target, uint32_t width, uint32_t height);
+// RGBA8 -> bloki BC1/BC3 w zadanym formacie, out ma textureLevelSize bajtow
+void compressBlocks(const unsigned char* pixels, uint32_t width, uint32_t height, TextureFormat format, unsigned char* out);
+// bloki BC1/BC3 -> RGBA8 (sterownik bez S3TC)
+void decompressBlocks(const unsigned char* blocks, uint32_t width, uint32_t height, TextureFormat format, unsigned char* pixels);
+
+// cache na dysku: naglowek, tabela poziomow, dane; key - skrot zrodla i ustawien przetwarzania
+bool readTextureCache(const std::string& path, uint64_t key, TextureImage& image);
+bool writeTextureCache(const std::string& path, uint64_t key, const TextureImage& image);
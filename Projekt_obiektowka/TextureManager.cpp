@@ -0,0 +1,417 @@
+#include "TextureManager.h"
+#include "AssetIO.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// zmiana filtrow albo kodera BC = nowe klucze, stare pliki cache przestaja pasowac
+const uint32_t TEXTURE_PIPELINE_VERSION = 1;
+const unsigned int STAGING_BUFFER_COUNT = 3;
+
+enum TextureState {
+    TEXTURE_QUEUED,     // w puli zadan
+    TEXTURE_DECODED,    // poziomy gotowe w pamieci, czeka na watek renderu
+    TEXTURE_UPLOADING,
+    TEXTURE_READY,
+    TEXTURE_SHARED,     // ta sama zawartosc co source - uzywa jej obiektu GL
+    TEXTURE_FAILED
+};
+
+struct Texture {
+    uint32_t index = 0;
+    std::string path;
+    std::vector<unsigned char> encoded;  // requestTextureFromMemory; inaczej plik przez openAsset
+    std::atomic<int> state{ TEXTURE_QUEUED };
+    uint32_t source = NO_TEXTURE;
+    TextureImage image;
+    GLuint id = 0;
+    int nextLevel = -1;    // wysylany poziom (od najmniejszego do 0)
+    uint32_t nextRow = 0;  // pierwszy niewyslany wiersz (dla BC - wiersz blokow)
+    bool usable = false;   // w GL jest co najmniej jeden pelny poziom
+};
+
+struct StagingBuffer {
+    GLuint buffer = 0;
+    size_t capacity = 0;
+    GLsync fence = nullptr;  // GPU skonczylo czytac - mozna nadpisac
+};
+
+struct TextureStats {
+    std::atomic<unsigned int> requested{ 0 };
+    std::atomic<unsigned int> shared{ 0 };
+    std::atomic<unsigned int> cacheHits{ 0 };
+    std::atomic<unsigned int> decoded{ 0 };
+    std::atomic<unsigned int> failed{ 0 };
+    std::atomic<uint64_t> workerMicros{ 0 };
+    uint64_t uploadedBytes = 0;
+    unsigned int busyFrames = 0;  // nastepny bufor posredni jeszcze czytany przez GPU
+};
+
+static TextureConfig textureConfig;
+static bool compressTextures = false;
+static std::vector<std::unique_ptr<Texture>> textures;
+static std::unordered_map<std::string, uint32_t> texturesByPath;
+// skrot zawartosci -> pierwsza tekstura z taka zawartoscia (zadania w puli)
+static std::mutex hashMutex;
+static std::unordered_map<uint64_t, uint32_t> texturesByHash;
+static std::vector<uint32_t> uploadQueue;
+static StagingBuffer stagingBuffers[STAGING_BUFFER_COUNT];
+static unsigned int nextStaging = 0;
+static GLuint whiteTexture = 0;
+static JobCounter textureJobs;
+static TextureStats textureStats;
+
+static void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+static uint64_t contentHash(const unsigned char* data, size_t size) {
+    // FNV-1a po slowach 32-bitowych, reszta po bajcie
+    uint64_t hash = (0xCBF29CE484222325ULL ^ (uint64_t)size) * 0x100000001B3ULL;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        uint32_t word;
+        std::memcpy(&word, data + i, 4);
+        hash = (hash ^ word) * 0x100000001B3ULL;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+static std::string cachePath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)key);
+    return textureConfig.cacheDirectory + "/" + name;
+}
+
+static GLenum internalFormat(TextureFormat format) {
+    switch (format) {
+    case TEXTURE_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXTURE_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    default: return GL_RGBA8;
+    }
+}
+
+// zadanie w puli: plik -> skrot -> (cache albo dekodowanie + mipy + kompresja) -> DECODED
+static void processTexture(void* data, size_t, size_t) {
+    PROFILE_FUNCTION();
+    Texture& texture = *static_cast<Texture*>(data);
+    auto start = std::chrono::steady_clock::now();
+    AssetData asset;
+    const unsigned char* bytes = texture.encoded.data();
+    size_t size = texture.encoded.size();
+    if (texture.encoded.empty()) {
+        if (!openAsset(texture.path, asset)) {
+            std::cerr << "ERROR::TEXTURE::CANNOT_OPEN " << texture.path << std::endl;
+            textureStats.failed++;
+            texture.state.store(TEXTURE_FAILED, std::memory_order_release);
+            return;
+        }
+        bytes = asset.data;
+        size = asset.size;
+    }
+
+    uint64_t hash = contentHash(bytes, size);
+    bool duplicate = false;
+    {
+        std::lock_guard<std::mutex> lock(hashMutex);
+        auto found = texturesByHash.find(hash);
+        duplicate = found != texturesByHash.end();
+        if (duplicate)
+            texture.source = found->second;
+        else
+            texturesByHash[hash] = texture.index;
+    }
+
+    bool ok = duplicate;
+    if (!duplicate) {
+        uint64_t key = hash;
+        uint32_t settings[3] = { TEXTURE_PIPELINE_VERSION, textureConfig.filter, compressTextures ? 1u : 0u };
+        for (uint32_t setting : settings)
+            key = (key ^ setting) * 0x100000001B3ULL;
+        bool cached = !textureConfig.cacheDirectory.empty() && readTextureCache(cachePath(key), key, texture.image);
+        if (cached) {
+            textureStats.cacheHits++;
+            ok = true;
+        } else {
+            ok = decodeImage(bytes, size, texture.image);
+            if (ok) {
+                buildMipChain(texture.image, textureConfig.filter);
+                if (compressTextures)
+                    compressImage(texture.image);
+                if (!textureConfig.cacheDirectory.empty())
+                    writeTextureCache(cachePath(key), key, texture.image);
+                textureStats.decoded++;
+            }
+        }
+    }
+    if (asset.data)
+        closeAsset(asset);
+    std::vector<unsigned char>().swap(texture.encoded);
+    textureStats.workerMicros += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (duplicate) {
+        textureStats.shared++;
+        texture.state.store(TEXTURE_SHARED, std::memory_order_release);
+    } else if (!ok) {
+        std::cerr << "ERROR::TEXTURE::DECODE_FAILED " << texture.path << std::endl;
+        textureStats.failed++;
+        texture.state.store(TEXTURE_FAILED, std::memory_order_release);
+    } else {
+        texture.state.store(TEXTURE_DECODED, std::memory_order_release);
+    }
+}
+
+void initTextureManager(const TextureConfig& config) {
+    textureConfig = config;
+    compressTextures = config.compress && GLAD_GL_EXT_texture_compression_s3tc;
+    if (config.compress && !compressTextures)
+        std::cerr << "ERROR::TEXTURE::NO_S3TC - textures stay uncompressed" << std::endl;
+    if (!config.cacheDirectory.empty())
+        makeDirectory(config.cacheDirectory);
+
+    const unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &whiteTexture);
+    glBindTexture(GL_TEXTURE_2D, whiteTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void shutdownTextureManager() {
+    // zadania trzymaja wskazniki na Texture
+    waitForCounter(textureJobs);
+    for (const std::unique_ptr<Texture>& texture : textures) {
+        if (texture->id)
+            glDeleteTextures(1, &texture->id);
+    }
+    for (StagingBuffer& staging : stagingBuffers) {
+        if (staging.fence)
+            glDeleteSync(staging.fence);
+        if (staging.buffer)
+            glDeleteBuffers(1, &staging.buffer);
+        staging = StagingBuffer();
+    }
+    if (whiteTexture)
+        glDeleteTextures(1, &whiteTexture);
+    whiteTexture = 0;
+    textures.clear();
+    texturesByPath.clear();
+    texturesByHash.clear();
+    uploadQueue.clear();
+}
+
+static uint32_t addTexture(const std::string& name, const unsigned char* data, size_t size) {
+    auto found = texturesByPath.find(name);
+    if (found != texturesByPath.end())
+        return found->second;
+    uint32_t index = (uint32_t)textures.size();
+    textures.emplace_back(new Texture());
+    Texture& texture = *textures.back();
+    texture.index = index;
+    texture.path = name;
+    if (data)
+        texture.encoded.assign(data, data + size);
+    texturesByPath[name] = index;
+    uploadQueue.push_back(index);
+    textureStats.requested++;
+    runJob(&processTexture, &texture, 0, 1, &textureJobs);
+    return index;
+}
+
+uint32_t requestTexture(const std::string& path) {
+    return addTexture(path, nullptr, 0);
+}
+
+uint32_t requestTextureFromMemory(const std::string& name, const unsigned char* data, size_t size) {
+    if (!data || size == 0)
+        return NO_TEXTURE;
+    return addTexture(name, data, size);
+}
+
+// wszystkie poziomy zaalokowane od razu, widoczny dopiero najmniejszy wyslany (BASE_LEVEL)
+static void createTextureObject(Texture& texture) {
+    const TextureImage& image = texture.image;
+    GLenum format = internalFormat(image.format);
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    for (size_t l = 0; l < image.levels.size(); ++l) {
+        const TextureLevel& level = image.levels[l];
+        if (image.format == TEXTURE_RGBA8)
+            glTexImage2D(GL_TEXTURE_2D, (GLint)l, format, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        else
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)l, format, level.width, level.height, 0, (GLsizei)level.size, nullptr);
+    }
+    GLint lastLevel = (GLint)image.levels.size() - 1;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    texture.nextLevel = lastLevel;
+    texture.nextRow = 0;
+}
+
+// fragment poziomu skopiowany do bufora posredniego
+struct StagedUpload {
+    Texture* texture;
+    int level;
+    uint32_t row, rows;
+    size_t offset;
+};
+
+void updateTextures() {
+    if (uploadQueue.empty())
+        return;
+    PROFILE_FUNCTION();
+    for (uint32_t index : uploadQueue) {
+        Texture& texture = *textures[index];
+        if (texture.state.load(std::memory_order_acquire) == TEXTURE_DECODED) {
+            createTextureObject(texture);
+            texture.state.store(TEXTURE_UPLOADING, std::memory_order_relaxed);
+        }
+    }
+
+    StagingBuffer& staging = stagingBuffers[nextStaging];
+    if (staging.fence) {
+        // bez czekania - ten bufor wroci w ktorejs z nastepnych klatek
+        if (glClientWaitSync(staging.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            textureStats.busyFrames++;
+            return;
+        }
+        glDeleteSync(staging.fence);
+        staging.fence = nullptr;
+    }
+    if (!staging.buffer)
+        glGenBuffers(1, &staging.buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+    if (staging.capacity < textureConfig.uploadBytesPerFrame) {
+        staging.capacity = textureConfig.uploadBytesPerFrame;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, staging.capacity, nullptr, GL_STREAM_DRAW);
+    }
+
+    FrameVector<StagedUpload> uploads;
+    unsigned char* mapped = nullptr;
+    size_t used = 0;
+    bool full = false;
+    for (size_t q = 0; q < uploadQueue.size() && !full; ++q) {
+        Texture& texture = *textures[uploadQueue[q]];
+        if (texture.state.load(std::memory_order_relaxed) != TEXTURE_UPLOADING)
+            continue;
+        while (texture.nextLevel >= 0) {
+            const TextureLevel& level = texture.image.levels[texture.nextLevel];
+            size_t rowSize = textureRowSize(texture.image.format, level.width);
+            uint32_t rowCount = textureRowCount(texture.image.format, level.height);
+            if (rowSize > staging.capacity && used == 0) {
+                // wiersz szerszy niz caly bufor - ten bufor rosnie (jeszcze nic w nim nie ma)
+                staging.capacity = rowSize;
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, staging.capacity, nullptr, GL_STREAM_DRAW);
+            }
+            uint32_t rows = (uint32_t)std::min<size_t>(rowCount - texture.nextRow, (staging.capacity - used) / rowSize);
+            if (rows == 0) {
+                full = true;
+                break;
+            }
+            if (!mapped) {
+                mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, staging.capacity,
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                if (!mapped) {
+                    std::cerr << "ERROR::TEXTURE::CANNOT_MAP_STAGING_BUFFER" << std::endl;
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                    return;
+                }
+            }
+            std::memcpy(mapped + used, &texture.image.data[level.offset + texture.nextRow * rowSize], rows * rowSize);
+            uploads.push_back({ &texture, texture.nextLevel, texture.nextRow, rows, used });
+            used += rows * rowSize;
+            texture.nextRow += rows;
+            if (texture.nextRow == rowCount) {
+                texture.nextLevel--;
+                texture.nextRow = 0;
+            }
+        }
+    }
+    if (mapped)
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // przy zbindowanym PBO wskaznik danych to przesuniecie w buforze - kopia do tekstury idzie po stronie GPU
+    for (const StagedUpload& upload : uploads) {
+        Texture& texture = *upload.texture;
+        const TextureLevel& level = texture.image.levels[upload.level];
+        uint32_t rowHeight = texture.image.format == TEXTURE_RGBA8 ? 1 : 4;
+        uint32_t y = upload.row * rowHeight;
+        uint32_t height = std::min(upload.rows * rowHeight, level.height - y);
+        size_t bytes = upload.rows * textureRowSize(texture.image.format, level.width);
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        if (texture.image.format == TEXTURE_RGBA8)
+            glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, y, level.width, height, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)upload.offset);
+        else
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, y, level.width, height,
+                internalFormat(texture.image.format), (GLsizei)bytes, (const void*)upload.offset);
+        textureStats.uploadedBytes += bytes;
+        if (y + height == level.height) {
+            // pelny poziom - od teraz probkowany; poziom 0 konczy teksture
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, upload.level);
+            texture.usable = true;
+            if (upload.level == 0) {
+                texture.image = TextureImage();
+                texture.state.store(TEXTURE_READY, std::memory_order_relaxed);
+            }
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (used) {
+        staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextStaging = (nextStaging + 1) % STAGING_BUFFER_COUNT;
+    }
+
+    uploadQueue.erase(std::remove_if(uploadQueue.begin(), uploadQueue.end(), [](uint32_t index) {
+        int state = textures[index]->state.load(std::memory_order_acquire);
+        return state == TEXTURE_READY || state == TEXTURE_SHARED || state == TEXTURE_FAILED;
+    }), uploadQueue.end());
+}
+
+GLuint textureId(uint32_t texture) {
+    while (texture < textures.size()) {
+        const Texture& current = *textures[texture];
+        if (current.state.load(std::memory_order_acquire) != TEXTURE_SHARED)
+            return current.usable ? current.id : whiteTexture;
+        texture = current.source;
+    }
+    return whiteTexture;
+}
+
+void printTextureReport() {
+    if (textureStats.requested == 0)
+        return;
+    std::cout << "Textures: " << textureStats.requested << " requested, " << textureStats.shared
+        << " shared with identical images, " << textureStats.cacheHits << " from cache, " << textureStats.decoded
+        << " decoded, " << textureStats.failed << " failed, " << textureStats.workerMicros / 1000 << " ms on workers, "
+        << textureStats.uploadedBytes / (1024 * 1024) << " MB uploaded, " << textureStats.busyFrames
+        << " frames waited for a staging buffer" << std::endl;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "TextureCodec.h"
+
+// uchwyt tekstury (indeks), Mesh::texture == NO_TEXTURE - siatka bez tekstury
+const uint32_t NO_TEXTURE = 0xFFFFFFFF;
+
+struct TextureConfig {
+    MipFilter filter = MIP_FILTER_BOX;
+    bool compress = false;                         // BC1/BC3, jesli sterownik ma GL_EXT_texture_compression_s3tc
+    std::string cacheDirectory;                    // gotowe poziomy (po mipach i kompresji), puste - bez cache
+    size_t uploadBytesPerFrame = 4 * 1024 * 1024;  // rozmiar kazdego bufora posredniego = limit wysylki na klatke
+};
+
+// dekodowanie, mipy i kompresja w puli zadan; watek renderu tylko kopiuje gotowe poziomy do buforow PBO
+// (pierscien z fence'ami - zajety bufor to pominieta klatka, nie czekanie) i zleca glTexSubImage2D z nich.
+// Poziomy ida od najmniejszego - tekstura jest uzywalna (GL_TEXTURE_BASE_LEVEL) zanim dojdzie pelny rozmiar
+void initTextureManager(const TextureConfig& config);
+void shutdownTextureManager();
+
+// uchwyt od razu, obraz w tle; ta sama sciezka albo identyczna zawartosc pliku = ta sama tekstura GL
+uint32_t requestTexture(const std::string& path);
+// obraz zakodowany w pamieci (osadzony w .glb, data URI) - bajty sa kopiowane, name rozpoznaje powtorzenia
+uint32_t requestTextureFromMemory(const std::string& name, const unsigned char* data, size_t size);
+// raz na klatke, watek renderu
+void updateTextures();
+// do zbindowania; dopoki nie ma choc najmniejszego poziomu (i dla NO_TEXTURE) - biala 1x1
+GLuint textureId(uint32_t texture);
+
+void printTextureReport();
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+// bufor potrojny: jeden pisarz (symulacja), jeden czytelnik (render),
+// zadna ze stron nie czeka na druga - wymiana to pojedynczy atomic exchange
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), backIndex(0), frontIndex(2) {}
+
+    // bufor do zapisu - nalezy tylko do watku symulacji
+    T& writeBuffer() { return slots[backIndex].value; }
+
+    // oddaj zapisany bufor czytelnikowi, dostajemy z powrotem wolny
+    void publish() {
+        unsigned int previous = middle.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // pobierz najnowszy opublikowany stan (jesli jest nowy), zwraca true gdy sie zmienil
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+        unsigned int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    // bufor do odczytu - nalezy tylko do watku renderu
+    const T& readBuffer() const { return slots[frontIndex].value; }
+
+private:
+    static constexpr unsigned int INDEX_MASK = 0x3;
+    static constexpr unsigned int FRESH_BIT = 0x4;
+
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    Slot slots[3];
+    alignas(64) std::atomic<unsigned int> middle;
+    alignas(64) unsigned int backIndex;
+    alignas(64) unsigned int frontIndex;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// numery atrybutow - te same co layout(location) w shaders/vertex.glsl
+enum VertexAttribute : GLuint {
+    ATTRIBUTE_POSITION = 0,
+    ATTRIBUTE_NORMAL = 1,
+    ATTRIBUTE_TEXCOORD = 2,
+    ATTRIBUTE_INSTANCE_MODEL = 3,
+};
+
+// kazdy strumien w osobnym, ciasno upakowanym VBO (Mesh::VBO[slot])
+enum VertexStreamSlot {
+    STREAM_POSITION,
+    STREAM_NORMAL,
+    STREAM_TEXCOORD,
+    VERTEX_STREAM_COUNT
+};
+
+// zestawy strumieni = osobne VAO siatki (Mesh::VAO[layout]); przebieg wybiera najmniejszy, ktory mu wystarcza
+enum MeshLayout {
+    LAYOUT_SHADED,         // pozycje + normalne
+    LAYOUT_POSITION_ONLY,  // glebokosc, czujniki, shader bez oswietlenia
+    LAYOUT_TEXTURED,       // pozycje + normalne + UV (siatka bez UV - jak LAYOUT_SHADED, atrybut UV wylaczony)
+    MESH_LAYOUT_COUNT
+};
+
+// typ C++ -> format atrybutu GL
+template <typename T> struct VertexFormat;
+
+template <> struct VertexFormat<glm::vec2> {
+    static const GLint components = 2;
+    static const GLenum type = GL_FLOAT;
+    static const GLboolean normalized = GL_FALSE;
+};
+
+template <> struct VertexFormat<glm::vec3> {
+    static const GLint components = 3;
+    static const GLenum type = GL_FLOAT;
+    static const GLboolean normalized = GL_FALSE;
+};
+
+template <> struct VertexFormat<glm::vec4> {
+    static const GLint components = 4;
+    static const GLenum type = GL_FLOAT;
+    static const GLboolean normalized = GL_FALSE;
+};
+
+template <VertexStreamSlot Slot, GLuint Location, typename T>
+struct VertexStream {
+    typedef T Element;
+    static const VertexStreamSlot slot = Slot;
+    static const GLuint location = Location;
+};
+
+typedef VertexStream<STREAM_POSITION, ATTRIBUTE_POSITION, glm::vec3> PositionStream;
+typedef VertexStream<STREAM_NORMAL, ATTRIBUTE_NORMAL, glm::vec3> NormalStream;
+typedef VertexStream<STREAM_TEXCOORD, ATTRIBUTE_TEXCOORD, glm::vec2> TexCoordStream;
+
+// data moze wskazywac prosto w zmapowany plik - GL kopiuje od razu
+template <typename Stream>
+void uploadVertexStream(const GLuint* buffers, const typename Stream::Element* data, size_t count) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[Stream::slot]);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(typename Stream::Element), data, GL_STATIC_DRAW);
+}
+
+// wywolywac przy zbindowanym VAO
+template <typename Stream>
+void bindVertexStream(const GLuint* buffers) {
+    typedef VertexFormat<typename Stream::Element> Format;
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[Stream::slot]);
+    glVertexAttribPointer(Stream::location, Format::components, Format::type, Format::normalized,
+        sizeof(typename Stream::Element), (void*)0);
+    glEnableVertexAttribArray(Stream::location);
+}
+
+template <typename... Streams>
+struct VertexLayout {
+    static void bind(const GLuint* buffers) {
+        int expand[] = { 0, (bindVertexStream<Streams>(buffers), 0)... };
+        (void)expand;
+    }
+};
+
+typedef VertexLayout<PositionStream, NormalStream> ShadedLayout;
+typedef VertexLayout<PositionStream> PositionOnlyLayout;
+typedef VertexLayout<PositionStream, NormalStream, TexCoordStream> TexturedLayout;
+
+// macierz na instancje (divisor 1): kolumny w kolejnych lokacjach od location, bufor instancji musi byc zbindowany
+inline void bindInstanceMatrix(GLuint location, size_t offset) {
+    typedef VertexFormat<glm::vec4> Format;
+    for (GLuint column = 0; column < 4; ++column) {
+        glVertexAttribPointer(location + column, Format::components, Format::type, Format::normalized,
+            sizeof(glm::mat4), (void*)(offset + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location + column);
+        glVertexAttribDivisor(location + column, 1);
+    }
+}
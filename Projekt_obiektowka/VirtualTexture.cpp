@@ -0,0 +1,586 @@
+#include "VirtualTexture.h"
+#include "Profiler.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+const unsigned int READBACK_COUNT = 3;
+const glm::uvec4 CLEAN_RECT(UINT_MAX, UINT_MAX, 0, 0);
+
+static uint32_t nextPowerOfTwo(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+// mip indirekcji - strony poziomu 0 zaokraglone do potegi 2, dzielone az do 1x1
+static uint32_t indirectionLevelWidth(const VirtualTexture& texture, uint32_t level) {
+    return std::max(1u, texture.indirectionWidth >> level);
+}
+
+static uint32_t indirectionLevelHeight(const VirtualTexture& texture, uint32_t level) {
+    return std::max(1u, texture.indirectionHeight >> level);
+}
+
+// bajty w kolejnosci RGBA tekstury GL_RGBA8UI
+static uint32_t packEntry(const VirtualTexture& texture, uint32_t slot, uint32_t level) {
+    uint32_t atlasTiles = texture.config.atlasTiles;
+    return (slot % atlasTiles) | (slot / atlasTiles) << 8 | level << 16 | 1u << 24;
+}
+
+static uint32_t entryLevel(uint32_t entry) {
+    return (entry >> 16) & 0xFF;
+}
+
+static bool entryValid(uint32_t entry) {
+    return (entry >> 24) != 0;
+}
+
+static uint32_t tileLevel(const VirtualTexture& texture, uint32_t tile) {
+    uint32_t level = 0;
+    while (level + 1 < texture.levels.size() && tile >= texture.levels[level + 1].firstTile)
+        ++level;
+    return level;
+}
+
+static void markDirty(VirtualTexture& texture, uint32_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    glm::uvec4& rect = texture.dirty[level];
+    rect = glm::uvec4(std::min(rect.x, x0), std::min(rect.y, y0), std::max(rect.z, x1), std::max(rect.w, y1));
+}
+
+// zakres stron poziomu level pod kaflem (tileLevel, x, y); zwraca false, gdy pusty
+static bool tileFootprint(const VirtualTexture& texture, uint32_t tileLevel, uint32_t x, uint32_t y, uint32_t level,
+    uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1) {
+    uint32_t shift = tileLevel - level;
+    x0 = x << shift;
+    y0 = y << shift;
+    x1 = std::min(indirectionLevelWidth(texture, level), (x + 1) << shift);
+    y1 = std::min(indirectionLevelHeight(texture, level), (y + 1) << shift);
+    return x0 < x1 && y0 < y1;
+}
+
+// nowy kafel zastepuje grubsze wpisy pod soba na swoim i wszystkich drobniejszych poziomach
+static void mapTile(VirtualTexture& texture, uint32_t tile, uint32_t slot) {
+    uint32_t level = tileLevel(texture, tile);
+    const VirtualTextureLevel& info = texture.levels[level];
+    uint32_t index = tile - info.firstTile, tileX = index % info.pagesX, tileY = index / info.pagesX;
+    uint32_t entry = packEntry(texture, slot, level);
+    for (int l = (int)level; l >= 0; --l) {
+        uint32_t x0, y0, x1, y1;
+        if (!tileFootprint(texture, level, tileX, tileY, l, x0, y0, x1, y1))
+            continue;
+        uint32_t width = indirectionLevelWidth(texture, l);
+        for (uint32_t y = y0; y < y1; ++y) {
+            uint32_t* row = &texture.indirection[l][(size_t)y * width];
+            for (uint32_t x = x0; x < x1; ++x) {
+                if (!entryValid(row[x]) || entryLevel(row[x]) >= level)
+                    row[x] = entry;
+            }
+        }
+        markDirty(texture, l, x0, y0, x1, y1);
+    }
+}
+
+// wpisy wskazujace usuwany kafel przejmuja wpis rodzica (najdrobniejszy wczytany kafel nad nim)
+static void unmapTile(VirtualTexture& texture, uint32_t tile) {
+    uint32_t level = tileLevel(texture, tile);
+    if (level + 1 >= texture.levels.size())
+        return;
+    const VirtualTextureLevel& info = texture.levels[level];
+    uint32_t index = tile - info.firstTile, tileX = index % info.pagesX, tileY = index / info.pagesX;
+    uint32_t parent = texture.indirection[level + 1][(size_t)(tileY >> 1) * indirectionLevelWidth(texture, level + 1) + (tileX >> 1)];
+    for (int l = (int)level; l >= 0; --l) {
+        uint32_t x0, y0, x1, y1;
+        if (!tileFootprint(texture, level, tileX, tileY, l, x0, y0, x1, y1))
+            continue;
+        uint32_t width = indirectionLevelWidth(texture, l);
+        for (uint32_t y = y0; y < y1; ++y) {
+            uint32_t* row = &texture.indirection[l][(size_t)y * width];
+            for (uint32_t x = x0; x < x1; ++x) {
+                if (entryValid(row[x]) && entryLevel(row[x]) == level)
+                    row[x] = parent;
+            }
+        }
+        markDirty(texture, l, x0, y0, x1, y1);
+    }
+}
+
+// zadanie w puli: kopia kafla ze zmapowanego pliku (tu system czyta z dysku, nie na watku renderu),
+// BC1 rozpakowywane do RGBA8, gdy sterownik nie ma S3TC
+static void loadTile(void* data, size_t, size_t) {
+    PROFILE_FUNCTION();
+    VirtualTileLoad& load = *static_cast<VirtualTileLoad*>(data);
+    int expected = TILE_LOAD_QUEUED;
+    if (!load.state.compare_exchange_strong(expected, TILE_LOAD_RUNNING, std::memory_order_acquire)) {
+        // anulowane zanim zadanie ruszylo - tylko zwolnienie miejsca
+        load.state.store(TILE_LOAD_FREE, std::memory_order_release);
+        return;
+    }
+    const VirtualTexture& texture = *load.texture;
+    const unsigned char* source = texture.asset.data + texture.header.dataOffset + (size_t)load.tile * texture.header.tileBytes;
+    if (texture.atlasFormat == (TextureFormat)texture.header.format)
+        std::memcpy(load.pixels.data(), source, texture.tileDataSize);
+    else
+        decompressBlocks(source, texture.physicalSize, texture.physicalSize, TEXTURE_BC1, load.pixels.data());
+    load.state.store(TILE_LOAD_DONE, std::memory_order_release);
+}
+
+bool loadVirtualTextureLayout(VirtualTexture& texture, const std::string& path, const VirtualTextureConfig& config) {
+    texture.config = config;
+    texture.config.atlasTiles = std::max(2u, std::min(256u, config.atlasTiles));
+    texture.config.loadsInFlight = std::max(1u, config.loadsInFlight);
+    texture.config.feedbackDivisor = std::max(1u, config.feedbackDivisor);
+    if (!openAsset(path, texture.asset)) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    VirtualTextureHeader& header = texture.header;
+    bool valid = texture.asset.size >= sizeof(header);
+    if (valid)
+        std::memcpy(&header, texture.asset.data, sizeof(header));
+    // tileSize i border ograniczone, zeby bok kafla z ramka nie przepelnil uint32
+    valid = valid && header.tileSize > 0 && header.tileSize <= VT_MAX_TILE_SIZE && header.border <= header.tileSize;
+    uint32_t physical = valid ? header.tileSize + 2 * header.border : 0;
+    // obraz musi wypelniac strony: ostatnia kolumna i ostatni wiersz stron nie moga byc puste
+    valid = valid && std::memcmp(header.magic, "DVTX", 4) == 0 && header.version == VIRTUAL_TEXTURE_VERSION
+        && (header.format == TEXTURE_RGBA8 || header.format == TEXTURE_BC1) && physical % 4 == 0
+        && header.levelCount > 0 && header.levelCount <= 24 && header.pagesX > 0 && header.pagesY > 0
+        && header.width > 0 && header.height > 0
+        && header.width <= (uint64_t)header.pagesX * header.tileSize && header.width > (uint64_t)(header.pagesX - 1) * header.tileSize
+        && header.height <= (uint64_t)header.pagesY * header.tileSize && header.height > (uint64_t)(header.pagesY - 1) * header.tileSize
+        && header.tileBytes >= textureLevelSize((TextureFormat)header.format, physical, physical);
+    texture.indirectionWidth = valid ? nextPowerOfTwo(header.pagesX) : 0;
+    texture.indirectionHeight = valid ? nextPowerOfTwo(header.pagesY) : 0;
+    valid = valid && (1u << (header.levelCount - 1)) == std::max(texture.indirectionWidth, texture.indirectionHeight);
+    uint64_t tileCount = 0;
+    texture.levels.clear();
+    for (uint32_t l = 0; valid && l < header.levelCount; ++l) {
+        uint32_t pagesX = (header.pagesX + (1u << l) - 1) >> l, pagesY = (header.pagesY + (1u << l) - 1) >> l;
+        texture.levels.push_back({ pagesX, pagesY, (uint32_t)tileCount });
+        tileCount += (uint64_t)pagesX * pagesY;
+    }
+    // tileCount < 2^32 i tileBytes < 2^32 - iloczyn miesci sie w uint64, suma z dataOffset juz nie musi
+    valid = valid && tileCount < VT_LOADING && header.dataOffset >= sizeof(header) && header.dataOffset <= texture.asset.size
+        && tileCount * header.tileBytes <= texture.asset.size - header.dataOffset;
+    if (!valid) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::INVALID_FILE " << path << std::endl;
+        closeAsset(texture.asset);
+        return false;
+    }
+
+    // bez S3TC kafle BC1 sa rozpakowywane w zadaniach - atlas RGBA8
+    texture.atlasFormat = header.format == TEXTURE_BC1 && GLAD_GL_EXT_texture_compression_s3tc ? TEXTURE_BC1 : TEXTURE_RGBA8;
+    texture.physicalSize = physical;
+    texture.tileDataSize = textureLevelSize(texture.atlasFormat, physical, physical);
+    texture.tileSlots.assign((size_t)tileCount, VT_NOT_RESIDENT);
+    texture.tileRequested.assign((size_t)tileCount, 0);
+    texture.slots.assign((size_t)texture.config.atlasTiles * texture.config.atlasTiles, VirtualTextureSlot());
+    texture.requests.clear();
+    texture.requests.reserve(1024);
+    texture.loads.reset(new VirtualTileLoad[texture.config.loadsInFlight]);
+    for (uint32_t i = 0; i < texture.config.loadsInFlight; ++i) {
+        texture.loads[i].texture = &texture;
+        texture.loads[i].pixels.resize(texture.tileDataSize);
+    }
+    texture.frame = 0;
+    texture.indirection.assign(header.levelCount, std::vector<uint32_t>());
+    texture.dirty.assign(header.levelCount, CLEAN_RECT);
+    for (uint32_t l = 0; l < header.levelCount; ++l)
+        texture.indirection[l].assign((size_t)indirectionLevelWidth(texture, l) * indirectionLevelHeight(texture, l), 0);
+    texture.stats = VirtualTextureStats();
+    return true;
+}
+
+// wolny slot albo najdawniej widziany kafel spoza ostatniego feedbacku; VT_NOT_RESIDENT - atlas pelny widocznych
+static uint32_t findSlot(const VirtualTexture& texture) {
+    uint32_t best = VT_NOT_RESIDENT;
+    for (uint32_t s = 0; s < texture.slots.size(); ++s) {
+        const VirtualTextureSlot& slot = texture.slots[s];
+        if (slot.tile == VT_NOT_RESIDENT)
+            return s;
+        if (slot.pinned || slot.lastUsed >= texture.frame)
+            continue;
+        if (best == VT_NOT_RESIDENT || slot.lastUsed < texture.slots[best].lastUsed)
+            best = s;
+    }
+    return best;
+}
+
+static void placeTile(VirtualTexture& texture, uint32_t tile, const unsigned char* pixels) {
+    uint32_t slot = findSlot(texture);
+    if (slot == VT_NOT_RESIDENT) {
+        texture.tileSlots[tile] = VT_NOT_RESIDENT;
+        texture.stats.dropped++;
+        return;
+    }
+    VirtualTextureSlot& target = texture.slots[slot];
+    if (target.tile != VT_NOT_RESIDENT) {
+        unmapTile(texture, target.tile);
+        texture.tileSlots[target.tile] = VT_NOT_RESIDENT;
+        texture.stats.evicted++;
+    }
+    uint32_t physical = texture.physicalSize;
+    GLint x = (GLint)((slot % texture.config.atlasTiles) * physical), y = (GLint)((slot / texture.config.atlasTiles) * physical);
+    if (texture.atlasFormat == TEXTURE_RGBA8)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, physical, physical, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    else
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, physical, physical, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+            (GLsizei)texture.tileDataSize, pixels);
+    texture.stats.uploadedBytes += texture.tileDataSize;
+    texture.stats.loaded++;
+    // kafel, ktory przestal byc widoczny w trakcie wczytywania, idzie pierwszy do wymiany
+    target.tile = tile;
+    target.lastUsed = texture.tileRequested[tile];
+    texture.tileSlots[tile] = slot;
+    mapTile(texture, tile, slot);
+}
+
+static void uploadIndirection(VirtualTexture& texture) {
+    bool bound = false;
+    for (uint32_t l = 0; l < texture.dirty.size(); ++l) {
+        glm::uvec4& rect = texture.dirty[l];
+        if (rect.x >= rect.z)
+            continue;
+        if (!bound) {
+            glBindTexture(GL_TEXTURE_2D, texture.indirectionTexture);
+            bound = true;
+        }
+        uint32_t width = indirectionLevelWidth(texture, l);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)width);
+        glTexSubImage2D(GL_TEXTURE_2D, (GLint)l, rect.x, rect.y, rect.z - rect.x, rect.w - rect.y, GL_RGBA_INTEGER,
+            GL_UNSIGNED_BYTE, &texture.indirection[l][(size_t)rect.y * width + rect.x]);
+        rect = CLEAN_RECT;
+    }
+    if (bound) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+static float groundDepth(const VirtualTexture& texture) {
+    return texture.config.groundSize * texture.header.height / texture.header.width;
+}
+
+glm::vec4 virtualTextureGroundSphere(const VirtualTexture& texture) {
+    float width = texture.config.groundSize, depth = groundDepth(texture);
+    return glm::vec4(0.0f, texture.config.groundHeight, 0.0f, 0.5f * std::sqrt(width * width + depth * depth));
+}
+
+bool openVirtualTexture(VirtualTexture& texture, const std::string& path, const VirtualTextureConfig& config) {
+    PROFILE_FUNCTION();
+    if (!loadVirtualTextureLayout(texture, path, config))
+        return false;
+    const VirtualTextureHeader& header = texture.header;
+
+    // bok atlasu w limicie sterownika - mniej kafli w atlasie zamiast bledu GL przy alokacji
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    uint32_t maxAtlasTiles = (uint32_t)std::max(0, maxTextureSize) / texture.physicalSize;
+    if (maxAtlasTiles < 2) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::TILE_TOO_LARGE " << texture.physicalSize << " > GL_MAX_TEXTURE_SIZE / 2 ("
+            << maxTextureSize << ") " << path << std::endl;
+        closeVirtualTexture(texture);
+        return false;
+    }
+    if (texture.config.atlasTiles > maxAtlasTiles) {
+        std::cerr << "Virtual texture: atlas clamped to " << maxAtlasTiles << "x" << maxAtlasTiles
+            << " tiles (GL_MAX_TEXTURE_SIZE " << maxTextureSize << ")" << std::endl;
+        texture.config.atlasTiles = maxAtlasTiles;
+        texture.slots.assign((size_t)maxAtlasTiles * maxAtlasTiles, VirtualTextureSlot());
+    }
+
+    // atlas bez mipow - poziom wybiera shader, ramka kafla wystarcza filtrowaniu dwuliniowemu
+    GLsizei atlasSize = (GLsizei)(texture.config.atlasTiles * texture.physicalSize);
+    glGenTextures(1, &texture.atlas);
+    glBindTexture(GL_TEXTURE_2D, texture.atlas);
+    if (texture.atlasFormat == TEXTURE_RGBA8)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    else
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, atlasSize, atlasSize, 0,
+            (GLsizei)textureLevelSize(TEXTURE_BC1, atlasSize, atlasSize), nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &texture.indirectionTexture);
+    glBindTexture(GL_TEXTURE_2D, texture.indirectionTexture);
+    for (uint32_t l = 0; l < header.levelCount; ++l) {
+        glTexImage2D(GL_TEXTURE_2D, (GLint)l, GL_RGBA8UI, indirectionLevelWidth(texture, l), indirectionLevelHeight(texture, l),
+            0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)header.levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // najgrubszy kafel (ostatni w pliku) od razu i na stale - kazda strona ma od poczatku jakis wpis
+    VirtualTileLoad& load = texture.loads[0];
+    load.tile = (uint32_t)texture.tileSlots.size() - 1;
+    load.state.store(TILE_LOAD_QUEUED, std::memory_order_relaxed);
+    loadTile(&load, 0, 1);
+    glBindTexture(GL_TEXTURE_2D, texture.atlas);
+    placeTile(texture, load.tile, load.pixels.data());
+    texture.slots[texture.tileSlots[load.tile]].pinned = true;
+    load.state.store(TILE_LOAD_FREE, std::memory_order_relaxed);
+    uploadIndirection(texture);
+
+    // ziemia: jeden prostokat, UV w przestrzeni stron zaokraglonych do potegi 2 (obraz zajmuje ich czesc)
+    float width = texture.config.groundSize, depth = groundDepth(texture);
+    float y = texture.config.groundHeight;
+    float u = (float)header.width / (texture.indirectionWidth * header.tileSize);
+    float v = (float)header.height / (texture.indirectionHeight * header.tileSize);
+    const glm::vec3 positions[4] = { { -0.5f * width, y, -0.5f * depth }, { 0.5f * width, y, -0.5f * depth },
+        { 0.5f * width, y, 0.5f * depth }, { -0.5f * width, y, 0.5f * depth } };
+    const glm::vec3 normals[4] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 1, 0 }, { 0, 1, 0 } };
+    const glm::vec2 texcoords[4] = { { 0, 0 }, { u, 0 }, { u, v }, { 0, v } };
+    const unsigned int indices[6] = { 0, 3, 2, 0, 2, 1 };
+    uploadMeshData(texture.ground, positions, normals, texcoords, 4, indices, 6);
+    glBindVertexArray(0);
+    return true;
+}
+
+void closeVirtualTexture(VirtualTexture& texture) {
+    if (!texture.loads)
+        return;
+    // zadania trzymaja wskazniki na loads i texture
+    for (uint32_t i = 0; i < texture.config.loadsInFlight; ++i) {
+        int expected = TILE_LOAD_QUEUED;
+        texture.loads[i].state.compare_exchange_strong(expected, TILE_LOAD_CANCELLED);
+    }
+    waitForCounter(texture.loadJobs);
+    if (texture.atlas)
+        glDeleteTextures(1, &texture.atlas);
+    if (texture.indirectionTexture)
+        glDeleteTextures(1, &texture.indirectionTexture);
+    if (texture.feedbackFramebuffer) {
+        glDeleteFramebuffers(1, &texture.feedbackFramebuffer);
+        glDeleteRenderbuffers(1, &texture.feedbackColor);
+        glDeleteRenderbuffers(1, &texture.feedbackDepth);
+    }
+    for (FeedbackReadback& readback : texture.readbacks) {
+        if (readback.fence)
+            glDeleteSync(readback.fence);
+        if (readback.buffer)
+            glDeleteBuffers(1, &readback.buffer);
+        readback = FeedbackReadback();
+    }
+    if (texture.ground.EBO) {
+        glDeleteVertexArrays(MESH_LAYOUT_COUNT, texture.ground.VAO);
+        glDeleteBuffers(VERTEX_STREAM_COUNT, texture.ground.VBO);
+        glDeleteBuffers(1, &texture.ground.EBO);
+    }
+    texture.ground = Mesh();
+    texture.atlas = texture.indirectionTexture = 0;
+    texture.feedbackFramebuffer = texture.feedbackColor = texture.feedbackDepth = 0;
+    texture.feedbackWidth = texture.feedbackHeight = 0;
+    texture.loads.reset();
+    closeAsset(texture.asset);
+}
+
+void beginVirtualTextureFeedback(VirtualTexture& texture, int framebufferWidth, int framebufferHeight) {
+    texture.framebufferWidth = framebufferWidth;
+    texture.framebufferHeight = framebufferHeight;
+    int width = std::max(1, framebufferWidth / (int)texture.config.feedbackDivisor);
+    int height = std::max(1, framebufferHeight / (int)texture.config.feedbackDivisor);
+    if (width != texture.feedbackWidth || height != texture.feedbackHeight) {
+        if (!texture.feedbackFramebuffer) {
+            glGenFramebuffers(1, &texture.feedbackFramebuffer);
+            glGenRenderbuffers(1, &texture.feedbackColor);
+            glGenRenderbuffers(1, &texture.feedbackDepth);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, texture.feedbackColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, texture.feedbackDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, texture.feedbackFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, texture.feedbackColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, texture.feedbackDepth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::VIRTUAL_TEXTURE::FEEDBACK_FRAMEBUFFER_INCOMPLETE" << std::endl;
+        texture.feedbackWidth = width;
+        texture.feedbackHeight = height;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, texture.feedbackFramebuffer);
+    glViewport(0, 0, width, height);
+    // (0, 0, 0, 0) - tlo, bez zadania
+    const GLuint background[4] = { 0, 0, 0, 0 };
+    glClearBufferuiv(GL_COLOR, 0, background);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void endVirtualTextureFeedback(VirtualTexture& texture) {
+    FeedbackReadback& readback = texture.readbacks[texture.nextReadback];
+    if (readback.fence) {
+        // wszystkie bufory czekaja na odbior - ta klatka bez odczytu, zamiast czekania na GPU
+        texture.stats.skippedReadbacks++;
+    } else {
+        size_t pixelCount = (size_t)texture.feedbackWidth * texture.feedbackHeight;
+        if (!readback.buffer)
+            glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        if (readback.pixelCount != pixelCount) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, pixelCount * 4 * sizeof(uint16_t), nullptr, GL_STREAM_READ);
+            readback.pixelCount = pixelCount;
+        }
+        // przy zbindowanym PBO odczyt idzie do bufora bez czekania na GPU
+        glReadPixels(0, 0, texture.feedbackWidth, texture.feedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        texture.nextReadback = (texture.nextReadback + 1) % READBACK_COUNT;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, texture.framebufferWidth, texture.framebufferHeight);
+}
+
+void drawVirtualTextureGround(const VirtualTexture& texture, GLuint shaderProgram, bool feedback) {
+    // feedback w 1/divisor rozdzielczosci ma divisor razy wieksze pochodne UV - przesuniecie mipa to wyrownuje
+    float lodBias = feedback ? -std::log2((float)texture.config.feedbackDivisor) : 0.0f;
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    glUniform4f(glGetUniformLocation(shaderProgram, "vtPages"), (float)texture.indirectionWidth,
+        (float)texture.indirectionHeight, (float)texture.levels.size(), lodBias);
+    glUniform3f(glGetUniformLocation(shaderProgram, "vtAtlasLayout"), (float)texture.header.tileSize,
+        (float)texture.header.border, (float)(texture.config.atlasTiles * texture.physicalSize));
+    glUniform1i(glGetUniformLocation(shaderProgram, "vtAtlas"), 1);
+    glUniform1i(glGetUniformLocation(shaderProgram, "vtIndirection"), 2);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, texture.atlas);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, texture.indirectionTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(texture.ground.VAO[LAYOUT_TEXTURED]);
+    glDrawElements(GL_TRIANGLES, texture.ground.indexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+void collectTileRequests(VirtualTexture& texture, const uint16_t* feedback, size_t pixelCount) {
+    PROFILE_FUNCTION();
+    uint32_t frame = ++texture.frame;
+    uint32_t levelCount = (uint32_t)texture.levels.size();
+    texture.stats.feedbacks++;
+    texture.requests.clear();
+    uint64_t previous = UINT64_MAX;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const uint16_t* pixel = feedback + 4 * i;
+        if (!pixel[3])
+            continue;
+        // sasiednie piksele zwykle trafiaja w ten sam kafel
+        uint64_t key = pixel[0] | (uint64_t)pixel[1] << 16 | (uint64_t)pixel[2] << 32;
+        if (key == previous)
+            continue;
+        previous = key;
+        uint32_t level = pixel[2], x = pixel[0], y = pixel[1];
+        if (level >= levelCount || x >= texture.levels[level].pagesX || y >= texture.levels[level].pagesY)
+            continue;
+        // kafel i przodkowie az do pierwszego oznaczonego juz w tym feedbacku - wczytane grubsze poziomy
+        // zostaja w atlasie jako zastepstwo, dopoki widac cokolwiek pod nimi
+        for (; level < levelCount; ++level, x >>= 1, y >>= 1) {
+            uint32_t tile = texture.levels[level].firstTile + y * texture.levels[level].pagesX + x;
+            if (texture.tileRequested[tile] == frame)
+                break;
+            texture.tileRequested[tile] = frame;
+            uint32_t slot = texture.tileSlots[tile];
+            if (slot == VT_NOT_RESIDENT)
+                texture.requests.push_back({ level, tile });
+            else if (slot != VT_LOADING)
+                texture.slots[slot].lastUsed = frame;
+        }
+    }
+    // najpierw grube poziomy - male, pokrywaja duzo ekranu, a drobniejsze bez nich i tak by czekaly
+    std::sort(texture.requests.begin(), texture.requests.end(), [](const VirtualTileRequest& a, const VirtualTileRequest& b) {
+        return a.level != b.level ? a.level > b.level : a.tile < b.tile;
+    });
+
+    for (uint32_t i = 0; i < texture.config.loadsInFlight; ++i) {
+        VirtualTileLoad& load = texture.loads[i];
+        if (load.state.load(std::memory_order_relaxed) != TILE_LOAD_QUEUED || texture.tileRequested[load.tile] == frame)
+            continue;
+        int expected = TILE_LOAD_QUEUED;
+        if (load.state.compare_exchange_strong(expected, TILE_LOAD_CANCELLED)) {
+            texture.tileSlots[load.tile] = VT_NOT_RESIDENT;
+            texture.stats.cancelled++;
+        }
+    }
+}
+
+void issueTileLoads(VirtualTexture& texture) {
+    size_t next = 0;
+    for (uint32_t i = 0; i < texture.config.loadsInFlight && next < texture.requests.size(); ++i) {
+        VirtualTileLoad& load = texture.loads[i];
+        if (load.state.load(std::memory_order_acquire) != TILE_LOAD_FREE)
+            continue;
+        while (next < texture.requests.size() && texture.tileSlots[texture.requests[next].tile] != VT_NOT_RESIDENT)
+            ++next;
+        if (next == texture.requests.size())
+            break;
+        uint32_t tile = texture.requests[next++].tile;
+        load.tile = tile;
+        load.state.store(TILE_LOAD_QUEUED, std::memory_order_relaxed);
+        texture.tileSlots[tile] = VT_LOADING;
+        texture.stats.requested++;
+        prefetchAsset(texture.asset, texture.header.dataOffset + (size_t)tile * texture.header.tileBytes, texture.tileDataSize);
+        runJob(&loadTile, &load, 0, 1, &texture.loadJobs);
+    }
+}
+
+void updateVirtualTexture(VirtualTexture& texture) {
+    PROFILE_FUNCTION();
+    // odczyty od najstarszego; GPU konczy je po kolei, wiec pierwszy niegotowy konczy petle
+    for (unsigned int i = 0; i < READBACK_COUNT; ++i) {
+        FeedbackReadback& readback = texture.readbacks[(texture.nextReadback + i) % READBACK_COUNT];
+        if (!readback.fence)
+            continue;
+        if (glClientWaitSync(readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        const uint16_t* pixels = (const uint16_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+            readback.pixelCount * 4 * sizeof(uint16_t), GL_MAP_READ_BIT);
+        if (pixels) {
+            collectTileRequests(texture, pixels, readback.pixelCount);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            std::cerr << "ERROR::VIRTUAL_TEXTURE::CANNOT_MAP_FEEDBACK" << std::endl;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    issueTileLoads(texture);
+
+    // limit kafli na klatke - reszta gotowych czeka w swoich buforach
+    unsigned int uploads = 0;
+    for (uint32_t i = 0; i < texture.config.loadsInFlight && uploads < texture.config.uploadsPerFrame; ++i) {
+        VirtualTileLoad& load = texture.loads[i];
+        if (load.state.load(std::memory_order_acquire) != TILE_LOAD_DONE)
+            continue;
+        if (uploads++ == 0)
+            glBindTexture(GL_TEXTURE_2D, texture.atlas);
+        placeTile(texture, load.tile, load.pixels.data());
+        load.state.store(TILE_LOAD_FREE, std::memory_order_release);
+    }
+    if (uploads)
+        glBindTexture(GL_TEXTURE_2D, 0);
+    uploadIndirection(texture);
+}
+
+void printVirtualTextureReport(const VirtualTexture& texture) {
+    if (!texture.loads)
+        return;
+    uint32_t atlasSize = texture.config.atlasTiles * texture.physicalSize;
+    size_t indirectionBytes = 0;
+    for (const std::vector<uint32_t>& level : texture.indirection)
+        indirectionBytes += level.size() * sizeof(uint32_t);
+    const VirtualTextureStats& stats = texture.stats;
+    std::cout << "Virtual texture: " << texture.header.width << "x" << texture.header.height << ", " << texture.levels.size()
+        << " levels, " << texture.tileSlots.size() << " tiles; atlas " << texture.slots.size() << " tiles ("
+        << textureLevelSize(texture.atlasFormat, atlasSize, atlasSize) / (1024 * 1024) << " MB), indirection "
+        << indirectionBytes / 1024 << " KB; " << stats.feedbacks << " feedback readbacks (" << stats.skippedReadbacks
+        << " skipped), " << stats.requested << " tile loads, " << stats.cancelled << " cancelled, " << stats.loaded
+        << " uploaded, " << stats.evicted << " evicted, " << stats.dropped << " dropped with a full atlas, "
+        << stats.uploadedBytes / (1024 * 1024) << " MB uploaded" << std::endl;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AssetIO.h"
+#include "JobSystem.h"
+#include "ModelLoader.h"
+#include "TextureCodec.h"
+
+const uint32_t VIRTUAL_TEXTURE_VERSION = 1;
+const uint32_t VT_MAX_TILE_SIZE = 4096;
+
+// plik piramidy: naglowek, potem kafle o stalym rozmiarze tileBytes - poziom po poziomie, wierszami.
+// Kafel to (tileSize + 2 * border)^2 pikseli w formacie gotowym dla GL (RGBA8 albo BC1),
+// ramka powtarza piksele sasiadow - filtrowanie dwuliniowe w atlasie bez szwow miedzy kaflami
+struct VirtualTextureHeader {
+    char magic[4];  // "DVTX"
+    uint32_t version;
+    uint32_t format;              // TextureFormat
+    uint32_t width, height;       // obraz poziomu 0 w pikselach
+    uint32_t tileSize, border;
+    uint32_t levelCount;          // do poziomu z jednym kaflem
+    uint32_t pagesX, pagesY;      // kafle poziomu 0
+    uint32_t tileBytes;           // odstep kafli w pliku (wyrownany do 64 B)
+    uint32_t reserved;
+    uint64_t dataOffset;
+};
+
+struct VirtualTextureBuildConfig {
+    uint32_t tileSize = 128;  // wielokrotnosc 4, tileSize + 2 * border tez
+    uint32_t border = 4;
+    bool compress = false;    // BC1 (ortofotomapa nie ma przezroczystosci)
+};
+
+// offline: siatka columns x (sources / columns) obrazow tego samego rozmiaru (arkusze ortofotomapy, wierszami
+// od gornego lewego) -> jeden plik piramidy. Pamiec stala: arkusze dekodowane po jednym do zmapowanego pliku
+// tymczasowego z poziomem 0, kolejne poziomy tez w zmapowanych plikach, kafle ciete i kompresowane w puli zadan
+bool buildVirtualTexture(const std::string& outputPath, const std::vector<std::string>& sources, uint32_t columns,
+    const VirtualTextureBuildConfig& config);
+
+struct VirtualTextureConfig {
+    uint32_t atlasTiles = 16;      // atlas atlasTiles x atlasTiles kafli - staly limit pamieci GPU (przycinany do GL_MAX_TEXTURE_SIZE)
+    uint32_t loadsInFlight = 16;   // zadania wczytania kafli naraz (bufory alokowane raz)
+    uint32_t uploadsPerFrame = 8;  // kafle wysylane do atlasu w jednej klatce
+    uint32_t feedbackDivisor = 8;  // przebieg feedback w rozdzielczosci okna / divisor
+    float groundSize = 200.0f;     // szerokosc ziemi w jednostkach swiata (glebokosc wg proporcji obrazu)
+    float groundHeight = -2.0f;
+};
+
+const uint32_t VT_NOT_RESIDENT = 0xFFFFFFFF;
+const uint32_t VT_LOADING = 0xFFFFFFFE;
+
+struct VirtualTextureLevel {
+    uint32_t pagesX, pagesY;
+    uint32_t firstTile;  // indeks pierwszego kafla poziomu w pliku i w tablicach stanu
+};
+
+enum VirtualTileLoadState {
+    TILE_LOAD_FREE,
+    TILE_LOAD_QUEUED,     // w puli zadan
+    TILE_LOAD_CANCELLED,  // juz niepotrzebny - zadanie tylko zwolni miejsce
+    TILE_LOAD_RUNNING,
+    TILE_LOAD_DONE        // piksele gotowe, czeka na watek renderu
+};
+
+struct VirtualTexture;
+
+struct VirtualTileLoad {
+    std::atomic<int> state{ TILE_LOAD_FREE };
+    uint32_t tile = 0;
+    const VirtualTexture* texture = nullptr;
+    std::vector<unsigned char> pixels;  // kafel w formacie atlasu
+};
+
+struct VirtualTextureSlot {
+    uint32_t tile = VT_NOT_RESIDENT;
+    uint32_t lastUsed = 0;  // numer feedbacku, w ktorym kafel byl ostatnio widoczny
+    bool pinned = false;    // najgrubszy poziom - zawsze jest co probkowac
+};
+
+struct VirtualTileRequest {
+    uint32_t level, tile;
+};
+
+struct FeedbackReadback {
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    size_t pixelCount = 0;
+};
+
+struct VirtualTextureStats {
+    uint64_t feedbacks = 0;
+    uint64_t requested = 0;
+    uint64_t loaded = 0;
+    uint64_t cancelled = 0;
+    uint64_t evicted = 0;
+    uint64_t dropped = 0;        // atlas pelny kafli widocznych w ostatnim feedbacku
+    uint64_t uploadedBytes = 0;
+    uint64_t skippedReadbacks = 0;
+};
+
+// piramida czytana przez openAsset (mmap albo paczka), w GL tylko atlas i tablica indirekcji.
+// Feedback (strony i poziomy widoczne w klatce) -> zadania wczytania kafli w puli (od najgrubszych),
+// niepotrzebne juz zadania anulowane; gotowe kafle trafiaja do atlasu w miejsce najdawniej widzianych (LRU).
+// Indirekcja: mip na poziom piramidy, teksel na strone -> najdrobniejszy wczytany kafel, ktory ja pokrywa
+struct VirtualTexture {
+    VirtualTextureConfig config;
+    VirtualTextureHeader header = {};
+    AssetData asset;
+    std::vector<VirtualTextureLevel> levels;
+    uint32_t indirectionWidth = 0, indirectionHeight = 0;  // strony poziomu 0 zaokraglone do potegi 2
+    TextureFormat atlasFormat = TEXTURE_RGBA8;
+    uint32_t physicalSize = 0;  // bok kafla z ramka
+    size_t tileDataSize = 0;    // bajty kafla w formacie atlasu
+
+    // stan kafli - tylko watek renderu
+    std::vector<uint32_t> tileSlots;      // slot atlasu, VT_NOT_RESIDENT albo VT_LOADING
+    std::vector<uint32_t> tileRequested;  // numer feedbacku, w ktorym kafel byl ostatnio potrzebny
+    std::vector<VirtualTextureSlot> slots;
+    std::vector<VirtualTileRequest> requests;
+    std::unique_ptr<VirtualTileLoad[]> loads;
+    JobCounter loadJobs;
+    uint32_t frame = 0;  // numer feedbacku
+
+    // wpis RGBA8UI na strone: (slot x, slot y, poziom kafla, 1), prostokat zmian na poziom do wyslania
+    std::vector<std::vector<uint32_t>> indirection;
+    std::vector<glm::uvec4> dirty;  // minX, minY, maxX + 1, maxY + 1
+
+    GLuint atlas = 0, indirectionTexture = 0;
+    GLuint feedbackFramebuffer = 0, feedbackColor = 0, feedbackDepth = 0;
+    int feedbackWidth = 0, feedbackHeight = 0;
+    int framebufferWidth = 0, framebufferHeight = 0;
+    FeedbackReadback readbacks[3];
+    unsigned int nextReadback = 0;
+    Mesh ground;
+    VirtualTextureStats stats;
+};
+
+// naglowek, poziomy i stan kafli bez GL (narzedzia, benchmarki)
+bool loadVirtualTextureLayout(VirtualTexture& texture, const std::string& path, const VirtualTextureConfig& config);
+// + atlas, indirekcja, siatka ziemi i synchronicznie najgrubszy kafel (przypiety)
+bool openVirtualTexture(VirtualTexture& texture, const std::string& path, const VirtualTextureConfig& config);
+void closeVirtualTexture(VirtualTexture& texture);
+
+// przebieg feedback: wlasny framebuffer RGBA16UI, rysowanie ziemi wariantem SHADER_VT_FEEDBACK,
+// odczyt do PBO (pierscien z fence'ami) - wynik odbierany w updateVirtualTexture kilka klatek pozniej
+void beginVirtualTextureFeedback(VirtualTexture& texture, int framebufferWidth, int framebufferHeight);
+void endVirtualTextureFeedback(VirtualTexture& texture);
+// feedback - wariant SHADER_VT_FEEDBACK (przesuniecie mipa za mniejsza rozdzielczosc); view/projection juz ustawione
+void drawVirtualTextureGround(const VirtualTexture& texture, GLuint shaderProgram, bool feedback);
+// sfera (srodek, promien) wokol prostokata ziemi - do zakresu glebi kamery
+glm::vec4 virtualTextureGroundSphere(const VirtualTexture& texture);
+
+// piksele feedbacku (x, y, poziom, 1) -> texture.requests od najgrubszych, oznaczenie uzycia wczytanych kafli
+// i ich przodkow, anulowanie zadan, ktorych kafli juz nie widac (bez GL)
+void collectTileRequests(VirtualTexture& texture, const uint16_t* feedback, size_t pixelCount);
+// zlecenie wczytania zadanych kafli na wolne miejsca (bez GL)
+void issueTileLoads(VirtualTexture& texture);
+// raz na klatke: gotowe odczyty feedbacku, wysylka wczytanych kafli do atlasu, zmiany indirekcji
+void updateVirtualTexture(VirtualTexture& texture);
+
+void printVirtualTextureReport(const VirtualTexture& texture);
@@ -0,0 +1,163 @@
+#include "VirtualTexture.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+const uint64_t TILE_DATA_OFFSET = 64;
+const uint32_t DOWNSAMPLE_BAND_ROWS = 64;
+
+// kafel z ramka; piksele poza obrazem powtarzaja jego krawedz
+static void extractTile(const unsigned char* image, uint32_t width, uint32_t height, uint32_t tileX, uint32_t tileY,
+    const VirtualTextureBuildConfig& config, unsigned char* tile) {
+    uint32_t physical = config.tileSize + 2 * config.border;
+    for (uint32_t y = 0; y < physical; ++y) {
+        int64_t sourceY = (int64_t)tileY * config.tileSize + y - config.border;
+        sourceY = std::max<int64_t>(0, std::min<int64_t>(height - 1, sourceY));
+        const unsigned char* row = image + (size_t)sourceY * width * 4;
+        unsigned char* out = tile + (size_t)y * physical * 4;
+        for (uint32_t x = 0; x < physical; ++x) {
+            int64_t sourceX = (int64_t)tileX * config.tileSize + x - config.border;
+            sourceX = std::max<int64_t>(0, std::min<int64_t>(width - 1, sourceX));
+            std::memcpy(out + x * 4, row + sourceX * 4, 4);
+        }
+    }
+}
+
+// arkusze po kolei do jednego obrazu poziomu 0 (zmapowany plik tymczasowy)
+static bool assembleLevel0(const std::vector<std::string>& sources, uint32_t columns, const std::string& path,
+    MappedFile& level, uint32_t& width, uint32_t& height) {
+    std::vector<unsigned char> pixels;
+    uint32_t sheetWidth = 0, sheetHeight = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        AssetData asset;
+        if (!openAsset(sources[i], asset)) {
+            std::cerr << "ERROR::VIRTUAL_TEXTURE::CANNOT_OPEN " << sources[i] << std::endl;
+            return false;
+        }
+        uint32_t w = 0, h = 0;
+        bool decoded = decodeImageRgba(asset.data, asset.size, w, h, pixels);
+        closeAsset(asset);
+        if (!decoded) {
+            std::cerr << "ERROR::VIRTUAL_TEXTURE::DECODE_FAILED " << sources[i] << std::endl;
+            return false;
+        }
+        if (i == 0) {
+            sheetWidth = w;
+            sheetHeight = h;
+            width = w * columns;
+            height = h * (uint32_t)(sources.size() / columns);
+            if (!createMappedFile(level, path, (size_t)width * height * 4)) {
+                std::cerr << "ERROR::VIRTUAL_TEXTURE::CANNOT_CREATE " << path << std::endl;
+                return false;
+            }
+        } else if (w != sheetWidth || h != sheetHeight) {
+            std::cerr << "ERROR::VIRTUAL_TEXTURE::SHEET_SIZE_MISMATCH " << sources[i] << std::endl;
+            return false;
+        }
+        size_t column = i % columns, row = i / columns;
+        for (uint32_t y = 0; y < h; ++y) {
+            std::memcpy(level.data + (((row * h + y) * width) + column * w) * 4, &pixels[(size_t)y * w * 4], (size_t)w * 4);
+        }
+    }
+    return true;
+}
+
+bool buildVirtualTexture(const std::string& outputPath, const std::vector<std::string>& sources, uint32_t columns,
+    const VirtualTextureBuildConfig& config) {
+    PROFILE_FUNCTION();
+    uint32_t physical = config.tileSize + 2 * config.border;
+    if (sources.empty() || columns == 0 || sources.size() % columns != 0 || config.tileSize == 0 || config.tileSize % 4 != 0
+        || physical % 4 != 0) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::INVALID_BUILD_CONFIG" << std::endl;
+        return false;
+    }
+    MappedFile level;
+    std::string levelPath = outputPath + ".level0.tmp";
+    uint32_t width = 0, height = 0;
+    if (!assembleLevel0(sources, columns, levelPath, level, width, height)) {
+        closeMappedFile(level);
+        std::remove(levelPath.c_str());
+        return false;
+    }
+
+    VirtualTextureHeader header = {};
+    std::memcpy(header.magic, "DVTX", 4);
+    header.version = VIRTUAL_TEXTURE_VERSION;
+    header.format = config.compress ? TEXTURE_BC1 : TEXTURE_RGBA8;
+    header.width = width;
+    header.height = height;
+    header.tileSize = config.tileSize;
+    header.border = config.border;
+    header.pagesX = (width + config.tileSize - 1) / config.tileSize;
+    header.pagesY = (height + config.tileSize - 1) / config.tileSize;
+    // poziomy az do jednego kafla - tyle samo co mipow indirekcji (strony zaokraglone do potegi 2)
+    header.levelCount = 1;
+    while ((1u << (header.levelCount - 1)) < std::max(header.pagesX, header.pagesY))
+        header.levelCount++;
+    header.tileBytes = (uint32_t)((textureLevelSize((TextureFormat)header.format, physical, physical) + 63) & ~(size_t)63);
+    header.dataOffset = TILE_DATA_OFFSET;
+    uint64_t tileCount = 0;
+    for (uint32_t l = 0; l < header.levelCount; ++l)
+        tileCount += (uint64_t)((header.pagesX + (1u << l) - 1) >> l) * ((header.pagesY + (1u << l) - 1) >> l);
+
+    MappedFile output;
+    if (!createMappedFile(output, outputPath, (size_t)(header.dataOffset + tileCount * header.tileBytes))) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::CANNOT_CREATE " << outputPath << std::endl;
+        closeMappedFile(level);
+        std::remove(levelPath.c_str());
+        return false;
+    }
+    std::memcpy(output.data, &header, sizeof(header));
+
+    uint64_t firstTile = 0;
+    for (uint32_t l = 0; l < header.levelCount; ++l) {
+        uint32_t pagesX = (width + config.tileSize - 1) / config.tileSize, pagesY = (height + config.tileSize - 1) / config.tileSize;
+        unsigned char* tiles = output.data + header.dataOffset + firstTile * header.tileBytes;
+        const unsigned char* image = level.data;
+        parallelFor(0, (size_t)pagesX * pagesY, [&](size_t t) {
+            std::vector<unsigned char> tile((size_t)physical * physical * 4);
+            extractTile(image, width, height, (uint32_t)(t % pagesX), (uint32_t)(t / pagesX), config, tile.data());
+            unsigned char* out = tiles + t * header.tileBytes;
+            if (config.compress)
+                compressBlocks(tile.data(), physical, physical, TEXTURE_BC1, out);
+            else
+                std::memcpy(out, tile.data(), tile.size());
+        });
+        firstTile += (uint64_t)pagesX * pagesY;
+        if (l + 1 == header.levelCount)
+            break;
+
+        // nastepny poziom pasami wierszy - kazdy pas czyta tylko swoje dwa razy wyzsze zrodlo
+        uint32_t nextWidth = std::max(1u, (width + 1) / 2), nextHeight = std::max(1u, (height + 1) / 2);
+        MappedFile next;
+        std::string nextPath = outputPath + ".level" + std::to_string(l + 1) + ".tmp";
+        if (!createMappedFile(next, nextPath, (size_t)nextWidth * nextHeight * 4)) {
+            std::cerr << "ERROR::VIRTUAL_TEXTURE::CANNOT_CREATE " << nextPath << std::endl;
+            closeMappedFile(level);
+            std::remove(levelPath.c_str());
+            closeMappedFile(output);
+            std::remove(outputPath.c_str());
+            return false;
+        }
+        parallelFor(0, (nextHeight + DOWNSAMPLE_BAND_ROWS - 1) / DOWNSAMPLE_BAND_ROWS, [&](size_t band) {
+            uint32_t y0 = (uint32_t)band * DOWNSAMPLE_BAND_ROWS;
+            uint32_t rows = std::min(DOWNSAMPLE_BAND_ROWS, nextHeight - y0);
+            downsampleBox(level.data + (size_t)2 * y0 * width * 4, width, height - 2 * y0,
+                next.data + (size_t)y0 * nextWidth * 4, nextWidth, rows);
+        });
+        closeMappedFile(level);
+        std::remove(levelPath.c_str());
+        level = next;
+        levelPath = nextPath;
+        width = nextWidth;
+        height = nextHeight;
+    }
+    closeMappedFile(level);
+    std::remove(levelPath.c_str());
+    closeMappedFile(output);
+    return true;
+}
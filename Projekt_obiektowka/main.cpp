@@ -4,20 +4,67 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <thread>
 
 #include "Shader.h"
 #include "ModelLoader.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+#include "BatchSimulation.h"
+#include "Telemetry.h"
+#include "Replay.h"
+#include "Profiler.h"
+#include "GpuTimer.h"
+#include "StressScene.h"
+#include "StaticBatch.h"
+#include "MeshRegistry.h"
+#include "Flythrough.h"
+#include "AllocTracker.h"
+#include "FrameArena.h"
+#include "ShaderCache.h"
+#include "ShaderLibrary.h"
+#include "AssetIO.h"
+#include "TextureManager.h"
+#include "VirtualTexture.h"
+#include "LodScene.h"
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 
 float yaw = 0.0f, pitch = 0.0f;
 float lastX = 400, lastY = 300;
 bool firstMouse = true;
 bool leftMousePressed = false;
 float radius = 5.0f;
+float maxRadius = 20.0f;  // rosnie z rozmiarem sceny (miasto, ziemia)
+// C - swobodny lot zamiast orbity: WASD, R/F gora/dol, Shift szybciej, mysz obraca widok, kolko zmienia predkosc
+bool flyCamera = false;
+glm::vec3 flyPosition(0.0f);
+float flySpeed = 5.0f;  // jednostki swiata na sekunde
+SimControl simControl;
+bool showGpuOverlay = true;
+bool lightingEnabled = false;
+
+const float CAMERA_FOV_Y = glm::radians(45.0f);
+// far / near - przy 24-bitowej glebi wiekszy stosunek daje migotanie odleglych powierzchni
+const float CAMERA_DEPTH_RATIO = 10000.0f;
+const float CAMERA_MIN_NEAR = 0.1f;
+const float DRONE_BOUNDS_RADIUS = 5.0f;
+
+// kierunek od celu orbity do kamery; kamera swobodna patrzy w przeciwna strone
+glm::vec3 orbitDirection() {
+    return glm::vec3(cos(glm::radians(yaw)) * cos(glm::radians(pitch)), sin(glm::radians(pitch)),
+        sin(glm::radians(yaw)) * cos(glm::radians(pitch)));
+}
 
 void scroll_callback(GLFWwindow*, double, double yoffset) {
-    radius -= yoffset;
-    if (radius < 1.0f) radius = 1.0f;
-    if (radius > 20.0f) radius = 20.0f;
+    // mnoznik zamiast stalego kroku - tak samo wygodnie przy dronie i nad kilometrowym miastem
+    float factor = std::pow(1.2f, (float)yoffset);
+    if (flyCamera)
+        flySpeed = glm::clamp(flySpeed * factor, 0.5f, 10.0f * maxRadius);
+    else
+        radius = glm::clamp(radius / factor, 1.0f, maxRadius);
 }
 
 void mouse_button_callback(GLFWwindow*, int button, int action, int) {
@@ -25,6 +72,49 @@ void mouse_button_callback(GLFWwindow*, int button, int action, int) {
         leftMousePressed = (action == GLFW_PRESS);
 }
 
+void key_callback(GLFWwindow*, int key, int, int action, int) {
+    if (action != GLFW_PRESS)
+        return;
+    // P - pauza, +/- - przyspieszenie/spowolnienie czasu symulacji (w zakresie schedulera)
+    if (key == GLFW_KEY_P)
+        simControl.paused = !simControl.paused;
+    if (key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD)
+        simControl.timeScale = (float)std::min(simControl.timeScale * 2.0, SCHEDULER_MAX_TIME_SCALE);
+    if (key == GLFW_KEY_MINUS || key == GLFW_KEY_KP_SUBTRACT)
+        simControl.timeScale = (float)std::max(simControl.timeScale * 0.5, SCHEDULER_MIN_TIME_SCALE);
+    // G - nakladka z czasami GPU
+    if (key == GLFW_KEY_G)
+        showGpuOverlay = !showGpuOverlay;
+    // L - oswietlenie (osobny wariant shadera, kompilowany w tle przy pierwszym wlaczeniu)
+    if (key == GLFW_KEY_L)
+        lightingEnabled = !lightingEnabled;
+    // strzalki - przewijanie powtorki o 10 s
+    if (key == GLFW_KEY_LEFT)
+        simControl.seekSeconds = -10.0f;
+    if (key == GLFW_KEY_RIGHT)
+        simControl.seekSeconds = 10.0f;
+    // C - kamera swobodna startuje z miejsca i kierunku orbity
+    if (key == GLFW_KEY_C) {
+        flyCamera = !flyCamera;
+        if (flyCamera)
+            flyPosition = radius * orbitDirection();
+    }
+    // w locie WASD/R/F steruja kamera (odczyt stanu klawiszy w petli renderu)
+    if (flyCamera)
+        return;
+
+    // WASD/R/F - przesuniecie punktu docelowego wszystkich dronow
+    glm::vec3 offset(0.0f);
+    if (key == GLFW_KEY_W) offset.z = -1.0f;
+    if (key == GLFW_KEY_S) offset.z = 1.0f;
+    if (key == GLFW_KEY_A) offset.x = -1.0f;
+    if (key == GLFW_KEY_D) offset.x = 1.0f;
+    if (key == GLFW_KEY_R) offset.y = 1.0f;
+    if (key == GLFW_KEY_F) offset.y = -1.0f;
+    if (offset != glm::vec3(0.0f))
+        pushDroneCommand(simControl, { ALL_DRONES, offset });
+}
+
 void cursor_position_callback(GLFWwindow*, double xpos, double ypos) {
     if (!leftMousePressed) {
         firstMouse = true;
@@ -50,64 +140,564 @@ void cursor_position_callback(GLFWwindow*, double xpos, double ypos) {
     if (pitch < -89.0f) pitch = -89.0f;
 }
 
-const char* vertexShaderSource = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+// przesuniecie kamery swobodnej z wcisnietych klawiszy, wzgledem kierunku patrzenia
+glm::vec3 flyMovement(GLFWwindow* window, const glm::vec3& forward) {
+    glm::vec3 up(0.0f, 1.0f, 0.0f);
+    glm::vec3 right = glm::normalize(glm::cross(forward, up));
+    glm::vec3 move(0.0f);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) move += forward;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) move -= forward;
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) move += right;
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) move -= right;
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) move += up;
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) move -= up;
+    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+        move *= 4.0f;
+    return move;
 }
-)";
 
-const char* fragmentShaderSource = R"(
-#version 330 core
-out vec4 FragColor;
-void main() {
-    FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+// near/far obejmujace sfery sceny i drony zamiast stalych 0.1/100, ktore ucinaly miasto i ziemie;
+// near najwyzej far / CAMERA_DEPTH_RATIO blizej, zeby nie tracic precyzji glebi
+void cameraDepthRange(const std::vector<glm::vec4>& sceneSpheres, const std::vector<glm::mat4>& drones,
+    const glm::vec3& cameraPos, float& nearPlane, float& farPlane) {
+    nearPlane = FLT_MAX;
+    farPlane = 0.0f;
+    auto include = [&](const glm::vec3& center, float sphereRadius) {
+        float distance = glm::length(center - cameraPos);
+        nearPlane = std::min(nearPlane, distance - sphereRadius);
+        farPlane = std::max(farPlane, distance + sphereRadius);
+    };
+    for (const glm::vec4& sphere : sceneSpheres)
+        include(glm::vec3(sphere), sphere.w);
+    for (const glm::mat4& drone : drones)
+        include(glm::vec3(drone[3]), DRONE_BOUNDS_RADIUS);
+    farPlane = std::max(farPlane, 1.0f);
+    nearPlane = glm::clamp(nearPlane, std::max(CAMERA_MIN_NEAR, farPlane / CAMERA_DEPTH_RATIO), 0.5f * farPlane);
 }
-)";
 
-int main() {
+// po tylu klatkach bufory sa juz rozgrzane - dalej petla renderu i ticki symulacji nie moga alokowac
+const unsigned int ALLOC_WARMUP_FRAMES = 120;
+const unsigned int ALLOC_REPORTED_FRAMES = 10;
+
+int main(int argc, char** argv) {
+    PROFILE_THREAD("main");
+    initJobSystem();
+
+    // --trace plik.json: zapis osi czasu wszystkich watkow przy wyjsciu (chrome://tracing, Perfetto)
+    std::string tracePath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--trace")
+            tracePath = argv[i + 1];
+    }
+
+    // --pack-assets paczka katalog plik...: zapis plikow (sciezki wzgledem katalogu) do jednej paczki i wyjscie
+    for (int i = 1; i + 2 < argc; ++i) {
+        if (std::string(argv[i]) == "--pack-assets") {
+            std::vector<std::string> files;
+            for (int j = i + 3; j < argc && std::string(argv[j]).compare(0, 2, "--") != 0; ++j)
+                files.push_back(argv[j]);
+            bool packed = writeAssetPack(argv[i + 1], argv[i + 2], files);
+            if (packed)
+                std::cout << "Asset pack: " << files.size() << " files -> " << argv[i + 1] << std::endl;
+            shutdownJobSystem();
+            return packed ? 0 : -1;
+        }
+    }
+    // --build-virtual-texture plik.vt kolumny arkusz...: piramida kafli z siatki arkuszy ortofotomapy (wierszami
+    // od gornego lewego) i wyjscie; --compress-textures: kafle BC1, --vt-tile N: bok kafla (domyslnie 128)
+    for (int i = 1; i + 3 < argc; ++i) {
+        if (std::string(argv[i]) == "--build-virtual-texture") {
+            std::vector<std::string> sources;
+            for (int j = i + 3; j < argc && std::string(argv[j]).compare(0, 2, "--") != 0; ++j)
+                sources.push_back(argv[j]);
+            VirtualTextureBuildConfig buildConfig;
+            for (int j = 1; j < argc; ++j) {
+                if (std::string(argv[j]) == "--compress-textures")
+                    buildConfig.compress = true;
+                if (std::string(argv[j]) == "--vt-tile" && j + 1 < argc)
+                    buildConfig.tileSize = (uint32_t)std::atoi(argv[j + 1]);
+            }
+            bool built = buildVirtualTexture(argv[i + 1], sources, (uint32_t)std::atoi(argv[i + 2]), buildConfig);
+            if (built)
+                std::cout << "Virtual texture: " << sources.size() << " sheets -> " << argv[i + 1] << std::endl;
+            shutdownJobSystem();
+            return built ? 0 : -1;
+        }
+    }
+    // --asset-pack paczka (mozna kilka razy): model, bufory i shadery najpierw z paczek, potem z dysku
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--asset-pack" && !mountAssetPack(argv[i + 1])) {
+            shutdownJobSystem();
+            return -1;
+        }
+    }
+
+    // --headless: same scenariusze, bez okna i bez OpenGL
+    BatchConfig batchConfig;
+    if (parseBatchArguments(argc, argv, batchConfig)) {
+        int result = batchConfig.rollouts ? runRolloutBatch(batchConfig) : runBatch(batchConfig);
+        if (!tracePath.empty())
+            writeChromeTrace(tracePath);
+        shutdownJobSystem();
+        return result;
+    }
+
+    // --flythrough N: kamera po zadanej trasie zamiast myszy, N klatek, raport czasow i porownanie z baseline
+    FlythroughConfig flythroughConfig;
+    Flythrough flythrough;
+    bool flythroughMode = parseFlythroughArguments(argc, argv, flythroughConfig);
+    if (flythroughMode && !initFlythrough(flythrough, flythroughConfig)) {
+        shutdownJobSystem();
+        return -1;
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    // bez okna na ekranie - GPU nadal potrzebuje kontekstu, wiec okno jest tylko ukryte
+    if (flythroughMode && flythroughConfig.hidden)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     GLFWwindow* window = glfwCreateWindow(800, 600, "Dron", nullptr, nullptr);
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    // vsync przycialby czasy klatek do odswiezania ekranu
+    if (flythroughMode)
+        glfwSwapInterval(0);
 
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_position_callback);
+    glfwSetKeyCallback(window, key_callback);
+
+    // tekstury dekodowane w puli zadan juz w trakcie wczytywania modelu; --texture-cache katalog (domyslnie
+    // texture_cache), --no-texture-cache, --compress-textures: BC1/BC3, --mip-filter kaiser: ostrzejsze mipy
+    TextureConfig textureConfig;
+    textureConfig.cacheDirectory = "texture_cache";
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--texture-cache" && i + 1 < argc)
+            textureConfig.cacheDirectory = argv[i + 1];
+        if (std::string(argv[i]) == "--no-texture-cache")
+            textureConfig.cacheDirectory.clear();
+        if (std::string(argv[i]) == "--compress-textures")
+            textureConfig.compress = true;
+        if (std::string(argv[i]) == "--mip-filter" && i + 1 < argc && std::string(argv[i + 1]) == "kaiser")
+            textureConfig.filter = MIP_FILTER_KAISER;
+    }
+    initTextureManager(textureConfig);
+
+    // --virtual-texture plik.vt: ziemia z ortofotomapa dowolnej wielkosci, w GPU tylko atlas kafli;
+    // --ground-size N: szerokosc ziemi w jednostkach swiata, --vt-atlas N: atlas N x N kafli
+    VirtualTextureConfig virtualTextureConfig;
+    std::string virtualTexturePath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--virtual-texture")
+            virtualTexturePath = argv[i + 1];
+        if (std::string(argv[i]) == "--ground-size")
+            virtualTextureConfig.groundSize = (float)std::atof(argv[i + 1]);
+        if (std::string(argv[i]) == "--vt-atlas")
+            virtualTextureConfig.atlasTiles = (uint32_t)std::atoi(argv[i + 1]);
+    }
+    VirtualTexture virtualTexture;
+    bool virtualTextureEnabled = !virtualTexturePath.empty()
+        && openVirtualTexture(virtualTexture, virtualTexturePath, virtualTextureConfig);
+
+    // --lod-scene plik.lod: miasto z fotogrametrii strumieniowane kaflami wg bledu na ekranie;
+    // --lod-budget MB: limit pamieci GPU kafli, --lod-error px: dopuszczalny blad geometrii
+    LodStreamingConfig lodConfig;
+    std::string lodScenePath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--lod-scene")
+            lodScenePath = argv[i + 1];
+        if (std::string(argv[i]) == "--lod-budget")
+            lodConfig.memoryBudget = (size_t)std::atoi(argv[i + 1]) << 20;
+        if (std::string(argv[i]) == "--lod-error")
+            lodConfig.maxScreenError = (float)std::atof(argv[i + 1]);
+    }
+    LodScene lodScene;
+    bool lodSceneEnabled = !lodScenePath.empty() && openLodScene(lodScene, lodScenePath, lodConfig);
+
+    // sfery (srodek, promien) tego, co kamera ma objac: okolica startu dronow, ziemia (--ground-size moze miec
+    // kilometry) i korzen miasta; z nich near/far w kazdej klatce (tez w przebiegu feedback), zasieg orbity i predkosc lotu
+    std::vector<glm::vec4> sceneSpheres(1, glm::vec4(0.0f, 0.0f, 0.0f, 20.0f));
+    if (virtualTextureEnabled)
+        sceneSpheres.push_back(virtualTextureGroundSphere(virtualTexture));
+    if (lodSceneEnabled)
+        sceneSpheres.push_back(lodScene.spheres[0]);
+    float sceneExtent = 0.0f;
+    for (const glm::vec4& sphere : sceneSpheres)
+        sceneExtent = std::max(sceneExtent, glm::length(glm::vec3(sphere)) + sphere.w);
+    maxRadius = 2.0f * sceneExtent;
+    flySpeed = std::max(flySpeed, 0.05f * sceneExtent);
+    ShaderLibrary shaderLibrary;
+
+    // jedno sprzatanie dla wyjsc przed petla renderu (bledy, --build-lod-scene) - watki kompilatora shaderow
+    // i puli zadan musza byc dolaczone, zanim ich obiekty zostana zniszczone
+    auto shutdownEarly = [&](int result) {
+        shutdownShaderLibrary(shaderLibrary);
+        shutdownTextureManager();
+        closeVirtualTexture(virtualTexture);
+        closeLodScene(lodScene);
+        releaseSceneGraph(sceneGraph);
+        glfwTerminate();
+        unmountAssetPacks();
+        shutdownJobSystem();
+        return result;
+    };
+
+    // statyczne poddrzewa wypiekane w paczki przy starcie, --no-static-batching: wszystko przez drawNode
+    // (wtedy glTF moze isc do GL bez kopii CPU)
+    bool staticBatching = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--no-static-batching")
+            staticBatching = false;
+    }
 
-    if (!loadModel("E:/projektyCpp/Projekt_obiektowka/x64/Debug/model/result.gltf")) return -1;
+    // --build-lod-scene plik.lod: hierarchia kafli z modeli (kazde --model po kolei, albo sceny --stress) i wyjscie;
+    // --lod-leaf N: najwiecej trojkatow w lisciu
+    std::string lodBuildPath;
+    LodBuildConfig lodBuildConfig;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--build-lod-scene")
+            lodBuildPath = argv[i + 1];
+        if (std::string(argv[i]) == "--lod-leaf")
+            lodBuildConfig.leafTriangles = (uint32_t)std::atoi(argv[i + 1]);
+    }
+
+    // --stress N ...: wygenerowana scena testowa zamiast modelu, --model plik: inny model
+    StressSceneConfig stressConfig;
+    bool stressScene = parseStressSceneArguments(argc, argv, stressConfig);
+    std::vector<std::string> modelPaths;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--model")
+            modelPaths.push_back(argv[i + 1]);
+    }
+    if (modelPaths.empty())
+        modelPaths.push_back("E:/projektyCpp/Projekt_obiektowka/x64/Debug/model/result.gltf");
+    if (!lodBuildPath.empty()) {
+        // model po modelu - w pamieci tylko biezacy graf, trojkaty dopisywane do plikow tymczasowych
+        LodBuildInput lodInput;
+        bool built = beginLodBuild(lodInput, lodBuildPath);
+        if (stressScene) {
+            generateStressScene(stressConfig, sceneGraph);
+            built = built && addLodBuildGeometry(lodInput, sceneGraph, meshes);
+            releaseSceneGraph(sceneGraph);
+        }
+        for (size_t i = 0; built && !stressScene && i < modelPaths.size(); ++i) {
+            built = loadModel(modelPaths[i], true) && addLodBuildGeometry(lodInput, sceneGraph, meshes);
+            releaseSceneGraph(sceneGraph);
+        }
+        size_t triangles = lodInput.indexCount / 3;
+        if (built)
+            built = finishLodBuild(lodInput, lodBuildConfig);
+        else
+            abortLodBuild(lodInput);
+        if (built)
+            std::cout << "LOD scene: " << triangles << " triangles -> " << lodBuildPath << std::endl;
+        return shutdownEarly(built ? 0 : -1);
+    }
+
+    if (stressScene) {
+        generateStressScene(stressConfig, sceneGraph);
+        std::cout << "Stress scene: " << stressConfig.drones << " drones, " << stressNodeCount(stressConfig) << " nodes, "
+            << stressConfig.meshCount << " meshes x "
+            << (sceneGraph.meshIndices.empty() ? 0 : meshes[sceneGraph.meshIndices[0]].indices.size() / 3) << " triangles" << std::endl;
+    } else {
+        if (!loadModel(modelPaths.back(), staticBatching))
+            return shutdownEarly(-1);
+        printMeshRegistryReport();
+    }
+
+    StaticBatches staticBatches;
+    if (staticBatching) {
+        buildStaticBatches(sceneGraph, staticBatches, StaticBatchConfig());
+        std::cout << "Static batching: " << staticBatches.sourceDraws << " draws -> " << staticBatches.meshes.size()
+            << " batches, " << sceneGraph.nodes.size() << " nodes left" << std::endl;
+    }
+    // wariant z tekstura tylko, gdy cokolwiek ja ma - inaczej zbedne UV i probkowanie bialej 1x1
+    bool texturedScene = false;
+    for (const Mesh& mesh : meshes)
+        texturedScene = texturedScene || (mesh.references && mesh.texture != NO_TEXTURE);
+    for (const Mesh& batch : staticBatches.meshes)
+        texturedScene = texturedScene || batch.texture != NO_TEXTURE;
+    // powtorzone siatki w reszcie grafu jako instancje, --no-instancing: osobne rysowanie na kazda
+    bool instancing = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--no-instancing")
+            instancing = false;
+    }
+
+    // --shader-cache katalog (domyslnie shader_cache), --no-shader-cache: zawsze kompilacja ze zrodel
+    std::string shaderCacheDirectory = "shader_cache";
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--shader-cache" && i + 1 < argc)
+            shaderCacheDirectory = argv[i + 1];
+        if (std::string(argv[i]) == "--no-shader-cache")
+            shaderCacheDirectory.clear();
+    }
+    setShaderCacheDirectory(shaderCacheDirectory);
 
-    Shader shader(vertexShaderSource, fragmentShaderSource);
+    // --shaders katalog: vertex.glsl + fragment.glsl, warianty z #define kompilowane na zadanie
+    std::string shaderDirectory = "../shaders";
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--shaders")
+            shaderDirectory = argv[i + 1];
+    }
+    if (!loadShaderLibrary(shaderLibrary, shaderDirectory))
+        return shutdownEarly(-1);
+    startShaderCompiler(shaderLibrary, window);
+    // podstawowy wariant przy starcie (blokujaco), pozostale w tle - do tego czasu rysuje podstawowy
+    const Shader* baseShader = waitShaderVariant(shaderLibrary, 0);
+    if (!baseShader)
+        return shutdownEarly(-1);
+    printShaderCacheReport();
     glEnable(GL_DEPTH_TEST);
 
+    // symulacja na osobnym watku, render czyta zawsze najnowszy pelny stan
+    SimState simState;
+    initSimulation(simState, 1);
+    TripleBuffer<RenderSnapshot> snapshots;
+    buildSnapshot(simState, snapshots.writeBuffer());
+    snapshots.publish();
+
+    // --record plik [--record-compress]: telemetria wszystkich dronow z pelna czestotliwoscia fizyki
+    TelemetryRecorder recorder;
+    TelemetryRecorder* activeRecorder = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--record") {
+            bool compress = false;
+            for (int j = 1; j < argc; ++j)
+                compress = compress || std::string(argv[j]) == "--record-compress";
+            if (openTelemetryRecorder(recorder, argv[i + 1], compress))
+                activeRecorder = &recorder;
+        }
+    }
+
+    // --record-replay plik: klatki kluczowe co sekunde + komendy, --replay plik: odtworzenie zamiast symulacji
+    ReplayRecorder replayRecorder;
+    ReplayRecorder* activeReplayRecorder = nullptr;
+    ReplayPlayer replayPlayer;
+    bool replaying = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--record-replay" && openReplayRecorder(replayRecorder, argv[i + 1], simState, PHYSICS_RATE))
+            activeReplayRecorder = &replayRecorder;
+        if (std::string(argv[i]) == "--replay")
+            replaying = openReplayPlayer(replayPlayer, argv[i + 1]);
+    }
+
+    std::thread simThread = replaying
+        ? std::thread(runReplayThread, std::ref(replayPlayer), std::ref(snapshots), std::ref(simControl))
+        : std::thread(runSimulationThread, std::ref(simState), std::ref(snapshots), std::ref(simControl),
+            activeRecorder, activeReplayRecorder);
+
+    // czasy GPU przebiegow: nakladka + tytul okna, --gpu-csv plik: kazda probka do CSV
+    std::string gpuCsvPath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--gpu-csv")
+            gpuCsvPath = argv[i + 1];
+    }
+    GpuTimers gpuTimers;
+    initGpuTimers(gpuTimers, gpuCsvPath);
+    unsigned int framePass = addGpuPass(gpuTimers, "frame");
+    unsigned int feedbackPass = addGpuPass(gpuTimers, "vtFeedback");
+    unsigned int scenePass = addGpuPass(gpuTimers, "drawNode");
+    unsigned int overlayPass = addGpuPass(gpuTimers, "overlay");
+    double lastTitleUpdate = 0.0;
+
+    // --alloc-check: raport alokacji + bledy za alokacje w stanie ustalonym, --alloc-strict: abort przy pierwszej
+    bool allocCheck = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--alloc-check")
+            allocCheck = true;
+        if (std::string(argv[i]) == "--alloc-strict") {
+            allocCheck = true;
+            setAllocStrict(true);
+        }
+    }
+    unsigned int reportedAllocFrames = 0;
+    uint64_t lastFrameSamples = 0;
+    unsigned int flythroughFrame = 0;
+    auto lastFrameEnd = std::chrono::steady_clock::now();
+    double lastCameraTime = glfwGetTime();
+
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_SCOPE("frame");
+        auto frameStart = std::chrono::steady_clock::now();
         glfwPollEvents();
+        ALLOC_STEADY_SCOPE("render");
+        beginGpuPass(gpuTimers, framePass);
         glClearColor(0.4f, 0.2f, 0.6f, 0.5f);
+        // proporcje i viewport z biezacego rozmiaru okna (zmiana rozmiaru nie rozciaga obrazu)
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        float camX = radius * cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-        float camY = radius * sin(glm::radians(pitch));
-        float camZ = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-        glm::vec3 cameraPos = glm::vec3(camX, camY, camZ);
+        snapshots.update();
+        const RenderSnapshot& snapshot = snapshots.readBuffer();
+
+        double cameraTime = glfwGetTime();
+        float cameraDelta = (float)(cameraTime - lastCameraTime);
+        lastCameraTime = cameraTime;
+        glm::vec3 direction = orbitDirection();
+        glm::vec3 cameraPos = radius * direction;
+        glm::vec3 cameraTarget(0.0f);
+        if (flyCamera) {
+            flyPosition += flyMovement(window, -direction) * flySpeed * cameraDelta;
+            cameraPos = flyPosition;
+            cameraTarget = flyPosition - direction;
+        }
+        if (flythroughMode)
+            flythroughCamera(flythrough, flythroughFrame, cameraPos, cameraTarget);
+
+        glm::mat4 view = glm::lookAt(cameraPos, cameraTarget, glm::vec3(0.0, 1.0, 0.0));
+        float nearPlane, farPlane;
+        cameraDepthRange(sceneSpheres, snapshot.droneTransforms, cameraPos, nearPlane, farPlane);
+        float aspect = framebufferHeight > 0 ? (float)framebufferWidth / framebufferHeight : 1.0f;
+        glm::mat4 projection = glm::perspective(CAMERA_FOV_Y, aspect, nearPlane, farPlane);
 
-        glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.f / 600.f, 0.1f, 100.0f);
+        updateShaderLibrary(shaderLibrary);
+        updateTextures();
+        uint32_t shaderFeatures = 0;
+        if (lightingEnabled)
+            shaderFeatures |= SHADER_LIGHTING;
+        if (texturedScene)
+            shaderFeatures |= SHADER_TEXTURED;
+        const Shader* shader = requestShaderVariant(shaderLibrary, shaderFeatures);
+        if (!shader) {
+            shader = baseShader;
+            shaderFeatures = 0;
+        }
+        // bez oswietlenia normalne sa zbedne - VAO tylko ze strumieniem pozycji
+        MeshLayout meshLayout = (shaderFeatures & SHADER_TEXTURED) ? LAYOUT_TEXTURED
+            : ((shaderFeatures & SHADER_LIGHTING) ? LAYOUT_SHADED : LAYOUT_POSITION_ONLY);
+        // wariant z macierza jako atrybutem - dopoki sie kompiluje, graf idzie zwyklym drawNode
+        const Shader* instancedShader = instancing
+            ? requestShaderVariant(shaderLibrary, shaderFeatures | SHADER_INSTANCING) : nullptr;
 
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
+        // ziemia z wirtualna tekstura: feedback w malej rozdzielczosci, odbior wczesniejszych odczytow, kafle do atlasu
+        const Shader* groundShader = nullptr;
+        if (virtualTextureEnabled) {
+            const Shader* feedbackShader = requestShaderVariant(shaderLibrary, SHADER_VIRTUAL_TEXTURE | SHADER_VT_FEEDBACK);
+            if (feedbackShader) {
+                beginGpuPass(gpuTimers, feedbackPass);
+                beginVirtualTextureFeedback(virtualTexture, framebufferWidth, framebufferHeight);
+                feedbackShader->use();
+                feedbackShader->setMat4("view", view);
+                feedbackShader->setMat4("projection", projection);
+                drawVirtualTextureGround(virtualTexture, feedbackShader->ID, true);
+                endVirtualTextureFeedback(virtualTexture);
+                endGpuPass(gpuTimers, feedbackPass);
+            }
+            updateVirtualTexture(virtualTexture);
+            groundShader = requestShaderVariant(shaderLibrary, (shaderFeatures & SHADER_LIGHTING) | SHADER_VIRTUAL_TEXTURE);
+        }
+        // miasto: wybor kafli z tej kamery, zadania wczytania w tle, upload w limicie bajtow na klatke
+        if (lodSceneEnabled) {
+            selectLodTiles(lodScene, cameraPos, projection * view, (float)framebufferHeight, CAMERA_FOV_Y);
+            uploadLodTiles(lodScene);
+        }
 
-        drawNode(rootNode, glm::mat4(1.0f), shader.ID);
+        beginGpuPass(gpuTimers, scenePass);
+        if (instancedShader) {
+            instancedShader->use();
+            instancedShader->setMat4("view", view);
+            instancedShader->setMat4("projection", projection);
+            drawNodeInstanced(sceneGraph, 0, snapshot.droneTransforms.data(), snapshot.droneTransforms.size(), meshLayout);
+        }
+        shader->use();
+        shader->setMat4("view", view);
+        shader->setMat4("projection", projection);
+        for (const glm::mat4& droneTransform : snapshot.droneTransforms) {
+            if (!instancedShader)
+                drawNode(sceneGraph, 0, droneTransform, shader->ID, meshLayout);
+            drawStaticBatches(staticBatches, droneTransform, projection * view, shader->ID, meshLayout);
+        }
+        if (lodSceneEnabled)
+            drawLodScene(lodScene, shader->ID, meshLayout);
+        if (groundShader) {
+            groundShader->use();
+            groundShader->setMat4("view", view);
+            groundShader->setMat4("projection", projection);
+            drawVirtualTextureGround(virtualTexture, groundShader->ID, false);
+        }
+        endGpuPass(gpuTimers, scenePass);
 
-        glfwSwapBuffers(window);
+        if (showGpuOverlay) {
+            beginGpuPass(gpuTimers, overlayPass);
+            drawGpuOverlay(gpuTimers, framebufferWidth, framebufferHeight);
+            endGpuPass(gpuTimers, overlayPass);
+        }
+        endGpuPass(gpuTimers, framePass);
+        endGpuFrame(gpuTimers);
+
+        if (glfwGetTime() - lastTitleUpdate > 0.5) {
+            ALLOC_SCOPE("window title");
+            lastTitleUpdate = glfwGetTime();
+            glfwSetWindowTitle(window, ("Dron | " + gpuTimersSummary(gpuTimers)).c_str());
+        }
+
+        auto cpuEnd = std::chrono::steady_clock::now();
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+
+        if (flythroughMode) {
+            // czas klatki = od konca poprzedniej wymiany buforow, CPU = praca przed glfwSwapBuffers
+            auto frameEnd = std::chrono::steady_clock::now();
+            recordFlythroughFrame(flythrough, std::chrono::duration<float, std::milli>(cpuEnd - frameStart).count(),
+                std::chrono::duration<float, std::milli>(frameEnd - lastFrameEnd).count());
+            lastFrameEnd = frameEnd;
+            const GpuPass& gpuFrame = gpuTimers.passes[framePass];
+            if (gpuFrame.sampleCount != lastFrameSamples) {
+                lastFrameSamples = gpuFrame.sampleCount;
+                recordFlythroughGpu(flythrough, gpuFrame.lastMs);
+            }
+            if (++flythroughFrame == flythroughConfig.frames)
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+
+        // dane tymczasowe tej klatki zyja jeszcze przez nastepna, potem ich bufor jest uzywany ponownie
+        advanceFrameArenas();
+
+        AllocFrameStats allocStats = endAllocFrame();
+        if (allocCheck) {
+            ALLOC_SCOPE("alloc report");
+            if (allocStats.frame + 1 == ALLOC_WARMUP_FRAMES)
+                setAllocSteadyState(true);
+            if (allocStats.violations && reportedAllocFrames++ < ALLOC_REPORTED_FRAMES) {
+                std::cerr << "ERROR::ALLOC::STEADY_STATE_ALLOCATION frame " << allocStats.frame << ": "
+                    << allocStats.violations << " of " << allocStats.count << " allocations (" << allocStats.bytes << " bytes)" << std::endl;
+            }
+        }
+    }
+    if (allocCheck) {
+        setAllocSteadyState(false);
+        printAllocReport(20);
     }
+    shutdownGpuTimers(gpuTimers);
+    shutdownShaderLibrary(shaderLibrary);
+    printTextureReport();
+    shutdownTextureManager();
+    printVirtualTextureReport(virtualTexture);
+    closeVirtualTexture(virtualTexture);
+    printLodSceneReport(lodScene);
+    closeLodScene(lodScene);
+
+    simControl.running = false;
+    simThread.join();
+    if (activeRecorder)
+        closeTelemetryRecorder(recorder);
+    if (activeReplayRecorder)
+        closeReplayRecorder(replayRecorder);
+    if (replaying)
+        closeReplayPlayer(replayPlayer);
 
+    releaseSceneGraph(sceneGraph);
     glfwTerminate();
-    return 0;
+    unmountAssetPacks();
+    shutdownJobSystem();
+    if (!tracePath.empty())
+        writeChromeTrace(tracePath);
+    return flythroughMode ? finishFlythrough(flythrough) : 0;
 }
@@ -0,0 +1,69 @@
+#version 330 core
+#if defined(FEEDBACK)
+out uvec4 feedback;  // strona na wybranym poziomie (x, y), poziom, 1 - tlo zostaje (0, 0, 0, 0)
+#elif !defined(DEPTH_ONLY)
+out vec4 FragColor;
+#endif
+
+#ifdef LIGHTING
+in vec3 worldNormal;
+const vec3 lightDirection = vec3(0.3, 1.0, 0.5);
+#endif
+
+#if defined(TEXTURED) || defined(VIRTUAL_TEXTURE)
+in vec2 texCoord;
+#endif
+#ifdef TEXTURED
+uniform sampler2D baseColorTexture;  // jednostka 0
+#endif
+
+#ifdef VIRTUAL_TEXTURE
+uniform sampler2D vtAtlas;         // jednostka 1: kafle z ramka
+uniform usampler2D vtIndirection;  // jednostka 2: mip = poziom piramidy, teksel na strone -> (slot x, slot y, poziom, 1)
+uniform vec4 vtPages;              // strony poziomu 0 (potega 2) x i y, liczba poziomow, przesuniecie mipa
+uniform vec3 vtAtlasLayout;        // bok kafla, ramka, bok atlasu w pikselach
+
+// poziom jak przy zwyklym mipmapowaniu - z pochodnych wspolrzednych w pikselach poziomu 0
+int virtualLevel() {
+    vec2 texel = texCoord * vtPages.xy * vtAtlasLayout.x;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    float mip = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + vtPages.w;
+    return int(clamp(floor(mip + 0.5), 0.0, vtPages.z - 1.0));
+}
+
+ivec2 virtualPage() {
+    return min(ivec2(texCoord * vtPages.xy), ivec2(vtPages.xy) - 1);
+}
+
+vec4 sampleVirtualTexture() {
+    int level = virtualLevel();
+    uvec4 entry = texelFetch(vtIndirection, virtualPage() >> level, level);
+    // wpis moze wskazywac grubszy kafel (drobniejszy jeszcze sie wczytuje) - polozenie w tym kaflu
+    vec2 inTile = fract(texCoord * vtPages.xy / exp2(float(entry.z)));
+    vec2 pixel = vec2(entry.xy) * (vtAtlasLayout.x + 2.0 * vtAtlasLayout.y) + vtAtlasLayout.y + inTile * vtAtlasLayout.x;
+    return texture(vtAtlas, pixel / vtAtlasLayout.z);
+}
+#endif
+
+void main() {
+#if defined(FEEDBACK)
+    int level = virtualLevel();
+    feedback = uvec4(uvec2(virtualPage() >> level), uint(level), 1u);
+#elif defined(DEPTH_ONLY)
+    // tylko glebokosc
+#else
+#if defined(VIRTUAL_TEXTURE)
+    vec4 baseColor = sampleVirtualTexture();
+#elif defined(TEXTURED)
+    vec4 baseColor = texture(baseColorTexture, texCoord);
+#else
+    vec4 baseColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
+#ifdef LIGHTING
+    float diffuse = max(dot(normalize(worldNormal), normalize(lightDirection)), 0.0);
+    FragColor = vec4(baseColor.rgb * (0.25 + 0.75 * diffuse), baseColor.a);
+#else
+    FragColor = baseColor;
+#endif
+#endif
+}
@@ -0,0 +1,34 @@
+#version 330 core
+// warianty: LIGHTING, INSTANCING, DEPTH_ONLY, TEXTURED, VIRTUAL_TEXTURE, FEEDBACK (#define wstawiane przez ShaderLibrary)
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+#if defined(TEXTURED) || defined(VIRTUAL_TEXTURE)
+layout (location = 2) in vec2 aTexCoord;
+out vec2 texCoord;
+#endif
+#ifdef INSTANCING
+layout (location = 3) in mat4 aModel;
+#else
+uniform mat4 model;
+#endif
+uniform mat4 view;
+uniform mat4 projection;
+
+#ifdef LIGHTING
+out vec3 worldNormal;
+#endif
+
+void main() {
+#ifdef INSTANCING
+    mat4 modelMatrix = aModel;
+#else
+    mat4 modelMatrix = model;
+#endif
+    gl_Position = projection * view * modelMatrix * vec4(aPos, 1.0);
+#ifdef LIGHTING
+    worldNormal = mat3(modelMatrix) * aNormal;
+#endif
+#if defined(TEXTURED) || defined(VIRTUAL_TEXTURE)
+    texCoord = aTexCoord;
+#endif
+}